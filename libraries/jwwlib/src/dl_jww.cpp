@@ -130,6 +130,30 @@ static double Deg(double ang)
 /**
  * Default constructor.
  */
+namespace {
+/**
+ * Creates the entities while JWWDocument reads them, without keeping
+ * the records of the whole file.
+ */
+class JwwEntityReader: public JWWReader {
+public:
+	JwwEntityReader(DL_Jww& jww, DL_CreationInterface* creationInterface)
+		: jww(jww), creationInterface(creationInterface) {}
+
+	void ReadSen(CDataSen& DSen) { jww.CreateSen(creationInterface, DSen); }
+	void ReadEnko(CDataEnko& DEnko) { jww.CreateEnko(creationInterface, DEnko); }
+	void ReadTen(CDataTen& DTen) { jww.CreateTen(creationInterface, DTen); }
+	void ReadMoji(CDataMoji& DMoji) { jww.CreateMoji(creationInterface, DMoji); }
+	void ReadSolid(CDataSolid& DSolid) { jww.CreateSolid(creationInterface, DSolid); }
+	void ReadSunpou(CDataSunpou& DSunpou) { jww.CreateSunpou(creationInterface, DSunpou); }
+	void ReadBlock(CDataBlock& DBlock) { jww.CreateBlock(creationInterface, DBlock); }
+
+private:
+	DL_Jww& jww;
+	DL_CreationInterface* creationInterface;
+};
+}
+
 DL_Jww::DL_Jww() {
 }
 
@@ -141,20 +165,33 @@ DL_Jww::DL_Jww() {
 DL_Jww::~DL_Jww() {
 }
 
+/**
+ * Adds the layer m_nGLayer-m_nLayer of an entity, once per import.
+ */
+void DL_Jww::CreateLayer(DL_CreationInterface* creationInterface, WORD gLayer, WORD layer)
+{
+	if(gLayer > ArraySize(HEX)-1)
+		gLayer = ArraySize(HEX)-1;
+	if(layer > ArraySize(HEX)-1)
+		layer = ArraySize(HEX)-1;
+	if(layerCreated[gLayer][layer])
+		return;
+	layerCreated[gLayer][layer] = true;
+	creationInterface->addLayer(DL_LayerData(HEX[gLayer] + "-" + HEX[layer], 0));
+}
+
 void DL_Jww::CreateSen(DL_CreationInterface* creationInterface, CDataSen& DSen)
 {
-	string lName = HEX[DSen.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DSen.m_nGLayer] + "-" +
-													HEX[DSen.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DSen.m_nLayer];
 	// add layer
-	creationInterface->addLayer(DL_LayerData(lName,0));
-//#ifdef	DEBUG
+	CreateLayer(creationInterface, DSen.m_nGLayer, DSen.m_nLayer);
+#ifdef	DEBUG
 if(DSen.m_nPenStyle > ArraySize(lTable)-1)
 	std::cout << "線種番号 " << (WORD)DSen.m_nPenStyle << std::endl;   //線種番号
 if(DSen.m_nPenColor > ArraySize(colTable)-1)
 	std::cout << "線色番号 " << (WORD)DSen.m_nPenColor << std::endl;   //線色番号
 if(DSen.m_nPenWidth > 26)
 	std::cout << "線色幅 " << (WORD)DSen.m_nPenWidth << std::endl;//線色幅
-//#endif
+#endif
 	int width;
 	if(DSen.m_nPenWidth > 26)
 		width = 0;
@@ -233,11 +270,8 @@ std::cout << "線色幅 " << (WORD)DSen.m_nPenWidth << std::endl;//線色幅
 
 void DL_Jww::CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnko)
 {
-	string lName = HEX[DEnko.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DEnko.m_nGLayer] + "-" +
-													HEX[DEnko.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DEnko.m_nLayer];
-
 	// add layer
-	creationInterface->addLayer(DL_LayerData(lName,0));
+	CreateLayer(creationInterface, DEnko.m_nGLayer, DEnko.m_nLayer);
 
 	int width;
 	if(DEnko.m_nPenWidth > 26)
@@ -428,11 +462,8 @@ std::cout << lName.ascii() << std::endl;
 
 void DL_Jww::CreateTen(DL_CreationInterface* creationInterface, CDataTen& DTen)
 {
-	string lName = HEX[DTen.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DTen.m_nGLayer] + "-" +
-													HEX[DTen.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DTen.m_nLayer];
-
 	// add layer
-	creationInterface->addLayer(DL_LayerData(lName,0));
+	CreateLayer(creationInterface, DTen.m_nGLayer, DTen.m_nLayer);
 	int width;
 	if(DTen.m_nPenWidth > 26)
 		width = 0;
@@ -480,11 +511,8 @@ std::cout << *point;
 
 void DL_Jww::CreateMoji(DL_CreationInterface* creationInterface, CDataMoji& DMoji)
 {
-	string lName = HEX[DMoji.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DMoji.m_nGLayer] + "-" +
-													HEX[DMoji.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DMoji.m_nLayer];
-
 	// add layer
-	creationInterface->addLayer(DL_LayerData(lName,0));
+	CreateLayer(creationInterface, DMoji.m_nGLayer, DMoji.m_nLayer);
 
 	int width;
 	if(DMoji.m_nPenWidth > 26)
@@ -616,11 +644,8 @@ void DL_Jww::CreateSolid(DL_CreationInterface* /*creationInterface*/, CDataSolid
 
 void DL_Jww::CreateSunpou(DL_CreationInterface* creationInterface, CDataSunpou& DSunpou)
 {
-	string lName = HEX[DSunpou.m_nGLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DSunpou.m_nGLayer] + "-" +
-													HEX[DSunpou.m_nLayer > ArraySize(HEX)-1 ? ArraySize(HEX)-1: DSunpou.m_nLayer];
-
 	// add layer
-	creationInterface->addLayer(DL_LayerData(lName,0));
+	CreateLayer(creationInterface, DSunpou.m_nGLayer, DSunpou.m_nLayer);
 	int width;
 	if(DSunpou.m_nPenWidth > 26)
 		width = 0;
@@ -705,35 +730,17 @@ bool DL_Jww::in(const string& file, DL_CreationInterface* creationInterface) {
 	//JWWファイル読み取り
 	string ofile("");
 	JWWDocument* jwdoc = new JWWDocument((std::string&)file, ofile);
-	if(!jwdoc->Read())
-		return false;
 	//DXF変数設定
 	creationInterface->setVariableString("$DWGCODEPAGE", "SJIS", 7);
 	creationInterface->setVariableString("$TEXTSTYLE", "japanese", 7);
-	//線分データ
-	for( unsigned int i = 0; i < jwdoc->vSen.size(); i++ )
-		CreateSen(creationInterface, jwdoc->vSen[i]);
-	//円弧データ
-	for( unsigned int i = 0; i < jwdoc->vEnko.size(); i++ )
-		CreateEnko(creationInterface, jwdoc->vEnko[i]);
-	//点データ
-	for( unsigned int i = 0; i < jwdoc->vTen.size(); i++ )
-		CreateTen(creationInterface, jwdoc->vTen[i]);
-	//文字データ
-	for( unsigned int i = 0; i < jwdoc->vMoji.size(); i++ )
-		CreateMoji(creationInterface, jwdoc->vMoji[i]);
-	//寸法
-    for(unsigned int i=0 ; i < jwdoc->vSunpou.size(); i++ )
-		CreateSunpou(creationInterface, jwdoc->vSunpou[i]);
-	//ソリッド
-    for(unsigned int i=0 ; i < jwdoc->vSolid.size(); i++ )
-		CreateSolid(creationInterface, jwdoc->vSolid[i]);
-	//部品
-    for(unsigned int i=0 ; i < jwdoc->vBlock.size(); i++)
-		CreateBlock(creationInterface, jwdoc->vBlock[i]);
+	memset(layerCreated, 0, sizeof(layerCreated));
+	//図形は読み込み中に作成する
+	JwwEntityReader reader(*this, creationInterface);
+	jwdoc->pReader = &reader;
+	bool ret = jwdoc->Read();
 	delete jwdoc;
 
-	return true;
+	return ret;
 }
 
 /**
@@ -339,6 +339,7 @@ public:
 
 	int getLibVersion(const char* str);
 
+	void CreateLayer(DL_CreationInterface* creationInterface, WORD gLayer, WORD layer);
 	void CreateSen(DL_CreationInterface* creationInterface, CDataSen& DSen);
 	void CreateEnko(DL_CreationInterface* creationInterface, CDataEnko& DEnko);
 	void CreateTen(DL_CreationInterface* creationInterface, CDataTen& DTen);
@@ -400,6 +401,8 @@ private:
     bool firstCall;
     // Attributes of the current entity (layer, color, width, line type)
     DL_Attributes attrib;
+    // Layers m_nGLayer-m_nLayer added in the current import
+    bool layerCreated[16][16];
 	// library version. hex: 0x20003001 = 2.0.3.1
 	int libVersion;
 };
@@ -1178,7 +1178,10 @@ cout << DSen;
                 ListCount++;
             } else
             {
-                vSen.push_back(DSen);
+                if( pReader )
+                    pReader->ReadSen(DSen);
+                else
+                    vSen.push_back(DSen);
                 SenCount++;
             }
         }
@@ -1195,7 +1198,10 @@ cout << DEnko;
             }
             else
             {
-                vEnko.push_back(DEnko);
+                if( pReader )
+                    pReader->ReadEnko(DEnko);
+                else
+                    vEnko.push_back(DEnko);
                 EnkoCount++;
             }
         }
@@ -1211,7 +1217,10 @@ cout << DTen;
                 ListCount++;
             } else
             {
-                vTen.push_back(DTen);
+                if( pReader )
+                    pReader->ReadTen(DTen);
+                else
+                    vTen.push_back(DTen);
                 TenCount++;
             }
         }
@@ -1227,7 +1236,10 @@ cout << DMoji;
                 ListCount++;
             } else
             {
-                vMoji.push_back(DMoji);
+                if( pReader )
+                    pReader->ReadMoji(DMoji);
+                else
+                    vMoji.push_back(DMoji);
                 MojiCount++;
             }
         }
@@ -1243,7 +1255,10 @@ cout << DSolid;
                 ListCount++;
             } else
             {
-                vSolid.push_back(DSolid);
+                if( pReader )
+                    pReader->ReadSolid(DSolid);
+                else
+                    vSolid.push_back(DSolid);
                 SolidCount++;
             }
         }
@@ -1259,7 +1274,10 @@ cout << DBlock;
                 ListCount++;
             } else
             {
-                vBlock.push_back(DBlock);
+                if( pReader )
+                    pReader->ReadBlock(DBlock);
+                else
+                    vBlock.push_back(DBlock);
                 BlockCount++;
             }
         }
@@ -1275,7 +1293,10 @@ cout << DSunpou;
                 ListCount++;
             } else
             {
-                vSunpou.push_back(DSunpou);
+                if( pReader )
+                    pReader->ReadSunpou(DSunpou);
+                else
+                    vSunpou.push_back(DSunpou);
                 SunpouCount++;
             }
         }
@@ -943,6 +943,22 @@ public:
 	void AddItem(int No,string& str);
 };
 
+//読み込んだ図形を順に受け取るクラス
+//Receives the entities while the file is read, the records are reused
+//for the next entity of the same type
+class	JWWReader
+{
+public:
+	virtual ~JWWReader(){}
+	virtual void ReadSen(CDataSen& DSen) = 0;
+	virtual void ReadEnko(CDataEnko& DEnko) = 0;
+	virtual void ReadTen(CDataTen& DTen) = 0;
+	virtual void ReadMoji(CDataMoji& DMoji) = 0;
+	virtual void ReadSolid(CDataSolid& DSolid) = 0;
+	virtual void ReadSunpou(CDataSunpou& DSunpou) = 0;
+	virtual void ReadBlock(CDataBlock& DBlock) = 0;
+};
+
 //JWWファイル入出力クラス
 class	JWWDocument
 {
@@ -963,6 +979,7 @@ public:
 			ofs = NULL;
 		pList = new JWWList();
 		pBlockList = new JWWBlockList();
+		pReader = NULL;
 	}
 	~JWWDocument(){
 		delete pList;
@@ -1015,6 +1032,9 @@ public:
 	vector<CDataSunpou>	vSunpou;//
 	JWWList*	pList;//
 	JWWBlockList*	pBlockList;//ブロックデータ定義部のリスト
+	//図形を受け取るクラス、NULLの場合はvSen等に格納する
+	//receives the entities while reading instead of vSen etc. if set
+	JWWReader*	pReader;
 	vector<CData*>   m_DataList;    //図形データのリスト
 	vector<CDataList*>	m_DataListList;  //ブロックデータ定義部のリスト
 	void WriteString(string s);
@@ -15,6 +15,9 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <atomic>
+#include <thread>
+#include <vector>
 #include "dwgreader.h"
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
@@ -936,6 +939,10 @@ bool dwgReader::readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf){
     bool ret = true;
     bool ret2 = true;
 
+    //debug output is not thread safe, read sequentially when enabled
+    if (threads > 1 && DRW_DBGGL != DRW_dbg::DEBUG)
+        return readDwgEntitiesParallel(intfa, dbuf);
+
     DRW_DBG("\nobject map total size= "); DRW_DBG(ObjectMap.size());
     std::map<duint32, objHandle>::iterator itB=ObjectMap.begin();
     std::map<duint32, objHandle>::iterator itE=ObjectMap.end();
@@ -949,221 +956,354 @@ bool dwgReader::readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf){
     return ret;
 }
 
+namespace {
+//entity object read from the stream, decoded in a worker thread
+struct dwgEntityJob {
+    objHandle obj;
+    dwgBuffer *buff;
+    duint32 bs;
+    DRW_Entity *ent; //NULL if read sequentially on delivery
+    bool ok;
+};
+}
+
 /**
- * Reads a dwg drawing entity (dwg object entity) given its offset in the file
+ * Reads the entities in batches of the handle map. The objects of a batch
+ * are read from dbuf sequentially, decoded in parallel and sent to the
+ * interface in handle order, like readDwgEntities does one by one.
+ * Polylines need their vertex objects from dbuf and all non entity objects
+ * go to objObjectMap, both are done by readDwgEntity on delivery.
  */
-bool dwgReader::readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa){
+bool dwgReader::readDwgEntitiesParallel(DRW_Interface& intfa, dwgBuffer *dbuf){
     bool ret = true;
-    duint32 bs = 0;
+    const size_t batchSize = 1024 * threads;
+    std::vector<dwgEntityJob> jobs;
+    jobs.reserve(batchSize);
 
-#define ENTRY_PARSE(e) \
-    ret = e.parseDwg(version, &buff, bs); \
-    parseAttribs(&e); \
-    nextEntLink = e.nextEntLink; \
-    prevEntLink = e.prevEntLink;
-
-    nextEntLink = prevEntLink = 0;// set to 0 to skip unimplemented entities
-        dbuf->setPosition(obj.loc);
-        //verify if position is ok:
-        if (!dbuf->isGood()){
-            DRW_DBG(" Warning: readDwgEntity, bad location\n");
-            return false;
-        }
-        int size = dbuf->getModularShort();
-        if (version > DRW::AC1021) {//2010+
-            bs = dbuf->getUModularChar();
+    while (!ObjectMap.empty()){
+        jobs.clear();
+        std::map<duint32, objHandle>::iterator it=ObjectMap.begin();
+        for (; it != ObjectMap.end() && jobs.size() < batchSize; ++it){
+            dwgEntityJob job;
+            job.obj = it->second;
+            job.bs = 0;
+            job.buff = readEntityBuffer(dbuf, job.obj, &job.bs);
+            job.ent = (job.buff == NULL) ? NULL : createEntity(job.obj.type);
+            job.ok = (job.buff != NULL);
+            jobs.push_back(job);
         }
-        duint8 *tmpByteStr = new duint8[size];
-        dbuf->getBytes(tmpByteStr, size);
-        //verify if getBytes is ok:
-        if (!dbuf->isGood()){
-            DRW_DBG(" Warning: readDwgEntity, bad size\n");
-            delete[]tmpByteStr;
-            return false;
+
+        std::atomic<size_t> next(0);
+        auto decode = [this, &jobs, &next](){
+            for (size_t i = next++; i < jobs.size(); i = next++){
+                dwgEntityJob &job = jobs[i];
+                if (job.ent != NULL)
+                    job.ok = parseEntity(job.ent, job.buff, job.bs);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (unsigned int i = 1; i < threads; ++i)
+            workers.push_back(std::thread(decode));
+        decode();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+
+        for (size_t i = 0; i < jobs.size(); ++i){
+            dwgEntityJob &job = jobs[i];
+            std::map<duint32, objHandle>::iterator mit = ObjectMap.find(job.obj.handle);
+            //vertex already read by a polyline of this batch
+            if (mit != ObjectMap.end()){
+                bool ok = job.ok;
+                if (job.ent != NULL){
+                    nextEntLink = job.ent->nextEntLink;
+                    prevEntLink = job.ent->prevEntLink;
+                    sendEntity(job.ent, job.obj.type, intfa);
+                } else if (job.buff != NULL){
+                    ok = readDwgEntity(dbuf, mit->second, intfa);
+                }
+                ObjectMap.erase(mit);
+                if (ret)
+                    ret = ok;
+            }
+            delete job.ent;
+            delete job.buff;
         }
-        dwgBuffer buff(tmpByteStr, size, &decoder);
-        dint16 oType = buff.getObjType(version);
-        buff.resetPosition();
+    }
+    return ret;
+}
+
+/**
+ * Reads the bytes of a dwg object entity given its offset in the file and
+ * sets obj.type, resolving custom classes. Returns NULL on error.
+ */
+dwgBuffer *dwgReader::readEntityBuffer(dwgBuffer *dbuf, objHandle& obj, duint32 *bs){
+    dbuf->setPosition(obj.loc);
+    //verify if position is ok:
+    if (!dbuf->isGood()){
+        DRW_DBG(" Warning: readDwgEntity, bad location\n");
+        return NULL;
+    }
+    int size = dbuf->getModularShort();
+    if (version > DRW::AC1021) {//2010+
+        *bs = dbuf->getUModularChar();
+    }
+    duint8 *tmpByteStr = new duint8[size];
+    dbuf->getBytes(tmpByteStr, size);
+    //verify if getBytes is ok:
+    if (!dbuf->isGood()){
+        DRW_DBG(" Warning: readDwgEntity, bad size\n");
         delete[]tmpByteStr;
+        return NULL;
+    }
+    dwgBuffer *buff = new dwgBuffer(tmpByteStr, size, &decoder);
+    dint16 oType = buff->getObjType(version);
+    buff->resetPosition();
+    delete[]tmpByteStr;
 
-        if (oType > 499){
-            std::map<duint32, DRW_Class*>::iterator it = classesmap.find(oType);
-            if (it == classesmap.end()){//fail, not found in classes set error
-                DRW_DBG("Class "); DRW_DBG(oType);DRW_DBG("not found, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
-                return false;
-            } else {
-                DRW_Class *cl = it->second;
-                if (cl->dwgType != 0)
-                    oType = cl->dwgType;
-            }
+    if (oType > 499){
+        std::map<duint32, DRW_Class*>::iterator it = classesmap.find(oType);
+        if (it == classesmap.end()){//fail, not found in classes set error
+            DRW_DBG("Class "); DRW_DBG(oType);DRW_DBG("not found, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
+            delete buff;
+            return NULL;
+        } else {
+            DRW_Class *cl = it->second;
+            if (cl->dwgType != 0)
+                oType = cl->dwgType;
         }
+    }
 
-        obj.type = oType;
-        switch (oType){
-        case 17: {
-            DRW_Arc e;
-            ENTRY_PARSE(e)
-            intfa.addArc(e);
-            break; }
-        case 18: {
-            DRW_Circle e;
-            ENTRY_PARSE(e)
-            intfa.addCircle(e);
-            break; }
-        case 19:{
-            DRW_Line e;
-            ENTRY_PARSE(e)
-            intfa.addLine(e);
-            break;}
-        case 27: {
-            DRW_Point e;
-            ENTRY_PARSE(e)
-            intfa.addPoint(e);
-            break; }
-        case 35: {
-            DRW_Ellipse e;
-            ENTRY_PARSE(e)
-            intfa.addEllipse(e);
-            break; }
-        case 7:
-        case 8: {//minsert = 8
-            DRW_Insert e;
-            ENTRY_PARSE(e)
-            e.name = findTableName(DRW::BLOCK_RECORD, e.blockRecH.ref);//RLZ: find as block or blockrecord (ps & ps0)
-            intfa.addInsert(e);
-            break; }
-        case 77: {
-            DRW_LWPolyline e;
-            ENTRY_PARSE(e)
-            intfa.addLWPolyline(e);
-            break; }
-        case 1: {
-            DRW_Text e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::STYLE, e.styleH.ref);
-            intfa.addText(e);
-            break; }
-        case 44: {
-            DRW_MText e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::STYLE, e.styleH.ref);
-            intfa.addMText(e);
-            break; }
-        case 28: {
-            DRW_3Dface e;
-            ENTRY_PARSE(e)
-            intfa.add3dFace(e);
-            break; }
-        case 20: {
-            DRW_DimOrdinate e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimOrdinate(&e);
-            break; }
-        case 21: {
-            DRW_DimLinear e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimLinear(&e);
-            break; }
-        case 22: {
-            DRW_DimAligned e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimAlign(&e);
-            break; }
-        case 23: {
-            DRW_DimAngular3p e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimAngular3P(&e);
-            break; }
-        case 24: {
-            DRW_DimAngular e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimAngular(&e);
-            break; }
-        case 25: {
-            DRW_DimRadial e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimRadial(&e);
-            break; }
-        case 26: {
-            DRW_DimDiametric e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addDimDiametric(&e);
-            break; }
-        case 45: {
-            DRW_Leader e;
-            ENTRY_PARSE(e)
-            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-            intfa.addLeader(&e);
-            break; }
-        case 31: {
-            DRW_Solid e;
-            ENTRY_PARSE(e)
-            intfa.addSolid(e);
-            break; }
-        case 78: {
-            DRW_Hatch e;
-            ENTRY_PARSE(e)
-            intfa.addHatch(&e);
-            break; }
-        case 32: {
-            DRW_Trace e;
-            ENTRY_PARSE(e)
-            intfa.addTrace(e);
-            break; }
-        case 34: {
-            DRW_Viewport e;
-            ENTRY_PARSE(e)
-            intfa.addViewport(e);
-            break; }
-        case 36: {
-            DRW_Spline e;
-            ENTRY_PARSE(e)
-            intfa.addSpline(&e);
-            break; }
-        case 40: {
-            DRW_Ray e;
-            ENTRY_PARSE(e)
-            intfa.addRay(e);
-            break; }
-        case 15:    // pline 2D
-        case 16:    // pline 3D
-        case 29: {  // pline PFACE
-            DRW_Polyline e;
-            ENTRY_PARSE(e)
-            readPlineVertex(e, dbuf);
-            intfa.addPolyline(e);
-            break; }
-//        case 30: {
-//            DRW_Polyline e;// MESH (not pline)
-//            ENTRY_PARSE(e)
-//            intfa.addRay(e);
-//            break; }
-        case 41: {
-            DRW_Xline e;
-            ENTRY_PARSE(e)
-            intfa.addXline(e);
-            break; }
-        case 101: {
-            DRW_Image e;
-            ENTRY_PARSE(e)
-            intfa.addImage(&e);
-            break; }
+    obj.type = oType;
+    return buff;
+}
+
+/**
+ * Creates an empty entity of the given dwg type, NULL for objects and
+ * entities not supported. Polylines are not created here, they are read
+ * together with their vertex by readDwgEntity.
+ */
+DRW_Entity *dwgReader::createEntity(duint32 oType){
+    switch (oType){
+    case 17:
+        return new DRW_Arc;
+    case 18:
+        return new DRW_Circle;
+    case 19:
+        return new DRW_Line;
+    case 27:
+        return new DRW_Point;
+    case 35:
+        return new DRW_Ellipse;
+    case 7:
+    case 8: //minsert = 8
+        return new DRW_Insert;
+    case 77:
+        return new DRW_LWPolyline;
+    case 1:
+        return new DRW_Text;
+    case 44:
+        return new DRW_MText;
+    case 28:
+        return new DRW_3Dface;
+    case 20:
+        return new DRW_DimOrdinate;
+    case 21:
+        return new DRW_DimLinear;
+    case 22:
+        return new DRW_DimAligned;
+    case 23:
+        return new DRW_DimAngular3p;
+    case 24:
+        return new DRW_DimAngular;
+    case 25:
+        return new DRW_DimRadial;
+    case 26:
+        return new DRW_DimDiametric;
+    case 45:
+        return new DRW_Leader;
+    case 31:
+        return new DRW_Solid;
+    case 78:
+        return new DRW_Hatch;
+    case 32:
+        return new DRW_Trace;
+    case 34:
+        return new DRW_Viewport;
+    case 36:
+        return new DRW_Spline;
+    case 40:
+        return new DRW_Ray;
+//    case 30:
+//        return new DRW_Polyline;// MESH (not pline)
+    case 41:
+        return new DRW_Xline;
+    case 101:
+        return new DRW_Image;
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * Decodes an entity created by createEntity, only reads the tables,
+ * so it can run in several threads at once.
+ */
+bool dwgReader::parseEntity(DRW_Entity *e, dwgBuffer *buff, duint32 bs){
+    bool ret = e->parseDwg(version, buff, bs);
+    parseAttribs(e);
+    return ret;
+}
 
+/**
+ * Sends a decoded entity of the given dwg type to the interface.
+ */
+void dwgReader::sendEntity(DRW_Entity *e, duint32 oType, DRW_Interface& intfa){
+    switch (oType){
+    case 17:
+        intfa.addArc(*static_cast<DRW_Arc*>(e));
+        break;
+    case 18:
+        intfa.addCircle(*static_cast<DRW_Circle*>(e));
+        break;
+    case 19:
+        intfa.addLine(*static_cast<DRW_Line*>(e));
+        break;
+    case 27:
+        intfa.addPoint(*static_cast<DRW_Point*>(e));
+        break;
+    case 35:
+        intfa.addEllipse(*static_cast<DRW_Ellipse*>(e));
+        break;
+    case 7:
+    case 8: {//minsert = 8
+        DRW_Insert *ins = static_cast<DRW_Insert*>(e);
+        ins->name = findTableName(DRW::BLOCK_RECORD, ins->blockRecH.ref);//RLZ: find as block or blockrecord (ps & ps0)
+        intfa.addInsert(*ins);
+        break; }
+    case 77:
+        intfa.addLWPolyline(*static_cast<DRW_LWPolyline*>(e));
+        break;
+    case 1: {
+        DRW_Text *txt = static_cast<DRW_Text*>(e);
+        txt->style = findTableName(DRW::STYLE, txt->styleH.ref);
+        intfa.addText(*txt);
+        break; }
+    case 44: {
+        DRW_MText *txt = static_cast<DRW_MText*>(e);
+        txt->style = findTableName(DRW::STYLE, txt->styleH.ref);
+        intfa.addMText(*txt);
+        break; }
+    case 28:
+        intfa.add3dFace(*static_cast<DRW_3Dface*>(e));
+        break;
+    case 20:
+    case 21:
+    case 22:
+    case 23:
+    case 24:
+    case 25:
+    case 26: {
+        DRW_Dimension *dim = static_cast<DRW_Dimension*>(e);
+        dim->style = findTableName(DRW::DIMSTYLE, dim->dimStyleH.ref);
+        switch (oType){
+        case 20:
+            intfa.addDimOrdinate(static_cast<DRW_DimOrdinate*>(dim));
+            break;
+        case 21:
+            intfa.addDimLinear(static_cast<DRW_DimLinear*>(dim));
+            break;
+        case 22:
+            intfa.addDimAlign(static_cast<DRW_DimAligned*>(dim));
+            break;
+        case 23:
+            intfa.addDimAngular3P(static_cast<DRW_DimAngular3p*>(dim));
+            break;
+        case 24:
+            intfa.addDimAngular(static_cast<DRW_DimAngular*>(dim));
+            break;
+        case 25:
+            intfa.addDimRadial(static_cast<DRW_DimRadial*>(dim));
+            break;
         default:
+            intfa.addDimDiametric(static_cast<DRW_DimDiametric*>(dim));
+            break;
+        }
+        break; }
+    case 45: {
+        DRW_Leader *leader = static_cast<DRW_Leader*>(e);
+        leader->style = findTableName(DRW::DIMSTYLE, leader->dimStyleH.ref);
+        intfa.addLeader(leader);
+        break; }
+    case 31:
+        intfa.addSolid(*static_cast<DRW_Solid*>(e));
+        break;
+    case 78:
+        intfa.addHatch(static_cast<DRW_Hatch*>(e));
+        break;
+    case 32:
+        intfa.addTrace(*static_cast<DRW_Trace*>(e));
+        break;
+    case 34:
+        intfa.addViewport(*static_cast<DRW_Viewport*>(e));
+        break;
+    case 36:
+        intfa.addSpline(static_cast<DRW_Spline*>(e));
+        break;
+    case 40:
+        intfa.addRay(*static_cast<DRW_Ray*>(e));
+        break;
+    case 41:
+        intfa.addXline(*static_cast<DRW_Xline*>(e));
+        break;
+    case 101:
+        intfa.addImage(static_cast<DRW_Image*>(e));
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Reads a dwg drawing entity (dwg object entity) given its offset in the file
+ */
+bool dwgReader::readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa){
+    bool ret = true;
+    duint32 bs = 0;
+
+    nextEntLink = prevEntLink = 0;// set to 0 to skip unimplemented entities
+    dwgBuffer *buff = readEntityBuffer(dbuf, obj, &bs);
+    if (buff == NULL)
+        return false;
+
+    switch (obj.type){
+    case 15:    // pline 2D
+    case 16:    // pline 3D
+    case 29: {  // pline PFACE
+        DRW_Polyline e;
+        ret = parseEntity(&e, buff, bs);
+        nextEntLink = e.nextEntLink;
+        prevEntLink = e.prevEntLink;
+        readPlineVertex(e, dbuf);
+        intfa.addPolyline(e);
+        break; }
+    default: {
+        DRW_Entity *e = createEntity(obj.type);
+        if (e == NULL){
             //not supported or are object add to remaining map
             objObjectMap[obj.handle]= obj;
             break;
         }
-        if (!ret){
-            DRW_DBG("Warning: Entity type "); DRW_DBG(oType);DRW_DBG("has failed, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
-        }
+        ret = parseEntity(e, buff, bs);
+        nextEntLink = e->nextEntLink;
+        prevEntLink = e->prevEntLink;
+        sendEntity(e, obj.type, intfa);
+        delete e;
+        break; }
+    }
+    delete buff;
+    if (!ret){
+        DRW_DBG("Warning: Entity type "); DRW_DBG(obj.type);DRW_DBG("has failed, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
+    }
     return ret;
 }
 
@@ -130,6 +130,7 @@ public:
 //        ucsCtrl=vportCtrl=appidCtrl=dimstyleCtrl=vpEntHeaderCtrl=0;
         nextEntLink = prevEntLink = 0;
         maintenanceVersion=0;
+        threads = 1;
     }
     virtual ~dwgReader();
 
@@ -159,6 +160,11 @@ protected:
 
     bool readDwgBlocks(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf);
+    bool readDwgEntitiesParallel(DRW_Interface& intfa, dwgBuffer *dbuf);
+    dwgBuffer *readEntityBuffer(dwgBuffer *dbuf, objHandle& obj, duint32 *bs);
+    DRW_Entity *createEntity(duint32 oType);
+    bool parseEntity(DRW_Entity *e, dwgBuffer *buff, duint32 bs);
+    void sendEntity(DRW_Entity *e, duint32 oType, DRW_Interface& intfa);
     bool readDwgObjects(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readPlineVertex(DRW_Polyline& pline, dwgBuffer *dbuf);
 
@@ -179,6 +185,7 @@ public:
 
 protected:
     dwgBuffer *fileBuf;
+    unsigned int threads; //to decode entities, set by dwgR
     dwgR *parent;
     DRW::Version version;
 
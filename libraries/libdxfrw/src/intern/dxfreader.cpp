@@ -11,9 +11,21 @@
 ******************************************************************************/
 
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <locale>
 #include <string>
 #include <sstream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "dxfreader.h"
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
@@ -85,8 +97,13 @@ bool dxfReader::readRec(int *codeData) {
         //break in binary files because the conduct is unpredictable
         return false;
 
-    return (filestr->good());
+    return good();
 }
+
+bool dxfReader::good() {
+    return filestr->good();
+}
+
 int dxfReader::getHandleString(){
     int res;
 #if defined(__APPLE__)
@@ -262,3 +279,263 @@ bool dxfReaderAscii::readBool() {
         return false;
 }
 
+
+namespace {
+//powers of ten exactly representable as double
+const double exactPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+//same result as atoi, without the need of a terminated string
+int parseInt(const char *p, const char *end) {
+    while (p < end && isBlank(*p))
+        ++p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+    long long res = 0;
+    for (; p < end && isDigit(*p); ++p)
+        res = res * 10 + (*p - '0');
+    return static_cast<int>(negative ? -res : res);
+}
+
+//locale independent, used when the fast path can not give the exact result
+double parseDoubleStream(const char *p, const char *end) {
+    std::istringstream sd(std::string(p, end));
+    sd.imbue(std::locale::classic());
+    double res = 0.0;
+    sd >> res;
+    return res;
+}
+
+/**
+ * Parses a decimal floating point number. Mantissas up to 2^53 with
+ * decimal exponents up to 22 are converted exactly with one multiplication
+ * or division, anything else goes through a stream in the classic locale.
+ */
+double parseDouble(const char *begin, const char *end) {
+    const char *p = begin;
+    while (p < end && isBlank(*p))
+        ++p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    unsigned long long mantissa = 0;
+    int digits = 0; //significant digits in mantissa
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; p < end && isDigit(*p); ++p) {
+        hasDigits = true;
+        if (mantissa == 0 && *p == '0')
+            continue;
+        if (++digits > 19)
+            return parseDoubleStream(begin, end);
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && isDigit(*p); ++p) {
+            hasDigits = true;
+            --exponent;
+            if (mantissa == 0 && *p == '0')
+                continue;
+            if (++digits > 19)
+                return parseDoubleStream(begin, end);
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+    }
+    if (!hasDigits)
+        return parseDoubleStream(begin, end);
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExp = (*p++ == '-');
+        if (p == end || !isDigit(*p))
+            return parseDoubleStream(begin, end);
+        int exp = 0;
+        for (; p < end && isDigit(*p); ++p) {
+            if (exp < 10000)
+                exp = exp * 10 + (*p - '0');
+        }
+        exponent += negativeExp ? -exp : exp;
+    }
+    while (p < end && isBlank(*p))
+        ++p;
+    if (p != end)
+        return parseDoubleStream(begin, end);
+
+    double res;
+    if (mantissa == 0)
+        res = 0.0;
+    else if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+        res = exponent < 0 ? mantissa / exactPow10[-exponent]
+                           : mantissa * exactPow10[exponent];
+    else
+        return parseDoubleStream(begin, end);
+    return negative ? -res : res;
+}
+}
+
+dxfReaderAsciiMapped::dxfReaderAsciiMapped(const std::string &fileName):dxfReader(NULL){
+    skip = true;
+    data = dataEnd = pos = NULL;
+    eof = true;
+#ifdef _WIN32
+    mapHandle = NULL;
+    fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0
+            || static_cast<unsigned long long>(size.QuadPart) > static_cast<size_t>(-1))
+        return;
+    mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapHandle == NULL)
+        return;
+    data = static_cast<const char *>(MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0));
+    if (data == NULL)
+        return;
+    dataEnd = data + static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+            || static_cast<unsigned long long>(st.st_size) > static_cast<size_t>(-1)) {
+        close(fd);
+        return;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); //the mapping keeps the file referenced
+    if (map == MAP_FAILED)
+        return;
+#if defined(POSIX_MADV_SEQUENTIAL)
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+#endif
+    data = static_cast<const char *>(map);
+    dataEnd = data + size;
+#endif
+    pos = data;
+    eof = false;
+}
+
+dxfReaderAsciiMapped::~dxfReaderAsciiMapped(){
+#ifdef _WIN32
+    if (data != NULL)
+        UnmapViewOfFile(data);
+    if (mapHandle != NULL)
+        CloseHandle(mapHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle);
+#else
+    if (data != NULL)
+        munmap(const_cast<char *>(data), dataEnd - data);
+#endif
+}
+
+/**
+ * Gets the next line without the line terminator, like std::getline
+ * it returns false (and sets eof) if the end of file is reached before
+ * a new line character.
+ */
+bool dxfReaderAsciiMapped::readLine(const char **lineStart, const char **lineEnd) {
+    if (pos >= dataEnd) {
+        eof = true;
+        *lineStart = *lineEnd = dataEnd;
+        return false;
+    }
+    const char *nl = static_cast<const char *>(memchr(pos, '\n', dataEnd - pos));
+    *lineStart = pos;
+    if (nl == NULL) {
+        *lineEnd = pos = dataEnd;
+        eof = true;
+    } else {
+        *lineEnd = nl;
+        pos = nl + 1;
+    }
+    if (*lineEnd > *lineStart && *(*lineEnd - 1) == '\r')
+        --*lineEnd;
+    return !eof;
+}
+
+bool dxfReaderAsciiMapped::readCode(int *code) {
+    const char *start, *end;
+    readLine(&start, &end);
+    *code = parseInt(start, end);
+    DRW_DBG(*code); DRW_DBG("\n");
+    return good();
+}
+
+bool dxfReaderAsciiMapped::readString(std::string *text) {
+    type = STRING;
+    const char *start, *end;
+    readLine(&start, &end);
+    text->assign(start, end);
+    return good();
+}
+
+bool dxfReaderAsciiMapped::readString() {
+    type = STRING;
+    const char *start, *end;
+    readLine(&start, &end);
+    strData.assign(start, end);
+    DRW_DBG(strData); DRW_DBG("\n");
+    return good();
+}
+
+bool dxfReaderAsciiMapped::readInt16() {
+    type = INT32;
+    const char *start, *end;
+    if (readLine(&start, &end)){
+        intData = parseInt(start, end);
+        DRW_DBG(intData); DRW_DBG("\n");
+        return true;
+    } else
+        return false;
+}
+
+bool dxfReaderAsciiMapped::readInt32() {
+    type = INT32;
+    return readInt16();
+}
+
+bool dxfReaderAsciiMapped::readInt64() {
+    type = INT64;
+    return readInt16();
+}
+
+bool dxfReaderAsciiMapped::readDouble() {
+    type = DOUBLE;
+    const char *start, *end;
+    if (readLine(&start, &end)){
+        doubleData = parseDouble(start, end);
+        DRW_DBG(doubleData); DRW_DBG('\n');
+        return true;
+    } else
+        return false;
+}
+
+//saved as int or add a bool member??
+bool dxfReaderAsciiMapped::readBool() {
+    type = BOOL;
+    const char *start, *end;
+    if (readLine(&start, &end)){
+        intData = parseInt(start, end);
+        DRW_DBG(intData); DRW_DBG("\n");
+        return true;
+    } else
+        return false;
+}
@@ -13,6 +13,7 @@
 #ifndef DXFREADER_H
 #define DXFREADER_H
 
+#include <cstddef>
 #include "drw_textcodec.h"
 
 class dxfReader {
@@ -56,6 +57,7 @@ protected:
     virtual bool readInt64() = 0;
     virtual bool readDouble() = 0;
     virtual bool readBool() = 0;
+    virtual bool good(); //false after EOF or read error
 
 protected:
     std::ifstream *filestr;
@@ -96,4 +98,41 @@ public:
     virtual bool readBool();
 };
 
+/**
+ * Ascii dxf reader working on a memory mapped file. Group codes and
+ * numbers are parsed in place without locale, only string values are
+ * copied. isOpen() is false if the file can not be mapped.
+ */
+class dxfReaderAsciiMapped : public dxfReader {
+public:
+    dxfReaderAsciiMapped(const std::string &fileName);
+    virtual ~dxfReaderAsciiMapped();
+    bool isOpen() {return data != NULL;}
+    virtual bool readCode(int *code);
+    virtual bool readString(std::string *text);
+    virtual bool readString();
+    virtual bool readInt16();
+    virtual bool readDouble();
+    virtual bool readInt32();
+    virtual bool readInt64();
+    virtual bool readBool();
+
+protected:
+    virtual bool good() {return !eof;}
+
+private:
+    dxfReaderAsciiMapped(const dxfReaderAsciiMapped&);
+    dxfReaderAsciiMapped& operator=(const dxfReaderAsciiMapped&);
+    bool readLine(const char **lineStart, const char **lineEnd);
+
+    const char *data;
+    const char *dataEnd;
+    const char *pos; //start of the next line
+    bool eof;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mapHandle;
+#endif
+};
+
 #endif // DXFREADER_H
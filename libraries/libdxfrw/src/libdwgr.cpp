@@ -15,6 +15,7 @@
 #include <fstream>
 #include <algorithm>
 #include <sstream>
+#include <thread>
 #include "intern/drw_dbg.h"
 #include "intern/drw_textcodec.h"
 #include "intern/dwgreader.h"
@@ -43,6 +44,7 @@ dwgR::dwgR(const char* name){
     applyExt = false;
     version = DRW::UNKNOWNV;
     error = DRW::BAD_NONE;
+    threads = 1;
 }
 
 dwgR::~dwgR(){
@@ -61,6 +63,12 @@ void dwgR::setDebug(DRW::DBG_LEVEL lvl){
     }
 }
 
+void dwgR::setThreads(unsigned int n){
+    if (n == 0)
+        n = std::thread::hardware_concurrency();
+    threads = (n == 0) ? 1 : n;
+}
+
 /*reads metadata and loads image preview*/
 bool dwgR::getPreview(){
     bool isOk = false;
@@ -298,6 +306,7 @@ bool dwgR::processDwg() {
         ret = ret2;
     }
 
+    reader->threads = threads;
     ret2 = reader->readDwgEntities(*iface);
     if (ret && !ret2) {
         error = DRW::BAD_READ_ENTITIES;
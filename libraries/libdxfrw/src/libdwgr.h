@@ -33,6 +33,8 @@ public:
     DRW::error getError(){return error;}
 bool testReader();
     void setDebug(DRW::DBG_LEVEL lvl);
+    /** Decodes entities in n threads, 0 uses all cores. Default 1. */
+    void setThreads(unsigned int n);
 
 private:
     bool openFile(std::ifstream *filestr);
@@ -45,6 +47,7 @@ private:
     std::string codePage;
     DRW_Interface *iface;
     dwgReader *reader;
+    unsigned int threads;
 
 };
 
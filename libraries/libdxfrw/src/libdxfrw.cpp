@@ -92,8 +92,15 @@ bool dxfRW::read(DRW_Interface *interface_, bool ext){
         DRW_DBG("dxfRW::read binary file\n");
     } else {
         binFile = false;
-        filestr.open (fileName.c_str(), std::ios_base::in);
-        reader = new dxfReaderAscii(&filestr);
+        dxfReaderAsciiMapped *mapped = new dxfReaderAsciiMapped(fileName);
+        if (mapped->isOpen()) {
+            reader = mapped;
+            DRW_DBG("dxfRW::read memory mapped ascii file\n");
+        } else {
+            delete mapped;
+            filestr.open (fileName.c_str(), std::ios_base::in);
+            reader = new dxfReaderAscii(&filestr);
+        }
     }
 
     isOk = processDxf();
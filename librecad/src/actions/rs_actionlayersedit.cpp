@@ -48,13 +48,8 @@ void RS_ActionLayersEdit::trigger() {
             graphic->editLayer(graphic->getActiveLayer(), *layer);
 
             // update updateable entities on the layer that has changed
-
-			for(auto e: *graphic){
-
-                RS_Layer* l = e->getLayer();
-                if (l && l->getName()==layer->getName()) {
-                    e->update();
-                }
+			for(auto e: graphic->getLayerEntities(graphic->getActiveLayer())){
+                e->update();
             }
         }
     }
@@ -38,6 +38,7 @@
 #include "rs_overlayline.h"
 #include "rs_entitycontainer.h"
 #include "rs_coordinateevent.h"
+#include "lc_trace.h"
 
 /**
   * Disable all snapping.
@@ -142,7 +143,7 @@ RS_Vector RS_Snapper::snapFree(QMouseEvent* e) {
  * @return The coordinates of the point or an invalid vector.
  */
 RS_Vector RS_Snapper::snapPoint(QMouseEvent* e) {
-        RS_DEBUG->print("RS_Snapper::snapPoint");
+    LC_TRACE_SCOPE("snap", "RS_Snapper::snapPoint");
 
     snapSpot = RS_Vector(false);
     RS_Vector t(false);
@@ -412,6 +413,7 @@ RS_Vector RS_Snapper::snapDist(const RS_Vector& coord) {
  * @return The coordinates of the point or an invalid vector.
  */
 RS_Vector RS_Snapper::snapIntersection(const RS_Vector& coord) {
+    LC_TRACE_SCOPE("snap", "RS_Snapper::snapIntersection");
     RS_Vector vec(false);
 
     vec = container->getNearestIntersection(coord,
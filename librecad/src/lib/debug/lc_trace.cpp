@@ -0,0 +1,205 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lc_trace.h"
+
+namespace {
+/** scope events kept for the trace file, older ones are dropped */
+const size_t maximumEvents = 1000000;
+
+struct Event {
+    const char* category;
+    const char* name;
+    long long start;
+    long long duration;
+    int thread;
+    std::string arg;
+};
+
+struct Stats {
+    long long count = 0;
+    long long total = 0;
+    long long maximum = 0;
+};
+
+struct Session {
+    std::mutex mutex;
+    std::string fileName;
+    LC_Trace::Clock::time_point origin;
+    std::vector<Event> events;
+    size_t dropped = 0;
+    /** keyed by category and name */
+    std::map<std::pair<std::string, std::string>, Stats> scopes;
+    std::map<std::pair<std::string, std::string>, long long> counters;
+    std::map<std::thread::id, int> threads;
+
+    int threadIndex() {
+        auto it = threads.find(std::this_thread::get_id());
+        if (it != threads.end()) return it->second;
+        int const i = threads.size();
+        threads[std::this_thread::get_id()] = i;
+        return i;
+    }
+};
+
+Session& session()
+{
+    static Session s;
+    return s;
+}
+
+long long microseconds(LC_Trace::Clock::duration d)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+void writeJsonString(FILE* f, const std::string& s)
+{
+    fputc('"', f);
+    for (unsigned char c: s) {
+        switch (c) {
+        case '"': fputs("\\\"", f); break;
+        case '\\': fputs("\\\\", f); break;
+        default:
+            if (c < 0x20)
+                fprintf(f, "\\u%04x", c);
+            else
+                fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+void writeTraceFile(Session& s)
+{
+    FILE* f = fopen(s.fileName.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "trace: cannot write %s\n", s.fileName.c_str());
+        return;
+    }
+    fputs("{\"traceEvents\":[\n", f);
+    bool first = true;
+    for (Event const& e: s.events) {
+        fputs(first ? "" : ",\n", f);
+        first = false;
+        fputs("{\"name\":", f);
+        writeJsonString(f, e.name);
+        fputs(",\"cat\":", f);
+        writeJsonString(f, e.category);
+        fprintf(f, ",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d",
+                e.start, e.duration, e.thread);
+        if (!e.arg.empty()) {
+            fputs(",\"args\":{\"arg\":", f);
+            writeJsonString(f, e.arg);
+            fputc('}', f);
+        }
+        fputc('}', f);
+    }
+    // counter totals at the end of the session:
+    long long const end = microseconds(LC_Trace::Clock::now() - s.origin);
+    for (auto const& c: s.counters) {
+        fputs(first ? "" : ",\n", f);
+        first = false;
+        fputs("{\"name\":", f);
+        writeJsonString(f, c.first.first + "/" + c.first.second);
+        fprintf(f, ",\"ph\":\"C\",\"ts\":%lld,\"pid\":1,\"tid\":0,"
+                   "\"args\":{\"total\":%lld}}", end, c.second);
+    }
+    fputs("\n]}\n", f);
+    fclose(f);
+}
+}
+
+std::atomic<bool> LC_Trace::enabled(false);
+
+void LC_Trace::enable(const std::string& fileName)
+{
+    Session& s = session();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.fileName = fileName;
+        s.origin = Clock::now();
+    }
+    if (!enabled.exchange(true))
+        std::atexit(&LC_Trace::report);
+}
+
+void LC_Trace::addScope(const char* category, const char* name,
+                        Clock::time_point start, Clock::time_point end,
+                        const std::string& arg)
+{
+    Session& s = session();
+    long long const duration = microseconds(end - start);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    Stats& stats = s.scopes[std::make_pair(std::string(category), std::string(name))];
+    stats.count++;
+    stats.total += duration;
+    stats.maximum = std::max(stats.maximum, duration);
+    if (s.fileName.empty()) return;
+    if (s.events.size() >= maximumEvents) {
+        s.dropped++;
+        return;
+    }
+    s.events.push_back({category, name, microseconds(start - s.origin),
+                        duration, s.threadIndex(), arg});
+}
+
+void LC_Trace::addCount(const char* category, const char* name, long long n)
+{
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.counters[std::make_pair(std::string(category), std::string(name))] += n;
+}
+
+void LC_Trace::report()
+{
+    if (!enabled.exchange(false)) return;
+    Session& s = session();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    fprintf(stderr, "trace summary (ms):\n");
+    fprintf(stderr, "%-10s %-40s %10s %12s %10s\n",
+            "category", "scope", "count", "total", "max");
+    for (auto const& it: s.scopes) {
+        fprintf(stderr, "%-10s %-40s %10lld %12.3f %10.3f\n",
+                it.first.first.c_str(), it.first.second.c_str(),
+                it.second.count, it.second.total*1e-3, it.second.maximum*1e-3);
+    }
+    for (auto const& it: s.counters) {
+        fprintf(stderr, "%-10s %-40s %10lld\n",
+                it.first.first.c_str(), it.first.second.c_str(), it.second);
+    }
+    if (s.dropped)
+        fprintf(stderr, "trace: %lu scopes dropped from the trace file\n",
+                (unsigned long) s.dropped);
+
+    if (!s.fileName.empty())
+        writeTraceFile(s);
+}
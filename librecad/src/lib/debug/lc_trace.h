@@ -0,0 +1,124 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_TRACE_H
+#define LC_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/**
+ * Tracing of the load, update, render and snap phases.
+ *
+ * Tracing is compiled in with DEFINES += LC_TRACE and enabled at run time
+ * with the --trace command line switch. While disabled, a scope or
+ * counter costs one relaxed atomic load and the argument of
+ * LC_TRACE_SCOPE_ARG is not evaluated.
+ *
+ * At exit the number, total and maximum time of every scope and the
+ * totals of the counters are printed to stderr. With --trace=<file> the
+ * scopes are also written in the Chrome trace event format, which can be
+ * opened with chrome://tracing or Perfetto.
+ */
+class LC_Trace {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    /**
+     * Starts tracing. The report is written at exit.
+     * @param fileName Chrome trace output file, empty for the summary only
+     */
+    static void enable(const std::string& fileName = std::string());
+
+    static void addScope(const char* category, const char* name,
+                         Clock::time_point start, Clock::time_point end,
+                         const std::string& arg);
+    static void addCount(const char* category, const char* name, long long n);
+
+    /** prints the summary and writes the trace file, if any */
+    static void report();
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+/**
+ * Measures the time from construction to destruction, use
+ * LC_TRACE_SCOPE() instead of constructing it directly.
+ */
+class LC_TraceScope {
+public:
+    LC_TraceScope(const char* category, const char* name):
+        category(category)
+      , name(name)
+      , active(LC_Trace::isEnabled())
+    {
+        if (active) start = LC_Trace::Clock::now();
+    }
+    ~LC_TraceScope() {
+        if (active)
+            LC_Trace::addScope(category, name, start, LC_Trace::Clock::now(), arg);
+    }
+    LC_TraceScope(const LC_TraceScope&) = delete;
+    LC_TraceScope& operator = (const LC_TraceScope&) = delete;
+
+    bool isActive() const {
+        return active;
+    }
+    /** sets a detail shown with the scope in the trace file */
+    void setArg(const std::string& a) {
+        arg = a;
+    }
+
+private:
+    const char* category;
+    const char* name;
+    bool active;
+    LC_Trace::Clock::time_point start;
+    std::string arg;
+};
+
+#ifdef LC_TRACE
+#define LC_TRACE_CONCAT2(a, b) a##b
+#define LC_TRACE_CONCAT(a, b) LC_TRACE_CONCAT2(a, b)
+#define LC_TRACE_VAR LC_TRACE_CONCAT(lcTraceScope, __LINE__)
+/** traces the enclosing block, category and name are string literals */
+#define LC_TRACE_SCOPE(category, name) \
+    LC_TraceScope LC_TRACE_VAR(category, name)
+/** like LC_TRACE_SCOPE, arg is a std::string only evaluated if tracing */
+#define LC_TRACE_SCOPE_ARG(category, name, arg) \
+    LC_TraceScope LC_TRACE_VAR(category, name); \
+    if (LC_TRACE_VAR.isActive()) LC_TRACE_VAR.setArg(arg)
+/** adds n to the counter, n is only evaluated if tracing */
+#define LC_TRACE_COUNT(category, name, n) \
+    do { if (LC_Trace::isEnabled()) LC_Trace::addCount(category, name, n); } while (0)
+#else
+#define LC_TRACE_SCOPE(category, name) do {} while (0)
+#define LC_TRACE_SCOPE_ARG(category, name, arg) do {} while (0)
+#define LC_TRACE_COUNT(category, name, n) do {} while (0)
+#endif
+
+#endif
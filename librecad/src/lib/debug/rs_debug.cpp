@@ -104,7 +104,8 @@ RS_Debug::RS_DebugLevel RS_Debug::getLevel() {
 
 
 /**
- * Prints the given message to stdout.
+ * Prints the given message to stdout. Debugging messages are not
+ * flushed, the stream is flushed by the next warning or error.
  */
 void RS_Debug::print(const char* format ...) {
     if(debugLevel==D_DEBUGGING) {
@@ -113,7 +114,6 @@ void RS_Debug::print(const char* format ...) {
         vfprintf(stream, format, ap);
         fprintf(stream, "\n");
         va_end(ap);
-        fflush(stream);
     }
 
 }
@@ -132,7 +132,9 @@ void RS_Debug::print(RS_DebugLevel level, const char* format ...) {
         vfprintf(stream, format, ap);
         fprintf(stream, "\n");
         va_end(ap);
-        fflush(stream);
+        if (level<=D_WARNING) {
+            fflush(stream);
+        }
     }
 
 }
@@ -44,6 +44,10 @@
 /**
  * Debugging facilities.
  *
+ * The arguments of print() are evaluated even if the message is not
+ * printed, use LC_TRACE_SCOPE and LC_TRACE_COUNT of lc_trace.h in code
+ * which runs for every entity.
+ *
  * @author Andrew Mustun
  */
 class RS_Debug {
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "lc_endpointindex.h"
+#include "rs_entity.h"
+
+namespace {
+/** cell index of a coordinate, clamped to avoid overflow */
+long long cellIndex(double x)
+{
+	const double limit = 4e18;
+	return static_cast<long long>(std::max(-limit, std::min(limit, std::floor(x))));
+}
+}
+
+LC_EndpointIndex::LC_EndpointIndex(double tolerance):
+	tolerance(tolerance)
+{
+}
+
+LC_EndpointIndex::Key LC_EndpointIndex::key(const RS_Vector& v) const
+{
+	return Key(cellIndex(v.x / tolerance), cellIndex(v.y / tolerance));
+}
+
+void LC_EndpointIndex::add(RS_Entity* entity, const RS_Vector& v, size_t order)
+{
+	if (!v.valid) return;
+	cells[key(v)].push_back(Entry{entity, v, order});
+}
+
+void LC_EndpointIndex::insert(RS_Entity* entity)
+{
+	if (!entity || orders.count(entity)) return;
+	size_t const order = inserted++;
+	orders[entity] = order;
+	add(entity, entity->getStartpoint(), order);
+	add(entity, entity->getEndpoint(), order);
+}
+
+void LC_EndpointIndex::remove(RS_Entity* entity)
+{
+	// the entries in the cells are skipped from now on
+	orders.erase(entity);
+}
+
+bool LC_EndpointIndex::contains(RS_Entity* entity) const
+{
+	return orders.count(entity) > 0;
+}
+
+size_t LC_EndpointIndex::size() const
+{
+	return orders.size();
+}
+
+RS_Entity* LC_EndpointIndex::nearest(const RS_Vector& coord, double* dist) const
+{
+	if (!coord.valid) return nullptr;
+	Key const center = key(coord);
+	RS_Entity* ret = nullptr;
+	double minDist = tolerance;
+	size_t minOrder = 0;
+	for (long long i = center.first - 1; i <= center.first + 1; ++i) {
+		for (long long j = center.second - 1; j <= center.second + 1; ++j) {
+			auto cell = cells.find(Key(i, j));
+			if (cell == cells.end()) continue;
+			for (Entry const& entry: cell->second) {
+				if (!orders.count(entry.entity)) continue;
+				double const d = coord.distanceTo(entry.point);
+				if (d > minDist) continue;
+				if (ret && d == minDist && entry.order > minOrder) continue;
+				ret = entry.entity;
+				minDist = d;
+				minOrder = entry.order;
+			}
+		}
+	}
+	if (ret && dist) {
+		*dist = minDist;
+	}
+	return ret;
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_ENDPOINTINDEX_H
+#define LC_ENDPOINTINDEX_H
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rs_vector.h"
+
+class RS_Entity;
+
+/**
+ * Hash grid of the start and end points of entities, used to chain
+ * entities into contours without comparing every pair of end points.
+ *
+ * The grid cells are as large as the tolerance, so only the 3x3 cells
+ * around a point need to be searched. Removed entities are skipped.
+ */
+class LC_EndpointIndex {
+public:
+	/** @param tolerance maximum distance of connected end points */
+	explicit LC_EndpointIndex(double tolerance);
+
+	/** adds start and end point of the entity */
+	void insert(RS_Entity* entity);
+	void remove(RS_Entity* entity);
+	/** @return true if the entity was inserted and not removed since */
+	bool contains(RS_Entity* entity) const;
+	/** @return number of entities inserted and not removed */
+	size_t size() const;
+
+	/**
+	 * @return entity with the end point closest to coord within the
+	 * tolerance, the first inserted one on ties, nullptr if none
+	 */
+	RS_Entity* nearest(const RS_Vector& coord, double* dist = nullptr) const;
+
+private:
+	typedef std::pair<long long, long long> Key;
+	struct KeyHash {
+		size_t operator () (const Key& key) const {
+			return std::hash<long long>()(key.first) * 31
+					+ std::hash<long long>()(key.second);
+		}
+	};
+	struct Entry {
+		RS_Entity* entity;
+		RS_Vector point;
+		size_t order;
+	};
+
+	Key key(const RS_Vector& v) const;
+	void add(RS_Entity* entity, const RS_Vector& v, size_t order);
+
+	double tolerance;
+	std::unordered_map<Key, std::vector<Entry>, KeyHash> cells;
+	//! insertion order of the entities not removed
+	std::unordered_map<RS_Entity*, size_t> orders;
+	size_t inserted = 0;
+};
+
+#endif
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#include "lc_layerindex.h"
+#include "rs_entity.h"
+
+LC_LayerIndex::LC_LayerIndex(const LC_LayerIndex&)
+{
+}
+
+LC_LayerIndex& LC_LayerIndex::operator = (const LC_LayerIndex&)
+{
+	invalidate();
+	return *this;
+}
+
+bool LC_LayerIndex::isValid() const
+{
+	return valid;
+}
+
+void LC_LayerIndex::build(const QList<RS_Entity*>& entities)
+{
+	invalidate();
+	valid = true;
+	entityLayers.reserve(entities.size());
+	for (RS_Entity* e: entities)
+		insert(e);
+}
+
+void LC_LayerIndex::invalidate()
+{
+	valid = false;
+	layerEntities.clear();
+	entityLayers.clear();
+}
+
+void LC_LayerIndex::insert(RS_Entity* entity)
+{
+	if (!valid || !entity) return;
+	RS_Layer* layer = entity->getLayer(false);
+	layerEntities[layer].insert(entity);
+	entityLayers[entity] = layer;
+}
+
+void LC_LayerIndex::remove(RS_Entity* entity)
+{
+	if (!valid) return;
+	auto it = entityLayers.find(entity);
+	if (it == entityLayers.end()) return;
+	auto itLayer = layerEntities.find(it->second);
+	itLayer->second.erase(entity);
+	if (itLayer->second.empty())
+		layerEntities.erase(itLayer);
+	entityLayers.erase(it);
+}
+
+void LC_LayerIndex::update(RS_Entity* entity)
+{
+	if (!valid || entityLayers.count(entity) == 0) return;
+	remove(entity);
+	insert(entity);
+}
+
+std::vector<RS_Entity*> LC_LayerIndex::entities(RS_Layer* layer) const
+{
+	auto it = layerEntities.find(layer);
+	if (it == layerEntities.end())
+		return std::vector<RS_Entity*>();
+	return std::vector<RS_Entity*>(it->second.begin(), it->second.end());
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_LAYERINDEX_H
+#define LC_LAYERINDEX_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <QList>
+
+class RS_Entity;
+class RS_Layer;
+
+/**
+ * Entities of one RS_EntityContainer by their own layer (not resolved,
+ * sub-entities are not included), so queries for a layer depend on the
+ * number of entities on it only.
+ *
+ * The index is built on the first query and maintained incrementally
+ * afterwards. Copies of an index are empty and invalid.
+ */
+class LC_LayerIndex {
+public:
+	LC_LayerIndex() = default;
+	LC_LayerIndex(const LC_LayerIndex&);
+	LC_LayerIndex& operator = (const LC_LayerIndex&);
+
+	/** @return true if the index was built and not invalidated since */
+	bool isValid() const;
+	void build(const QList<RS_Entity*>& entities);
+	/** drops the index, the next query will build it again */
+	void invalidate();
+
+	void insert(RS_Entity* entity);
+	void remove(RS_Entity* entity);
+	/** moves an indexed entity to its current layer */
+	void update(RS_Entity* entity);
+
+	/** @return entities on the given layer, in no particular order */
+	std::vector<RS_Entity*> entities(RS_Layer* layer) const;
+
+private:
+	bool valid = false;
+	std::unordered_map<RS_Layer*, std::unordered_set<RS_Entity*>> layerEntities;
+	/** layer each entity is indexed under */
+	std::unordered_map<RS_Entity*, RS_Layer*> entityLayers;
+};
+
+#endif
@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "lc_spatialindex.h"
+#include "rs_entity.h"
+#include "rs_vector.h"
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+namespace {
+typedef bg::model::point<double, 2, bg::cs::cartesian> Point;
+typedef bg::model::box<Point> Box;
+typedef std::pair<Box, RS_Entity*> Value;
+
+/**
+ * @brief boxDistance Euclidean distance from coord to box, 0 if inside
+ */
+double boxDistance(const Box& box, const RS_Vector& coord)
+{
+	double const dx = std::max(0., std::max(box.min_corner().get<0>() - coord.x,
+											coord.x - box.max_corner().get<0>()));
+	double const dy = std::max(0., std::max(box.min_corner().get<1>() - coord.y,
+											coord.y - box.max_corner().get<1>()));
+	return std::hypot(dx, dy);
+}
+
+void extend(Box& box, const RS_Vector& v)
+{
+	if (!v.valid) return;
+	bg::expand(box, Point(v.x, v.y));
+}
+
+/**
+ * @brief keyBox borders of the entity including center and reference points
+ * @return false, if the entity can not be bounded
+ */
+bool keyBox(RS_Entity* e, Box& box)
+{
+	if (e->rtti() == RS2::EntityConstructionLine) return false;
+	RS_Vector const& vMin = e->getMin();
+	RS_Vector const& vMax = e->getMax();
+	if (!vMin.valid || !vMax.valid
+			|| vMin.x > vMax.x || vMin.y > vMax.y
+			|| vMax.x - vMin.x > RS_MAXDOUBLE
+			|| vMax.y - vMin.y > RS_MAXDOUBLE)
+		return false;
+	box = Box(Point(vMin.x, vMin.y), Point(vMax.x, vMax.y));
+	extend(box, e->getCenter());
+	for (RS_Vector const& vp: e->getRefPoints())
+		extend(box, vp);
+	return true;
+}
+}
+
+struct LC_SpatialIndex::Impl {
+	bgi::rtree<Value, bgi::rstar<16> > tree;
+	/** boxes of indexed entities, needed for removal */
+	std::unordered_map<RS_Entity*, Box> boxes;
+	/** entities without a finite box */
+	std::vector<RS_Entity*> unbounded;
+	/** entities added since the last query */
+	std::vector<RS_Entity*> pending;
+
+	void add(RS_Entity* e)
+	{
+		Box box;
+		if (keyBox(e, box)) {
+			tree.insert(Value(box, e));
+			boxes[e] = box;
+		} else {
+			unbounded.push_back(e);
+		}
+	}
+
+	void flush()
+	{
+		for (RS_Entity* e: pending)
+			add(e);
+		pending.clear();
+	}
+};
+
+LC_SpatialIndex::LC_SpatialIndex() = default;
+
+LC_SpatialIndex::LC_SpatialIndex(const LC_SpatialIndex&)
+{
+}
+
+LC_SpatialIndex& LC_SpatialIndex::operator = (const LC_SpatialIndex&)
+{
+	pImpl.reset();
+	return *this;
+}
+
+LC_SpatialIndex::~LC_SpatialIndex() = default;
+
+bool LC_SpatialIndex::isValid() const
+{
+	return pImpl != nullptr;
+}
+
+void LC_SpatialIndex::build(const QList<RS_Entity*>& entities)
+{
+	pImpl.reset(new Impl);
+	std::vector<Value> values;
+	values.reserve(entities.size());
+	for (RS_Entity* e: entities) {
+		Box box;
+		if (keyBox(e, box)) {
+			values.push_back(Value(box, e));
+			pImpl->boxes[e] = box;
+		} else {
+			pImpl->unbounded.push_back(e);
+		}
+	}
+	// packing algorithm
+	pImpl->tree = bgi::rtree<Value, bgi::rstar<16> >(values.begin(), values.end());
+}
+
+void LC_SpatialIndex::invalidate()
+{
+	pImpl.reset();
+}
+
+void LC_SpatialIndex::insert(RS_Entity* entity)
+{
+	if (!pImpl || !entity) return;
+	pImpl->pending.push_back(entity);
+}
+
+void LC_SpatialIndex::remove(RS_Entity* entity)
+{
+	if (!pImpl || !entity) return;
+	auto itBox = pImpl->boxes.find(entity);
+	if (itBox != pImpl->boxes.end()) {
+		pImpl->tree.remove(Value(itBox->second, entity));
+		pImpl->boxes.erase(itBox);
+		return;
+	}
+	auto& pending = pImpl->pending;
+	auto it = std::find(pending.begin(), pending.end(), entity);
+	if (it != pending.end()) {
+		pending.erase(it);
+		return;
+	}
+	auto& unbounded = pImpl->unbounded;
+	unbounded.erase(std::remove(unbounded.begin(), unbounded.end(), entity),
+					unbounded.end());
+}
+
+bool LC_SpatialIndex::update(RS_Entity* entity, RS_Vector* oldMin, RS_Vector* oldMax)
+{
+	if (!pImpl || !entity) return false;
+	auto itBox = pImpl->boxes.find(entity);
+	if (itBox != pImpl->boxes.end()) {
+		Box box;
+		if (keyBox(entity, box) && bg::equals(box, itBox->second))
+			return false;
+		Box const& old = itBox->second;
+		if (oldMin)
+			*oldMin = RS_Vector(old.min_corner().get<0>(), old.min_corner().get<1>());
+		if (oldMax)
+			*oldMax = RS_Vector(old.max_corner().get<0>(), old.max_corner().get<1>());
+		pImpl->tree.remove(Value(old, entity));
+		pImpl->boxes.erase(itBox);
+		pImpl->pending.push_back(entity);
+		return true;
+	}
+	auto& unbounded = pImpl->unbounded;
+	auto it = std::find(unbounded.begin(), unbounded.end(), entity);
+	if (it == unbounded.end())
+		return false;
+	if (oldMin) *oldMin = RS_Vector(false);
+	if (oldMax) *oldMax = RS_Vector(false);
+	unbounded.erase(it);
+	pImpl->pending.push_back(entity);
+	return true;
+}
+
+void LC_SpatialIndex::visitNearest(const RS_Vector& coord,
+								   const std::function<bool(RS_Entity*, double)>& visitor) const
+{
+	if (!pImpl) return;
+	pImpl->flush();
+	for (RS_Entity* e: pImpl->unbounded)
+		if (!visitor(e, 0.)) return;
+
+	auto const& tree = pImpl->tree;
+	if (tree.empty()) return;
+	// incremental k-nearest query, results are produced on demand
+	for (auto it = tree.qbegin(bgi::nearest(Point(coord.x, coord.y), tree.size()));
+		 it != tree.qend(); ++it) {
+		if (!visitor(it->second, boxDistance(it->first, coord))) return;
+	}
+}
+
+std::vector<RS_Entity*> LC_SpatialIndex::entitiesInWindow(const RS_Vector& v1,
+														  const RS_Vector& v2) const
+{
+	std::vector<RS_Entity*> ret;
+	if (!pImpl) return ret;
+	pImpl->flush();
+	ret = pImpl->unbounded;
+	Box const window(Point(std::min(v1.x, v2.x), std::min(v1.y, v2.y)),
+					 Point(std::max(v1.x, v2.x), std::max(v1.y, v2.y)));
+	std::vector<Value> found;
+	pImpl->tree.query(bgi::intersects(window), std::back_inserter(found));
+	ret.reserve(ret.size() + found.size());
+	for (Value const& v: found)
+		ret.push_back(v.second);
+	return ret;
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_SPATIALINDEX_H
+#define LC_SPATIALINDEX_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <QList>
+
+class RS_Entity;
+class RS_Vector;
+
+/**
+ * R-tree of the entities of one RS_EntityContainer, keyed on the entity
+ * borders extended by its center and reference points, so the box distance
+ * is a lower bound for every nearest-point query of RS_EntityContainer.
+ *
+ * Entities without valid borders and construction lines (infinite extent)
+ * are kept aside and always reported first with distance 0.
+ *
+ * Copies of an index are empty and invalid, so cloned containers build
+ * their own index on first use.
+ */
+class LC_SpatialIndex {
+public:
+	/** containers smaller than this are scanned linearly */
+	static const int minimumEntities = 64;
+
+	LC_SpatialIndex();
+	LC_SpatialIndex(const LC_SpatialIndex&);
+	LC_SpatialIndex& operator = (const LC_SpatialIndex&);
+	~LC_SpatialIndex();
+
+	/** @return true if the index was built and not invalidated since */
+	bool isValid() const;
+	/** rebuilds the index from scratch with bulk loading */
+	void build(const QList<RS_Entity*>& entities);
+	/** drops the index, the next query will build it again */
+	void invalidate();
+
+	/**
+	 * Queues an entity for insertion. Entities are inserted on the next
+	 * query, so borders updated right after addEntity() are honored.
+	 */
+	void insert(RS_Entity* entity);
+	void remove(RS_Entity* entity);
+	/**
+	 * Re-indexes an entity modified in place, if its box changed. Pending
+	 * entities are boxed on the next query anyway.
+	 * @param oldMin, oldMax set to the previous box of the entity, invalid
+	 *  if the entity was not bounded
+	 * @return true if the box of an indexed entity changed
+	 */
+	bool update(RS_Entity* entity, RS_Vector* oldMin = nullptr,
+				RS_Vector* oldMax = nullptr);
+
+	/**
+	 * Visits entities in ascending distance of their boxes to coord. The
+	 * visitor receives the box distance and returns false to stop.
+	 */
+	void visitNearest(const RS_Vector& coord,
+					  const std::function<bool(RS_Entity*, double)>& visitor) const;
+
+	/** @return entities with boxes intersecting the window v1, v2 */
+	std::vector<RS_Entity*> entitiesInWindow(const RS_Vector& v1,
+											 const RS_Vector& v2) const;
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> pImpl;
+};
+
+#endif
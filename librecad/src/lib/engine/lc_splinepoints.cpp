@@ -285,7 +285,7 @@ LC_SplinePoints::LC_SplinePoints(RS_EntityContainer* parent,
 	RS_AtomicEntity(parent)
   ,data(d)
 {
-	calculateBorders();
+	update();
 }
 
 RS_Entity* LC_SplinePoints::clone() const
@@ -1123,6 +1123,7 @@ bool LC_SplinePoints::addPoint(const RS_Vector& v)
 		(v - data.splinePoints.back()).squared() > RS_TOLERANCE2)
 	{
 		data.splinePoints.push_back(v);
+		update();
 		return true;
 	}
 	return false;
@@ -1134,6 +1135,7 @@ bool LC_SplinePoints::addPoint(const RS_Vector& v)
 void LC_SplinePoints::removeLastPoint()
 {
 	data.splinePoints.pop_back();
+	update();
 }
 
 void LC_SplinePoints::addControlPoint(const RS_Vector& v)
@@ -1824,8 +1826,6 @@ void LC_SplinePoints::draw(RS_Painter* painter, RS_GraphicView* view, double& pa
 			"RS_Line::draw: Invalid line pattern");
 	}
 
-	update();
-
     // Pen to draw pattern is always solid:
     RS_Pen pen = painter->getPen();
     pen.setLineType(RS2::SolidLine);
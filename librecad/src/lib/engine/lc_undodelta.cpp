@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+#include "lc_undodelta.h"
+#include "rs_entitycontainer.h"
+#include "rs_insert.h"
+#include "rs_layer.h"
+
+LC_UndoDelta::LC_UndoDelta(const std::vector<RS_Entity*>& entities):
+	entities(entities)
+{
+}
+
+size_t LC_UndoDelta::memoryUsage() const
+{
+	return sizeof(*this) + entities.capacity() * sizeof(RS_Entity*);
+}
+
+void LC_UndoDelta::entityChanged(RS_Entity* e)
+{
+	RS_EntityContainer* parent = e->getParent();
+	if (parent) {
+		parent->entityModified(e);
+	}
+}
+
+
+LC_UndoMove::LC_UndoMove(const std::vector<RS_Entity*>& entities,
+						 const RS_Vector& offset):
+	LC_UndoDelta(entities)
+  ,offset(offset)
+{
+}
+
+void LC_UndoMove::apply(bool inverse)
+{
+	for (RS_Entity* e: entities) {
+		e->move(inverse ? -offset : offset);
+		if (e->rtti()==RS2::EntityInsert) {
+			static_cast<RS_Insert*>(e)->update();
+		}
+		entityChanged(e);
+	}
+}
+
+void LC_UndoMove::undoStateChanged(bool undone)
+{
+	apply(undone);
+}
+
+
+LC_UndoAttributes::LC_UndoAttributes(const std::vector<RS_Entity*>& entities):
+	LC_UndoDelta(entities)
+{
+	attributes.reserve(entities.size());
+	for (RS_Entity* e: entities) {
+		RS_Layer* layer = e->getLayer(false);
+		attributes.push_back({e->getPen(false),
+							  layer ? layer->getName() : QString(),
+							  layer!=nullptr});
+	}
+}
+
+size_t LC_UndoAttributes::memoryUsage() const
+{
+	return LC_UndoDelta::memoryUsage() + attributes.capacity() * sizeof(Attributes);
+}
+
+/**
+ * Exchanges the recorded attributes with the ones of the entities, so
+ * undo and redo are the same.
+ */
+void LC_UndoAttributes::undoStateChanged(bool /*undone*/)
+{
+	for (size_t i = 0; i < entities.size(); ++i) {
+		RS_Entity* e = entities[i];
+		Attributes& a = attributes[i];
+		RS_Layer* layer = e->getLayer(false);
+		Attributes const current{e->getPen(false),
+								 layer ? layer->getName() : QString(),
+								 layer!=nullptr};
+		e->setPen(a.pen);
+		if (a.hasLayer) {
+			e->setLayer(a.layer);
+		} else {
+			e->setLayer((RS_Layer*)nullptr);
+		}
+		a = current;
+		e->update();
+		entityChanged(e);
+	}
+}
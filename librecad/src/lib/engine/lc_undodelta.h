@@ -0,0 +1,103 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_UNDODELTA_H
+#define LC_UNDODELTA_H
+
+#include <cstddef>
+#include <vector>
+#include <QString>
+
+#include "rs_pen.h"
+#include "rs_undoable.h"
+#include "rs_vector.h"
+
+class RS_Entity;
+
+/**
+ * Undoable change of entities in place. Instead of a modified clone of
+ * every entity, only the change and the entities are kept in the undo
+ * cycle. The change is reverted when the delta is undone and applied
+ * again when it is redone.
+ *
+ * Deltas are owned by the undo cycle they were added to.
+ */
+class LC_UndoDelta : public RS_Undoable {
+public:
+	explicit LC_UndoDelta(const std::vector<RS_Entity*>& entities);
+	virtual ~LC_UndoDelta() = default;
+
+	virtual RS2::UndoableType undoRtti() {
+		return RS2::UndoableDelta;
+	}
+
+	/** @return estimated memory used by the delta in bytes */
+	virtual size_t memoryUsage() const;
+
+protected:
+	/** updates the container of the entity after a change */
+	static void entityChanged(RS_Entity* e);
+
+	std::vector<RS_Entity*> entities;
+};
+
+
+/**
+ * Move of entities. Moving back by the offset may round the
+ * coordinates. Lossy transformations like rotations keep the original
+ * entities instead.
+ */
+class LC_UndoMove : public LC_UndoDelta {
+public:
+	LC_UndoMove(const std::vector<RS_Entity*>& entities, const RS_Vector& offset);
+
+	/** moves the entities, or moves them back if inverse */
+	void apply(bool inverse);
+	virtual void undoStateChanged(bool undone);
+
+private:
+	RS_Vector offset;
+};
+
+
+/**
+ * Change of the pen and layer of entities.
+ */
+class LC_UndoAttributes : public LC_UndoDelta {
+public:
+	/** records the current pen and layer of the entities */
+	explicit LC_UndoAttributes(const std::vector<RS_Entity*>& entities);
+
+	virtual size_t memoryUsage() const;
+	virtual void undoStateChanged(bool undone);
+
+private:
+	//! pen and layer name, exchanged with the ones of the entity on undo / redo
+	struct Attributes {
+		RS_Pen pen;
+		QString layer;
+		bool hasLayer;
+	};
+	std::vector<Attributes> attributes;
+};
+
+#endif
@@ -455,7 +455,8 @@ public:
     enum UndoableType {
         UndoableUnknown,    /**< Unknown undoable */
         UndoableEntity,     /**< Entity */
-        UndoableLayer       /**< Layer */
+        UndoableLayer,      /**< Layer */
+        UndoableDelta       /**< Change of entities in place */
     };
 
     /**
@@ -1195,6 +1196,8 @@ public:
                 RedrawGrid = 1,
                 RedrawOverlay = 2,
                 RedrawDrawing = 4,
+                RedrawDrawingCached = 8, /**< drawing changed only where invalidated */
+                RedrawView = RedrawGrid | RedrawOverlay | RedrawDrawingCached,
                 RedrawAll = 0xffff
         };
 
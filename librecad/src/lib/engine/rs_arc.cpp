@@ -35,6 +35,7 @@
 #include "rs_graphicview.h"
 #include "rs_painter.h"
 #include "lc_quadratic.h"
+#include "lc_clipping.h"
 #include "rs_painterqt.h"
 
 
@@ -274,6 +275,7 @@ void RS_Arc::calculateBorders() {
 
     minV.set(minX, minY);
     maxV.set(maxX, maxY);
+    bordersChanged();
 }
 
 
@@ -886,60 +888,27 @@ void RS_Arc::stretch(const RS_Vector& firstCorner,
     correctAngles(); // make sure angleLength is no more than 2*M_PI
 }
 
-/** find the visible part of the arc, and call drawVisible() to draw */
+/** find the visible part of the arc, and call drawPiece() to draw */
 void RS_Arc::draw(RS_Painter* painter, RS_GraphicView* view,
                   double& patternOffset) {
+    if (painter==NULL || view==NULL) {
+        return;
+    }
 
-    //only draw the visible portion of line
+    //only draw the visible portion of arc
     RS_Vector vpMin(view->toGraph(0,view->getHeight()));
     RS_Vector vpMax(view->toGraph(view->getWidth(),0));
-    QPolygonF visualBox(QRectF(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y));
-
-    RS_Vector vpStart(isReversed()?getEndpoint():getStartpoint());
-    RS_Vector vpEnd(isReversed()?getStartpoint():getEndpoint());
-
-	std::vector<RS_Vector> vertex(0);
-    for(unsigned short i=0;i<4;i++){
-        const QPointF& vp(visualBox.at(i));
-		vertex.push_back(RS_Vector(vp.x(),vp.y()));
-    }
-    /** angles at cross points */
-	std::vector<double> crossPoints(0);
 
+    double pieces[2*LC_Clipping::maxArcPieces];
     double baseAngle=isReversed()?getAngle2():getAngle1();
-    for(unsigned short i=0;i<4;i++){
-        RS_Line line(NULL,RS_LineData(vertex.at(i),vertex.at((i+1)%4)));
-		auto vpIts=RS_Information::getIntersection(
-                    static_cast<RS_Entity*>(this),
-                    &line,
-                    true);
-        if( vpIts.size()==0) continue;
-		for(const RS_Vector& vp: vpIts){
-			auto ap1=getTangentDirection(vp).angle();
-			auto ap2=line.getTangentDirection(vp).angle();
-            //ignore tangent points, because the arc doesn't cross over
-            if( fabs( remainder(ap2 - ap1, M_PI) ) < RS_TOLERANCE_ANGLE) continue;
-            crossPoints.push_back(
-                        RS_Math::getAngleDifference(baseAngle, getCenter().angleTo(vp))
-                        );
-        }
-    }
-    if(vpStart.isInWindowOrdered(vpMin, vpMax)) crossPoints.push_back(0.);
-    if(vpEnd.isInWindowOrdered(vpMin, vpMax)) crossPoints.push_back(getAngleLength());
-
-    //sorting
-    std::sort(crossPoints.begin(),crossPoints.end());
+    int n=LC_Clipping::clipArc(getCenter(), getRadius(),
+                               baseAngle, getAngleLength(),
+                               vpMin, vpMax, pieces);
     //draw visible
-    RS_Arc arc(*this);
-    arc.setPen(getPen());
-    arc.setSelected(isSelected());
-    arc.setReversed(false);
-	for(size_t i=1;i<crossPoints.size();i+=2){
-		arc.setAngle1(baseAngle+crossPoints[i-1]);
-		arc.setAngle2(baseAngle+crossPoints[i]);
-        arc.drawVisible(painter,view,patternOffset);
+    for(int i=0;i<n;i++){
+        drawPiece(painter, view, patternOffset,
+                  baseAngle+pieces[2*i], baseAngle+pieces[2*i+1], false);
     }
-
 }
 
 /** directly draw the arc, assuming the whole arc is within visible window */
@@ -952,9 +921,18 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
     //visible in grahic view
     if(isVisibleInWindow(view)==false) return;
 
+    drawPiece(painter, view, patternOffset,
+              getAngle1(), getAngle2(), isReversed());
+}
+
+void RS_Arc::drawPiece(RS_Painter* painter, RS_GraphicView* view,
+                       double& patternOffset,
+                       double a1, double a2, bool reversed) {
     RS_Vector cp=view->toGui(getCenter());
     double ra=getRadius()*view->getFactor().x;
-    double length=getLength()*view->getFactor().x;
+    double angleLength=reversed?a1-a2:a2-a1;
+    if(angleLength<=RS_TOLERANCE_ANGLE) angleLength += 2.*M_PI;
+    double length=angleLength*ra;
     //double styleFactor = getStyleFactor();
     patternOffset -= length;
 
@@ -964,18 +942,10 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
              view->getDrawingMode()==RS2::ModePreview)) {
         painter->drawArc(cp,
                          ra,
-                         getAngle1(), getAngle2(),
-                         isReversed());
+                         a1, a2,
+                         reversed);
         return;
     }
-//    double styleFactor = getStyleFactor(view);
-    //        if (styleFactor<0.0) {
-    //            painter->drawArc(cp,
-    //                             ra,
-    //                             getAngle1(), getAngle2(),
-    //                             isReversed());
-    //            return;
-    //        }
 
     // Pattern:
     const RS_LineTypePattern* pat;
@@ -988,14 +958,18 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
     if (pat==NULL|| ra<0.5) {//avoid division by zero from small ra
 		RS_DEBUG->print("%s: Invalid line pattern or radius too small, drawing arc using solid line", __func__);
         painter->drawArc(cp, ra,
-                         getAngle1(),getAngle2(),
-                         isReversed());
+                         a1, a2,
+                         reversed);
         return;
     }
 
-//    patternOffset=remainder(patternOffset - length -0.5*pat->totalLength,pat->totalLength)+0.5*pat->totalLength;
-
-    if (ra<RS_TOLERANCE_ANGLE){
+    if (pat->num==0) {
+        //invalid pattern
+        RS_DEBUG->print(RS_Debug::D_WARNING, "RS_Arc::draw(): invalid line pattern\n");
+        painter->drawArc(cp,
+                         ra,
+                         a1, a2,
+                         reversed);
         return;
     }
 
@@ -1004,42 +978,17 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
     pen.setLineType(RS2::SolidLine);
     painter->setPen(pen);
 
-
-
-    // create scaled pattern:
-	std::vector<double> da(0);
+    // scaled pattern segments are computed on the fly, in angle
     double patternSegmentLength(pat->totalLength);
     double ira=1./ra;
-	size_t i(0);          // index counter
-    if(pat->num>0) {
-        double dpmm=static_cast<RS_PainterQt*>(painter)->getDpmm();
-        da.resize(pat->num);
-        while(i<pat->num){
-            //        da[j] = pat->pattern[i++] * styleFactor;
-            //fixme, stylefactor needed
-            da[i] =dpmm*(isReversed()? -fabs(pat->pattern[i]):fabs(pat->pattern[i]));
-            if( fabs(da[i]) < 1. ) da[i] = (da[i]>=0.)?1.:-1.;
-            da[i] *= ira;
-            i++;
-        }
-    }else {
-        //invalid pattern
-
-        RS_DEBUG->print(RS_Debug::D_WARNING, "RS_Arc::draw(): invalid line pattern\n");
-        painter->drawArc(cp,
-                         ra,
-                         getAngle1(), getAngle2(),
-                         isReversed());
-        return;
-    }
+    double dpmm=static_cast<RS_PainterQt*>(painter)->getDpmm();
 
-    //    bool done = false;
     double total=remainder(patternOffset-0.5*patternSegmentLength,patternSegmentLength)-0.5*patternSegmentLength;
 
-    double a1(RS_Math::correctAngle(getAngle1()));
-    double a2(RS_Math::correctAngle(getAngle2()));
+    a1=RS_Math::correctAngle(a1);
+    a2=RS_Math::correctAngle(a2);
 
-    if(isReversed()) {//always draw from a1 to a2, so, patternOffset is is automatic
+    if(reversed) {//always draw from a1 to a2, so, patternOffset is is automatic
         if(a1<a2+RS_TOLERANCE_ANGLE) a2 -= 2.*M_PI;
         total = a1 - total*ira; //in angle
     }else{
@@ -1050,8 +999,11 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
     double t2;
     double a11,a21;
 
-    for(int j=0; fabs(total-a1)<limit ;j=(j+1)%i) {
-        t2=total+da[j];
+    for(size_t j=0; fabs(total-a1)<limit ;j=(j+1)%pat->num) {
+        double da=dpmm*fabs(pat->pattern[j]);
+        if( da < 1. ) da = 1.;
+        da *= reversed? -ira: ira;
+        t2=total+da;
 
         if(pat->pattern[j]>0.0) {
 
@@ -1061,7 +1013,7 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
                 painter->drawArc(cp, ra,
                                  a11,
                                  a21,
-                                 isReversed());
+                                 reversed);
             }
         }
         total=t2;
@@ -254,6 +254,14 @@ m0 x + m1 y + m2 =0
     virtual double areaLineIntegral() const;
 
 protected:
+    /**
+     * draws the arc from a1 to a2 with the line pattern, patternOffset
+     * is the pattern phase at a1
+     */
+    void drawPiece(RS_Painter* painter, RS_GraphicView* view,
+                   double& patternOffset,
+                   double a1, double a2, bool reversed);
+
     RS_ArcData data;
 
     /**
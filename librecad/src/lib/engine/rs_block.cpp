@@ -55,6 +55,23 @@ RS_Block::RS_Block(RS_EntityContainer* parent,
 }
 
 
+namespace {
+//! renames of all blocks, see RS_Block::getRenameCount()
+unsigned renameCount = 0;
+}
+
+void RS_Block::setName(const QString& n) {
+	if (n!=data.name) {
+		data.name = n;
+		++renameCount;
+	}
+}
+
+unsigned RS_Block::getRenameCount() {
+	return renameCount;
+}
+
+
 RS_Entity* RS_Block::clone() const {
     RS_Block* blk = new RS_Block(*this);
     blk->setOwner(isOwner());
@@ -147,9 +147,9 @@ public:
 	 * sets a new name for the block. Only called by blocklist to
 	 * assure that block names stay unique.
 	 */
-    void setName(const QString& n) {
-		data.name = n;
-    }
+    void setName(const QString& n);
+	/** @return number of block renames so far, indexes by name are stale when it changed */
+	static unsigned getRenameCount();
     
 	/**
      * @retval true if this block is frozen (invisible)
@@ -35,6 +35,13 @@
 #include "emu_qt44.h"
 #endif
 
+namespace {
+//! key of a block name in the name index
+QString nameKey(const QString& name) {
+    return name.toCaseFolded();
+}
+}
+
 /**
  * Constructor.
  * 
@@ -46,6 +53,7 @@ RS_BlockList::RS_BlockList(bool owner) {
     this->owner = owner;
     //blocks.setAutoDelete(owner);
 	activeBlock = nullptr;
+	indexedRenames = RS_Block::getRenameCount();
 	setModified(false);
 }
 
@@ -55,6 +63,7 @@ RS_BlockList::RS_BlockList(bool owner) {
  */
 void RS_BlockList::clear() {
     blocks.clear();
+    blockNames.clear();
 	activeBlock = nullptr;
 	setModified(true);
 }
@@ -100,6 +109,7 @@ bool RS_BlockList::add(RS_Block* block, bool notify) {
     RS_Block* b = find(block->getName());
 	if (b==nullptr) {
         blocks.append(block);
+        blockNames.insert(nameKey(block->getName()), block);
 
         if (notify) {
             addNotification();
@@ -146,6 +156,9 @@ void RS_BlockList::remove(RS_Block* block) {
 #else
     blocks.removeOne(block);
 #endif
+    if (block && blockNames.value(nameKey(block->getName()))==block) {
+        blockNames.remove(nameKey(block->getName()));
+    }
 	for(auto l: blockListListeners){
 		l->blockRemoved(block);
 	}
@@ -177,8 +190,13 @@ void RS_BlockList::remove(RS_Block* block) {
  */
 bool RS_BlockList::rename(RS_Block* block, const QString& name) {
 	if (block) {
-		if (find(name)==nullptr) {
+		RS_Block* b = find(name);
+		if (b==nullptr || b==block) {
+			if (blockNames.value(nameKey(block->getName()))==block) {
+				blockNames.remove(nameKey(block->getName()));
+			}
 			block->setName(name);
+			blockNames.insert(nameKey(name), block);
 			setModified(true);
 			return true;
 		}
@@ -206,19 +224,21 @@ void RS_BlockList::editBlock(RS_Block* block, const RS_Block& source) {
 */
 
 /**
- * @return Pointer to the block with the given name or
+ * @return Pointer to the block with the given name (ignoring case) or
  * \p nullptr if no such block was found.
  */
 RS_Block* RS_BlockList::find(const QString& name) {
-    //RS_DEBUG->print("RS_BlockList::find");
-	// Todo : reduce this from O(N) to O(log(N)) complexity based on sorted list or hash
-	for(RS_Block* b: blocks){
-		if (b->getName()==name) {
-			return b;
+	if (indexedRenames!=RS_Block::getRenameCount()) {
+		// a block was renamed, index all names again:
+		indexedRenames = RS_Block::getRenameCount();
+		blockNames.clear();
+		for(RS_Block* b: blocks){
+			if (!blockNames.contains(nameKey(b->getName()))) {
+				blockNames.insert(nameKey(b->getName()), b);
+			}
 		}
 	}
-
-	return nullptr;
+	return blockNames.value(nameKey(name));
 }
 
 /**
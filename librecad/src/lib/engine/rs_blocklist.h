@@ -29,6 +29,7 @@
 #define RS_BLOCKLIST_H
 
 
+#include <QHash>
 #include <QList>
 
 class QString;
@@ -103,6 +104,10 @@ private:
     bool owner;
     //! Blocks in the graphic
     QList<RS_Block*> blocks;
+    //! blocks by case folded name, DXF names are case insensitive
+    QHash<QString, RS_Block*> blockNames;
+    //! RS_Block::getRenameCount() when blockNames was complete
+    unsigned indexedRenames;
     //! List of registered BlockListListeners
     QList<RS_BlockListListener*> blockListListeners;
     //! Currently active block
@@ -91,6 +91,7 @@ void RS_Circle::calculateBorders() {
 	RS_Vector r(data.radius,data.radius);
 	minV = data.center - r;
 	maxV = data.center + r;
+	bordersChanged();
 }
 
 
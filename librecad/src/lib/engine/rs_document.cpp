@@ -48,3 +48,47 @@ RS_Document::RS_Document(RS_EntityContainer* parent)
 
     gv = NULL;//used to read/save current view
 }
+
+
+
+/**
+ * Remembers the previous borders of entities modified in place, so graphic
+ * views caching the drawing can drop the area the entity was drawn at.
+ */
+void RS_Document::entityBordersChanged(RS_Entity* entity) {
+    // without the spatial index the previous borders are unknown
+    bool const known = spatialIndex.isValid();
+    RS_Vector vMin(false), vMax(false);
+    if (!spatialIndex.update(entity, &vMin, &vMax) && known) {
+        return;
+    }
+    if (!modifiedRegion) {
+        modifiedMin = vMin;
+        modifiedMax = vMax;
+        modifiedRegion = true;
+    } else if (modifiedMin.valid && vMin.valid) {
+        modifiedMin = RS_Vector::minimum(modifiedMin, vMin);
+        modifiedMax = RS_Vector::maximum(modifiedMax, vMax);
+    } else {
+        modifiedMin = modifiedMax = RS_Vector(false);
+    }
+}
+
+
+
+/**
+ * Returns and resets the region of the previous borders of entities
+ * modified in place.
+ *
+ * @return false if no entity was modified since the last call. Otherwise
+ *   vMin and vMax are set, they are invalid if the region is unknown.
+ */
+bool RS_Document::takeModifiedRegion(RS_Vector& vMin, RS_Vector& vMax) {
+    if (!modifiedRegion) {
+        return false;
+    }
+    vMin = modifiedMin;
+    vMax = modifiedMax;
+    modifiedRegion = false;
+    return true;
+}
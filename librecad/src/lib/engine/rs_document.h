@@ -135,6 +135,9 @@ public:
 		RS_Undo::startUndoCycle();
 	}
 
+    virtual void entityBordersChanged(RS_Entity* entity);
+    bool takeModifiedRegion(RS_Vector& vMin, RS_Vector& vMax);
+
     void setGraphicView(RS_GraphicView * g) {gv = g;}
     RS_GraphicView* getGraphicView() {return gv;}
 
@@ -151,6 +154,12 @@ protected:
 	RS2::FormatType formatType;
     RS_GraphicView * gv;//used to read/save current view
 
+private:
+    /** previous borders of entities modified in place, see takeModifiedRegion() */
+    RS_Vector modifiedMin = RS_Vector(false);
+    RS_Vector modifiedMax = RS_Vector(false);
+    bool modifiedRegion = false;
+
 };
 
 
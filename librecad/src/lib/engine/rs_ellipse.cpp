@@ -178,6 +178,7 @@ void RS_Ellipse::calculateBorders() {
 
     minV.set(minX, minY);
 	maxV.set(maxX, maxY);
+	bordersChanged();
 }
 
 
@@ -28,7 +28,6 @@
 
 #include <iostream>
 #include <utility>
-#include <QPolygon>
 
 #include "rs_entity.h"
 #include "rs_arc.h"
@@ -45,7 +44,7 @@
 #include "rs_polyline.h"
 #include "rs_text.h"
 #include "rs_vector.h"
-#include "rs_information.h"
+#include "lc_clipping.h"
 #include "lc_quadratic.h"
 
 /**
@@ -114,10 +113,19 @@ void RS_Entity::resetBorders() {
 void RS_Entity::moveBorders(const RS_Vector& offset){
 	minV.move(offset);
 	maxV.move(offset);
+	bordersChanged();
 }
 void RS_Entity::scaleBorders(const RS_Vector& center, const RS_Vector& factor){
 	minV.scale(center,factor);
 	maxV.scale(center,factor);
+	bordersChanged();
+}
+
+
+void RS_Entity::bordersChanged() {
+	if (parent) {
+		parent->entityBordersChanged(this);
+	}
 }
 
 
@@ -281,25 +289,42 @@ bool RS_Entity::isArc() const
 	 }
  }
 
+bool RS_Entity::isCullable() const
+{
+	return !isConstruction(true);
+}
+
 /** whether the entity's bounding box intersects with visible portion of graphic view */
 bool RS_Entity::isVisibleInWindow(RS_GraphicView* view) const
 {
-    RS_Vector vpMin(view->toGraph(0,view->getHeight()));
-    RS_Vector vpMax(view->toGraph(view->getWidth(),0));
-    if( getStartpoint().isInWindowOrdered(vpMin, vpMax) ) return true;
-    if( getEndpoint().isInWindowOrdered(vpMin, vpMax) ) return true;
-    QPolygonF visualBox(QRectF(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y));
-	std::vector<RS_Vector> vps;
-    for(unsigned short i=0;i<4;i++){
-        const QPointF& vp(visualBox.at(i));
-		vps.push_back(RS_Vector(vp.x(),vp.y()));
+    // a margin of a few pixels keeps wide pens and handles at the edges
+    const int margin = 8;
+    RS_Vector vpMin(view->toGraph(-margin,view->getHeight()+margin));
+    RS_Vector vpMax(view->toGraph(view->getWidth()+margin,-margin));
+    if (maxV.x < vpMin.x || minV.x > vpMax.x
+            || maxV.y < vpMin.y || minV.y > vpMax.y) return false;
+    // only lines and arcs are clipped more precisely, sub-entities of
+    // containers are tested when the container draws them
+    double pieces[2*LC_Clipping::maxArcPieces];
+    switch (rtti()) {
+    case RS2::EntityLine: {
+        double t1 = 0., t2 = 1.;
+        return LC_Clipping::clipLine(getStartpoint(), getEndpoint(),
+                                     vpMin, vpMax, t1, t2);
     }
-    for(unsigned short i=0;i<4;i++){
-		RS_Line const line(NULL,RS_LineData(vps.at(i),vps.at((i+1)%4)));
-		if( RS_Information::getIntersection(this, &line, true).size()>0) return true;
+    case RS2::EntityArc: {
+        RS_Arc const* arc = static_cast<RS_Arc const*>(this);
+        double const baseAngle = arc->isReversed() ? arc->getAngle2() : arc->getAngle1();
+        return LC_Clipping::clipArc(arc->getCenter(), arc->getRadius(),
+                                    baseAngle, arc->getAngleLength(),
+                                    vpMin, vpMax, pieces) > 0;
+    }
+    case RS2::EntityCircle:
+        return LC_Clipping::clipArc(getCenter(), getRadius(), 0., 2.*M_PI,
+                                    vpMin, vpMax, pieces) > 0;
+    default:
+        return true;
     }
-    if( minV.isInWindowOrdered(vpMin,vpMax)||maxV.isInWindowOrdered(vpMin,vpMax)) return true;
-    return false;
 }
 
 /**
@@ -750,6 +775,9 @@ void RS_Entity::setLayer(const QString& name) {
     } else {
         layer = NULL;
     }
+    if (parent) {
+        parent->entityLayerChanged(this);
+    }
 }
 
 
@@ -759,6 +787,9 @@ void RS_Entity::setLayer(const QString& name) {
  */
 void RS_Entity::setLayer(RS_Layer* l) {
     layer = l;
+    if (parent) {
+        parent->entityLayerChanged(this);
+    }
 }
 
 
@@ -776,6 +807,9 @@ void RS_Entity::setLayerToActive() {
     } else {
         layer = NULL;
     }
+    if (parent) {
+        parent->entityLayerChanged(this);
+    }
 }
 
 
@@ -503,8 +503,16 @@ public:
 
     /** whether the entity's bounding box intersects with visible portion of graphic view */
     virtual bool isVisibleInWindow(RS_GraphicView* view) const;
+    /**
+     * @return false, if the entity must be drawn even if its borders are
+     * outside of the viewport, e.g. overlays in screen coordinates and
+     * lines on construction layers, which are extended to the view border
+     */
+    virtual bool isCullable() const;
     /**
      * Implementations must draw the entity on the given device.
+     * The entity must not be modified, as several views can draw it at
+     * the same time on render threads.
      */
     virtual void draw(RS_Painter* painter, RS_GraphicView* view,
                       double& patternOffset ) = 0;
@@ -580,6 +588,12 @@ protected:
     //! auto updating enabled?
     bool updateEnabled;
 
+    /**
+     * Tells the parent that the borders of this entity were recalculated,
+     * so its spatial index follows entities modified in place.
+     */
+    void bordersChanged();
+
 private:
 	std::map<QString, QString> varList;
 };
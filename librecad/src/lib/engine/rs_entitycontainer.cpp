@@ -26,11 +26,13 @@
 
 
 #include <cmath>
+#include <memory>
 #include <QObject>
 
 #include "rs_dialogfactory.h"
 #include "qg_dialogfactory.h"
 #include "rs_entitycontainer.h"
+#include "lc_endpointindex.h"
 
 #include "rs_debug.h"
 #include "rs_dimension.h"
@@ -39,6 +41,7 @@
 #include "rs_ellipse.h"
 #include "rs_line.h"
 #include "rs_insert.h"
+#include "rs_polyline.h"
 #include "rs_spline.h"
 #include "rs_solid.h"
 #include "rs_information.h"
@@ -60,8 +63,6 @@ RS_EntityContainer::RS_EntityContainer(RS_EntityContainer* parent,
     : RS_Entity(parent) {
 
     autoDelete=owner;
-    RS_DEBUG->print("RS_EntityContainer::RS_EntityContainer: "
-                    "owner: %d", (int)owner);
 	subContainer = nullptr;
     //autoUpdateBorders = true;
     entIdx = -1;
@@ -90,15 +91,8 @@ RS_EntityContainer::~RS_EntityContainer() {
 
 
 RS_Entity* RS_EntityContainer::clone() const{
-    RS_DEBUG->print("RS_EntityContainer::clone: ori autoDel: %d",
-                    autoDelete);
-
     RS_EntityContainer* ec = new RS_EntityContainer(*this);
     ec->setOwner(autoDelete);
-
-    RS_DEBUG->print("RS_EntityContainer::clone: clone autoDel: %d",
-                    ec->isOwner());
-
     ec->detach();
     ec->initId();
 
@@ -114,8 +108,6 @@ RS_Entity* RS_EntityContainer::clone() const{
 void RS_EntityContainer::detach() {
     QList<RS_Entity*> tmp;
     bool autoDel = isOwner();
-    RS_DEBUG->print("RS_EntityContainer::detach: autoDel: %d",
-                    (int)autoDel);
     setOwner(false);
 
 	// make deep copies of all entities:
@@ -134,6 +126,8 @@ void RS_EntityContainer::detach() {
         entities.append(e);
         e->reparent(this);
     }
+    spatialIndex.invalidate();
+    layerIndex.invalidate();
 }
 
 
@@ -269,7 +263,16 @@ void RS_EntityContainer::selectWindow(RS_Vector v1, RS_Vector v2,
                 };
                 RS_VectorSolutions sol;
 
-                if (e->isContainer()) {
+                if (e->rtti()==RS2::EntityPolyline
+                        && static_cast<RS_Polyline*>(e)->isPacked()) {
+                    static_cast<RS_Polyline*>(e)->visitSegments([&](RS_AtomicEntity* se) {
+                        for (int i=0; i<4 && !included; ++i) {
+                            sol = RS_Information::getIntersection(se, &l[i], true);
+                            included = sol.hasValid();
+                        }
+                        return !included;
+                    });
+                } else if (e->isContainer()) {
                     RS_EntityContainer* ec = (RS_EntityContainer*)e;
                     for (RS_Entity* se=ec->firstEntity(RS2::ResolveAll);
 						 se && included==false;
@@ -337,6 +340,8 @@ void RS_EntityContainer::addEntity(RS_Entity* entity) {
     } else {
         entities.append(entity);
     }
+    spatialIndex.insert(entity);
+    layerIndex.insert(entity);
     if (autoUpdateBorders) {
         adjustBorders(entity);
     }
@@ -351,6 +356,8 @@ void RS_EntityContainer::appendEntity(RS_Entity* entity){
     if (entity==NULL)
         return;
     entities.append(entity);
+    spatialIndex.insert(entity);
+    layerIndex.insert(entity);
     if (autoUpdateBorders)
         adjustBorders(entity);
 }
@@ -363,6 +370,8 @@ void RS_EntityContainer::prependEntity(RS_Entity* entity){
     if (entity==NULL)
         return;
     entities.prepend(entity);
+    spatialIndex.insert(entity);
+    layerIndex.insert(entity);
     if (autoUpdateBorders)
         adjustBorders(entity);
 }
@@ -412,6 +421,8 @@ void RS_EntityContainer::insertEntity(int index, RS_Entity* entity) {
     }
 
     entities.insert(index, entity);
+    spatialIndex.insert(entity);
+    layerIndex.insert(entity);
 
     if (autoUpdateBorders) {
         adjustBorders(entity);
@@ -456,6 +467,10 @@ bool RS_EntityContainer::removeEntity(RS_Entity* entity) {
     ret = entities.removeOne(entity);
 #endif
 
+    if (ret) {
+        spatialIndex.remove(entity);
+        layerIndex.remove(entity);
+    }
     if (autoDelete && ret) {
         delete entity;
     }
@@ -476,6 +491,8 @@ void RS_EntityContainer::clear() {
             delete entities.takeFirst();
     } else
         entities.clear();
+    spatialIndex.invalidate();
+    layerIndex.invalidate();
     resetBorders();
 }
 
@@ -545,7 +562,9 @@ void RS_EntityContainer::adjustBorders(RS_Entity* entity) {
 	if (entity) {
         // make sure a container is not empty (otherwise the border
         //   would get extended to 0/0):
-        if (!entity->isContainer() || entity->count()>0) {
+        if (!entity->isContainer() || entity->count()>0
+                || (entity->rtti()==RS2::EntityInsert
+                    && static_cast<RS_Insert*>(entity)->isInstanced())) {
             minV = RS_Vector::minimum(entity->getMin(),minV);
             maxV = RS_Vector::maximum(entity->getMax(),maxV);
         }
@@ -563,8 +582,6 @@ void RS_EntityContainer::adjustBorders(RS_Entity* entity) {
  * Recalculates the borders of this entity container.
  */
 void RS_EntityContainer::calculateBorders() {
-    RS_DEBUG->print("RS_EntityContainer::calculateBorders");
-
 	resetBorders();
 	for (RS_Entity* e: entities){
 
@@ -579,9 +596,6 @@ void RS_EntityContainer::calculateBorders() {
         }
     }
 
-    RS_DEBUG->print("RS_EntityContainer::calculateBorders: size 1: %f,%f",
-                    getSize().x, getSize().y);
-
     // needed for correcting corrupt data (PLANS.dxf)
     if (minV.x>maxV.x || minV.x>RS_MAXDOUBLE || maxV.x>RS_MAXDOUBLE
             || minV.x<RS_MINDOUBLE || maxV.x<RS_MINDOUBLE) {
@@ -596,13 +610,11 @@ void RS_EntityContainer::calculateBorders() {
         maxV.y = 0.0;
     }
 
-    RS_DEBUG->print("RS_EntityCotnainer::calculateBorders: size: %f,%f",
-                    getSize().x, getSize().y);
-
     //RS_DEBUG->print("  borders: %f/%f %f/%f", minV.x, minV.y, maxV.x, maxV.y);
 
     //printf("borders: %lf/%lf  %lf/%lf\n", minV.x, minV.y, maxV.x, maxV.y);
     //RS_Entity::calculateBorders();
+    bordersChanged();
 }
 
 
@@ -614,6 +626,7 @@ void RS_EntityContainer::calculateBorders() {
 void RS_EntityContainer::forcedCalculateBorders() {
     //RS_DEBUG->print("RS_EntityContainer::calculateBorders");
 
+	spatialIndex.invalidate();
 	resetBorders();
 	for (RS_Entity* e: entities){
 
@@ -645,6 +658,7 @@ void RS_EntityContainer::forcedCalculateBorders() {
 
     //printf("borders: %lf/%lf  %lf/%lf\n", minV.x, minV.y, maxV.x, maxV.y);
     //RS_Entity::calculateBorders();
+    bordersChanged();
 }
 
 
@@ -674,6 +688,7 @@ void RS_EntityContainer::updateDimensions(bool autoText) {
         }
     }
 
+    spatialIndex.invalidate();
     RS_DEBUG->print("RS_EntityContainer::updateDimensions() OK");
 }
 
@@ -695,6 +710,7 @@ void RS_EntityContainer::updateInserts() {
         }
     }
 
+    spatialIndex.invalidate();
     RS_DEBUG->print("RS_EntityContainer::updateInserts() OK");
 }
 
@@ -715,7 +731,8 @@ void RS_EntityContainer::renameInserts(const QString& oldName,
 	for (RS_Entity* e: entities){
         if (e->rtti()==RS2::EntityInsert) {
             RS_Insert* i = ((RS_Insert*)e);
-            if (i->getName()==oldName) {
+            // block names are case insensitive, see RS_BlockList::find()
+            if (QString::compare(i->getName(), oldName, Qt::CaseInsensitive)==0) {
                 i->setName(newName);
             }
         } else if (e->isContainer()) {
@@ -743,6 +760,7 @@ void RS_EntityContainer::updateSplines() {
         }
     }
 
+    spatialIndex.invalidate();
     RS_DEBUG->print("RS_EntityContainer::updateSplines() OK");
 }
 
@@ -754,6 +772,7 @@ void RS_EntityContainer::update() {
 	for (RS_Entity* e: entities){
 		e->update();
     }
+    spatialIndex.invalidate();
 }
 
 
@@ -1113,6 +1132,8 @@ void RS_EntityContainer::setEntityAt(int index,RS_Entity* en){
 		delete entities.at(index);
 	}
 	entities[index] = en;
+	spatialIndex.invalidate();
+	layerIndex.invalidate();
 }
 
 /**
@@ -1144,8 +1165,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-	for (RS_Entity* en: entities){
-
+	visitByDistance(coord, [&](RS_Entity* en, double boxDist) {
+		if (boxDist >= minDist) return false;
 		if (en->isVisible()
 				&& !en->getParent()->ignoredOnModification()
 				){//no end point for Insert, text, Dim
@@ -1158,7 +1179,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                 }
             }
         }
-    }
+		return true;
+	});
 
     return closestPoint;
 }
@@ -1182,10 +1204,9 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
     //while ( (en = it.current()) != NULL ) {
     //    ++it;
 
-    unsigned i0=0;
-	for(auto en: entities){
+	visitByDistance(coord, [&](RS_Entity* en, double boxDist) {
+		if (boxDist >= minDist) return false;
 		if (!en->getParent()->ignoredOnModification() ){//no end point for Insert, text, Dim
-//            std::cout<<"find nearest for entity "<<i0<<std::endl;
             point = en->getNearestEndpoint(coord, &curDist);
             if (point.valid && curDist<minDist) {
                 closestPoint = point;
@@ -1198,8 +1219,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                 }
             }
         }
-        i0++;
-    }
+		return true;
+	});
 
 //    std::cout<<__FILE__<<" : "<<__func__<<" : line "<<__LINE__<<std::endl;
 //    std::cout<<"count()="<<const_cast<RS_EntityContainer*>(this)->count()<<"\tminDist= "<<minDist<<"\tclosestPoint="<<closestPoint;
@@ -1235,8 +1256,8 @@ RS_Vector RS_EntityContainer::getNearestCenter(const RS_Vector& coord,
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-	for(auto en: entities){
-
+	visitByDistance(coord, [&](RS_Entity* en, double boxDist) {
+		if (boxDist >= minDist) return false;
         if (en->isVisible()
 				&& !en->getParent()->ignoredOnModification()
 				){//no center point for spline, text, Dim
@@ -1246,7 +1267,8 @@ RS_Vector RS_EntityContainer::getNearestCenter(const RS_Vector& coord,
                 minDist = curDist;
             }
         }
-    }
+		return true;
+	});
 	if (dist) {
         *dist = minDist;
     }
@@ -1265,8 +1287,8 @@ RS_Vector RS_EntityContainer::getNearestMiddle(const RS_Vector& coord,
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-	for(auto en: entities){
-
+	visitByDistance(coord, [&](RS_Entity* en, double boxDist) {
+		if (boxDist >= minDist) return false;
         if (en->isVisible()
 				&& !en->getParent()->ignoredOnModification()
 				){//no midle point for spline, text, Dim
@@ -1276,7 +1298,8 @@ RS_Vector RS_EntityContainer::getNearestMiddle(const RS_Vector& coord,
                 minDist = curDist;
             }
         }
-    }
+		return true;
+	});
 	if (dist) {
         *dist = minDist;
     }
@@ -1304,43 +1327,132 @@ RS_Vector RS_EntityContainer::getNearestDist(double distance,
 
 
 
+namespace {
+bool overlaps(RS_Entity const* e, const RS_Vector& vMin, const RS_Vector& vMax)
+{
+	if (e->rtti()==RS2::EntityConstructionLine) return true;
+	RS_Vector const& eMin = e->getMin();
+	RS_Vector const& eMax = e->getMax();
+	if (!eMin.valid || !eMax.valid) return true;
+	return eMax.x >= vMin.x && eMin.x <= vMax.x
+			&& eMax.y >= vMin.y && eMin.y <= vMax.y;
+}
+
+//! @return e if it is a packed polyline, intersected segment by segment
+RS_Polyline const* packedPolyline(RS_Entity const* e)
+{
+	if (e->rtti()!=RS2::EntityPolyline) return nullptr;
+	RS_Polyline const* pl = static_cast<RS_Polyline const*>(e);
+	return pl->isPacked() ? pl : nullptr;
+}
+
+bool isIntersectionCandidate(RS_Entity const* e, const RS_Vector& vMin, const RS_Vector& vMax)
+{
+	return e->isVisible() && !e->getParent()->ignoredOnModification()
+			&& overlaps(e, vMin, vMax);
+}
+
+/**
+ * Adds the entities of e, resolved with RS2::ResolveAllButTextImage,
+ * whose borders overlap the window vMin, vMax.
+ */
+void addIntersectionCandidates(RS_Entity* e, const RS_Vector& vMin, const RS_Vector& vMax,
+							   std::vector<RS_Entity*>& candidates)
+{
+	if (!overlaps(e, vMin, vMax)) return;
+	if (e->isContainer() && e->rtti()!=RS2::EntityText && e->rtti()!=RS2::EntityMText
+			&& !packedPolyline(e)) {
+		RS_EntityContainer* ec = static_cast<RS_EntityContainer*>(e);
+		for (RS_Entity* sub = ec->firstEntity(RS2::ResolveAllButTextImage);
+			 sub;
+			 sub = ec->nextEntity(RS2::ResolveAllButTextImage)) {
+			if (isIntersectionCandidate(sub, vMin, vMax))
+				candidates.push_back(sub);
+		}
+		return;
+	}
+	if (isIntersectionCandidate(e, vMin, vMax))
+		candidates.push_back(e);
+}
+}
+
 /**
  * @return The intersection which is closest to 'coord'
+ *
+ * Only entities with borders overlapping the entity closest to coord
+ * are intersected with it. Packed polylines are not unpacked, their
+ * segments are intersected one by one.
  */
 RS_Vector RS_EntityContainer::getNearestIntersection(const RS_Vector& coord,
                                                      double* dist) {
 
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
-    double curDist = RS_MAXDOUBLE;  // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
-    RS_Vector point;                // endpoint found
-    RS_VectorSolutions sol;
-    RS_Entity* closestEntity;
-
-    closestEntity = getNearestEntity(coord, NULL, RS2::ResolveAllButTextImage);
+    RS_Entity* closestEntity = getNearestEntity(coord, NULL, RS2::ResolveNone);
+    // copy of the closest segment of a packed polyline:
+    std::unique_ptr<RS_Entity> segment;
+    RS_Polyline const* segmentParent = closestEntity ? packedPolyline(closestEntity) : nullptr;
+    int segmentIndex = -1;
+    if (segmentParent) {
+        segment = segmentParent->getNearestSegment(coord, &segmentIndex);
+        closestEntity = segment.get();
+    } else {
+        closestEntity = getNearestEntity(coord, NULL, RS2::ResolveAllButTextImage);
+    }
 
 	if (closestEntity) {
-        for (RS_Entity* en = firstEntity(RS2::ResolveAllButTextImage);
-             en;
-             en = nextEntity(RS2::ResolveAllButTextImage)) {
-            if (
-                    !en->isVisible()
-					|| en->getParent()->ignoredOnModification()
-                    ){
-                continue;
-            }
-
-            sol = RS_Information::getIntersection(closestEntity,
-                                                  en,
-                                                  true);
-
-            point=sol.getClosest(coord,&curDist,NULL);
-            if(sol.getNumber()>0 && curDist<minDist){
-                closestPoint=point;
-                minDist=curDist;
-            }
-
-        }
+		// broad phase:
+		RS_Vector vMin = closestEntity->getMin();
+		RS_Vector vMax = closestEntity->getMax();
+		std::vector<RS_Entity*> candidates;
+		if (closestEntity->rtti()==RS2::EntityConstructionLine
+				|| !vMin.valid || !vMax.valid) {
+			vMin = RS_Vector(-RS_MAXDOUBLE, -RS_MAXDOUBLE);
+			vMax = RS_Vector(RS_MAXDOUBLE, RS_MAXDOUBLE);
+			for (RS_Entity* e: entities)
+				addIntersectionCandidates(e, vMin, vMax, candidates);
+		} else {
+			// intersections may be found slightly outside of the borders
+			RS_Vector const margin(RS_TOLERANCE*1e4, RS_TOLERANCE*1e4);
+			vMin -= margin;
+			vMax += margin;
+			if (entities.size() < LC_SpatialIndex::minimumEntities) {
+				for (RS_Entity* e: entities)
+					addIntersectionCandidates(e, vMin, vMax, candidates);
+			} else {
+				if (!spatialIndex.isValid())
+					spatialIndex.build(entities);
+				for (RS_Entity* e: spatialIndex.entitiesInWindow(vMin, vMax))
+					addIntersectionCandidates(e, vMin, vMax, candidates);
+			}
+		}
+
+		// narrow phase:
+		auto intersect = [&](RS_Entity const* en) {
+			double curDist = RS_MAXDOUBLE;
+			RS_VectorSolutions const sol =
+					RS_Information::getIntersection(closestEntity, en, true);
+			RS_Vector const point = sol.getClosest(coord, &curDist, NULL);
+			if (sol.getNumber()>0 && curDist<minDist) {
+				closestPoint = point;
+				minDist = curDist;
+			}
+		};
+		for (RS_Entity* en: candidates) {
+			RS_Polyline const* pl = packedPolyline(en);
+			if (pl==nullptr) {
+				intersect(en);
+				continue;
+			}
+			int i = 0;
+			pl->visitSegments([&](RS_AtomicEntity* se) {
+				// the closest segment itself is skipped
+				if (pl!=segmentParent || i!=segmentIndex)
+					intersect(se);
+				++i;
+				return true;
+			});
+		}
     }
 	if(dist && closestPoint.valid) {
         *dist = minDist;
@@ -1359,8 +1471,8 @@ RS_Vector RS_EntityContainer::getNearestRef(const RS_Vector& coord,
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-	for(auto en: entities){
-
+	visitByDistance(coord, [&](RS_Entity* en, double boxDist) {
+		if (boxDist >= minDist) return false;
         if (en->isVisible()) {
             point = en->getNearestRef(coord, &curDist);
             if (point.valid && curDist<minDist) {
@@ -1371,7 +1483,8 @@ RS_Vector RS_EntityContainer::getNearestRef(const RS_Vector& coord,
                 }
             }
         }
-    }
+		return true;
+	});
 
     return closestPoint;
 }
@@ -1408,24 +1521,22 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
                                               RS2::ResolveLevel level,
                                               double solidDist) const{
 
-    RS_DEBUG->print("RS_EntityContainer::getDistanceToPoint");
-
-
     double minDist = RS_MAXDOUBLE;      // minimum measured distance
     double curDist;                     // currently measured distance
     RS_Entity* closestEntity = NULL;    // closest entity found
     RS_Entity* subEntity = NULL;
+    // sub-entities are only asked for if the caller wants them, so
+    // containers creating their entities on demand don't have to:
+    bool const resolve = level==RS2::ResolveAll
+            || level==RS2::ResolveAllButTextImage;
 
-	for(auto e: entities){
-
+	visitByDistance(coord, [&](RS_Entity* e, double boxDist) {
+		if (boxDist >= minDist) return false;
         if (e->isVisible()) {
-            RS_DEBUG->print("entity: getDistanceToPoint");
-            RS_DEBUG->print("entity: %d", e->rtti());
             // bug#426, need to ignore Images to find nearest intersections
-            if(level==RS2::ResolveAllButTextImage && e->rtti()==RS2::EntityImage) continue;
-            curDist = e->getDistanceToPoint(coord, &subEntity, level, solidDist);
-
-            RS_DEBUG->print("entity: getDistanceToPoint: OK");
+            if(level==RS2::ResolveAllButTextImage && e->rtti()==RS2::EntityImage) return true;
+            curDist = e->getDistanceToPoint(coord, resolve ? &subEntity : NULL,
+                                            level, solidDist);
 
             if (curDist<minDist) {
                 switch(level){
@@ -1439,12 +1550,12 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
                 minDist = curDist;
             }
         }
-    }
+		return true;
+	});
 
 	if (entity) {
         *entity = closestEntity;
     }
-    RS_DEBUG->print("RS_EntityContainer::getDistanceToPoint: OK");
 
     return minDist;
 }
@@ -1455,8 +1566,6 @@ RS_Entity* RS_EntityContainer::getNearestEntity(const RS_Vector& coord,
                                                 double* dist,
 												RS2::ResolveLevel level) const{
 
-    RS_DEBUG->print("RS_EntityContainer::getNearestEntity");
-
     RS_Entity* e = NULL;
 
     // distance for points inside solids:
@@ -1475,7 +1584,6 @@ RS_Entity* RS_EntityContainer::getNearestEntity(const RS_Vector& coord,
 	if (dist) {
         *dist = d;
     }
-    RS_DEBUG->print("RS_EntityContainer::getNearestEntity: OK");
 
     return e;
 }
@@ -1499,12 +1607,14 @@ bool RS_EntityContainer::optimizeContours() {
 //    std::cout<<"loop with count()="<<count()<<std::endl;
     RS_DEBUG->print("RS_EntityContainer::optimizeContours");
 
-    RS_EntityContainer tmp;
+    // sorted entities, moved to this container at the end
+    RS_EntityContainer tmp(nullptr, false);
     tmp.setAutoUpdateBorders(false);
     bool closed=true;
 
     /** accept all full circles **/
     QList<RS_Entity*> enList;
+    std::vector<RS_Entity*> edges;
 	for(auto e1: entities){
         if (!e1->isEdge() || e1->isContainer() ) {
             enList<<e1;
@@ -1514,31 +1624,51 @@ bool RS_EntityContainer::optimizeContours() {
         //detect circles and whole ellipses
         switch(e1->rtti()){
         case RS2::EntityEllipse:
-			if(static_cast<RS_Ellipse*>(e1)->isEllipticArc())
-                continue;
+			if(static_cast<RS_Ellipse*>(e1)->isEllipticArc()) {
+                edges.push_back(e1);
+                break;
+            }
         case RS2::EntityCircle:
             //directly detect circles, bug#3443277
             tmp.addEntity(e1->clone());
             enList<<e1;
+            break;
         default:
-            continue;
+            edges.push_back(e1);
         }
 
     }
     //    std::cout<<"RS_EntityContainer::optimizeContours: 1"<<std::endl;
 
     /** remove unsupported entities */
-    for(RS_Entity* it: enList)
-        removeEntity(it);
+    if (autoDelete) {
+        qDeleteAll(enList);
+    }
+    entities.clear();
+    spatialIndex.invalidate();
+    layerIndex.invalidate();
+
+    // end points of the edges not connected yet
+    LC_EndpointIndex endpoints(1e-8);
+    for (RS_Entity* e: edges) {
+        endpoints.insert(e);
+    }
+    // first edge not connected yet, in list order
+    size_t first=0;
+    auto firstEdge = [&]() -> RS_Entity* {
+        while (first<edges.size() && !endpoints.contains(edges[first])) {
+            ++first;
+        }
+        return first<edges.size() ? edges[first] : nullptr;
+    };
 
     /** check and form a closed contour **/
 //    std::cout<<"RS_EntityContainer::optimizeContours: 2"<<std::endl;
     /** the first entity **/
-    RS_Entity* current(NULL);
-    if(count()>0) {
-        current=entityAt(0)->clone();
-        tmp.addEntity(current);
-        removeEntity(entityAt(0));
+    RS_Entity* current(firstEdge());
+    if(current) {
+        tmp.addEntity(current->clone());
+        endpoints.remove(current);
     }else {
         if(tmp.count()==0) return false;
     }
@@ -1549,40 +1679,44 @@ bool RS_EntityContainer::optimizeContours() {
         vpStart=current->getStartpoint();
         vpEnd=current->getEndpoint();
     }
-    RS_Entity* next(NULL);
 //    std::cout<<"RS_EntityContainer::optimizeContours: 4"<<std::endl;
     /** connect entities **/
     const QString errMsg=QObject::tr("Hatch failed due to a gap=%1 between (%2, %3) and (%4, %5)");
 
-    while(count()>0){
-        double dist(0.);
-        RS_Vector&& vpTmp=getNearestEndpoint(vpEnd,&dist,&next);
-        if(dist>1e-8) {
+    while(endpoints.size()>0){
+        RS_Entity* next=endpoints.nearest(vpEnd);
+        if(!next) {
             if(vpEnd.squaredTo(vpStart)<1e-8){
-                RS_Entity* e2=entityAt(0);
+                RS_Entity* e2=firstEdge();
                 tmp.addEntity(e2->clone());
                 vpStart=e2->getStartpoint();
                 vpEnd=e2->getEndpoint();
-                removeEntity(e2);
+                endpoints.remove(e2);
                 continue;
             }
+            // report the gap to the nearest end point
+            double dist(RS_MAXDOUBLE);
+            RS_Vector vpTmp(false);
+            for (size_t i=first; i<edges.size(); ++i) {
+                if (!endpoints.contains(edges[i])) continue;
+                double curDist;
+                RS_Vector const& vp=edges[i]->getNearestEndpoint(vpEnd, &curDist);
+                if (vp.valid && curDist<dist) {
+                    dist=curDist;
+                    vpTmp=vp;
+                }
+            }
             QG_DIALOGFACTORY->commandMessage(errMsg.arg(dist).arg(vpTmp.x).arg(vpTmp.y).arg(vpEnd.x).arg(vpEnd.y));
             closed=false;
+            break;
         }
-        if(next && closed){ 			//workaround if next is NULL
-            next->setProcessed(true);
-            RS_Entity* eTmp = next->clone();
-            if(vpEnd.squaredTo(eTmp->getStartpoint())>vpEnd.squaredTo(eTmp->getEndpoint()))
-                eTmp->revertDirection();
-            vpEnd=eTmp->getEndpoint();
-            tmp.addEntity(eTmp);
-        	removeEntity(next);
-        } else { 			//workaround if next is NULL
-//      	    std::cout<<"RS_EntityContainer::optimizeContours: next is NULL" <<std::endl;
-
-        	closed=false;	//workaround if next is NULL
-        	break;			//workaround if next is NULL
-        } 					//workaround if next is NULL
+        next->setProcessed(true);
+        RS_Entity* eTmp = next->clone();
+        if(vpEnd.squaredTo(eTmp->getStartpoint())>vpEnd.squaredTo(eTmp->getEndpoint()))
+            eTmp->revertDirection();
+        vpEnd=eTmp->getEndpoint();
+        tmp.addEntity(eTmp);
+        endpoints.remove(next);
     }
 //    DEBUG_HEADER
     if(vpEnd.valid && vpEnd.squaredTo(vpStart)>1e-8) {
@@ -1592,11 +1726,22 @@ bool RS_EntityContainer::optimizeContours() {
     }
 //    std::cout<<"RS_EntityContainer::optimizeContours: 5"<<std::endl;
 
+    // keep the edges which could not be connected:
+    for (RS_Entity* e: edges) {
+        if (endpoints.contains(e)) {
+            entities.append(e);
+        } else if (autoDelete) {
+            delete e;
+        }
+    }
+    if (autoUpdateBorders) {
+        calculateBorders();
+    }
 
     // add new sorted entities:
 	for(auto en: tmp){
 		en->setProcessed(false);
-        addEntity(en->clone());
+        addEntity(en);
     }
 //    std::cout<<"RS_EntityContainer::optimizeContours: 6"<<std::endl;
 
@@ -1607,6 +1752,57 @@ bool RS_EntityContainer::optimizeContours() {
 }
 
 
+void RS_EntityContainer::invalidateSpatialIndex() const
+{
+	spatialIndex.invalidate();
+}
+
+
+void RS_EntityContainer::entityModified(RS_Entity* entity)
+{
+	spatialIndex.remove(entity);
+	spatialIndex.insert(entity);
+	if (autoUpdateBorders) {
+		adjustBorders(entity);
+	}
+}
+
+
+void RS_EntityContainer::entityBordersChanged(RS_Entity* entity)
+{
+	spatialIndex.update(entity);
+}
+
+
+std::vector<RS_Entity*> RS_EntityContainer::getLayerEntities(RS_Layer* layer) const
+{
+	if (!layerIndex.isValid())
+		layerIndex.build(entities);
+	return layerIndex.entities(layer);
+}
+
+
+void RS_EntityContainer::entityLayerChanged(RS_Entity* entity)
+{
+	layerIndex.update(entity);
+}
+
+
+void RS_EntityContainer::visitByDistance(const RS_Vector& coord,
+										 const std::function<bool(RS_Entity*, double)>& visitor) const
+{
+	if (entities.size() < LC_SpatialIndex::minimumEntities) {
+		for (RS_Entity* e: entities) {
+			if (!visitor(e, 0.)) return;
+		}
+		return;
+	}
+	if (!spatialIndex.isValid())
+		spatialIndex.build(entities);
+	spatialIndex.visitNearest(coord, visitor);
+}
+
+
 bool RS_EntityContainer::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2) {
 	for(auto e: entities){
         if (e->hasEndpointsWithinWindow(v1, v2))  {
@@ -1619,6 +1815,7 @@ bool RS_EntityContainer::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_
 
 
 void RS_EntityContainer::move(const RS_Vector& offset) {
+    spatialIndex.invalidate();
 	for(auto e: entities){
 
         e->move(offset);
@@ -1635,6 +1832,7 @@ void RS_EntityContainer::move(const RS_Vector& offset) {
 
 void RS_EntityContainer::rotate(const RS_Vector& center, const double& angle) {
     RS_Vector angleVector(angle);
+    spatialIndex.invalidate();
 
 	for(auto e: entities){
         e->rotate(center, angleVector);
@@ -1646,6 +1844,7 @@ void RS_EntityContainer::rotate(const RS_Vector& center, const double& angle) {
 
 
 void RS_EntityContainer::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
+    spatialIndex.invalidate();
 
 	for(auto e: entities){
         e->rotate(center, angleVector);
@@ -1657,6 +1856,7 @@ void RS_EntityContainer::rotate(const RS_Vector& center, const RS_Vector& angleV
 
 
 void RS_EntityContainer::scale(const RS_Vector& center, const RS_Vector& factor) {
+    spatialIndex.invalidate();
     if (fabs(factor.x)>RS_TOLERANCE && fabs(factor.y)>RS_TOLERANCE) {
 
 		for(auto e: entities){
@@ -1671,6 +1871,7 @@ void RS_EntityContainer::scale(const RS_Vector& center, const RS_Vector& factor)
 
 
 void RS_EntityContainer::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2) {
+    spatialIndex.invalidate();
     if (axisPoint1.distanceTo(axisPoint2)>1.0e-6) {
 
 		for(auto e: entities){
@@ -1684,6 +1885,7 @@ void RS_EntityContainer::stretch(const RS_Vector& firstCorner,
                                  const RS_Vector& secondCorner,
                                  const RS_Vector& offset) {
 
+    spatialIndex.invalidate();
     if (getMin().isInWindow(firstCorner, secondCorner) &&
             getMax().isInWindow(firstCorner, secondCorner)) {
 
@@ -1704,7 +1906,7 @@ void RS_EntityContainer::stretch(const RS_Vector& firstCorner,
 void RS_EntityContainer::moveRef(const RS_Vector& ref,
                                  const RS_Vector& offset) {
 
-
+    spatialIndex.invalidate();
 	for(auto e: entities){
         e->moveRef(ref, offset);
     }
@@ -1717,7 +1919,7 @@ void RS_EntityContainer::moveRef(const RS_Vector& ref,
 void RS_EntityContainer::moveSelectedRef(const RS_Vector& ref,
                                          const RS_Vector& offset) {
 
-
+    spatialIndex.invalidate();
 	for(auto e: entities){
         e->moveSelectedRef(ref, offset);
     }
@@ -1734,6 +1936,7 @@ void RS_EntityContainer::revertDirection() {
 	for(RS_Entity*const entity: entities) {
 		entity->revertDirection();
 	}
+	spatialIndex.invalidate();
 }
 
 /**
@@ -1813,21 +2016,25 @@ bool RS_EntityContainer::ignoredOnModification() const
 
 QList<RS_Entity *>::const_iterator RS_EntityContainer::begin() const
 {
+	prepareEntities();
 	return entities.begin();
 }
 
 QList<RS_Entity *>::const_iterator RS_EntityContainer::end() const
 {
+	prepareEntities();
 	return entities.end();
 }
 
 QList<RS_Entity *>::iterator RS_EntityContainer::begin()
 {
+	prepareEntities();
 	return entities.begin();
 }
 
 QList<RS_Entity *>::iterator RS_EntityContainer::end()
 {
+	prepareEntities();
 	return entities.end();
 }
 
@@ -30,7 +30,10 @@
 
 #include <vector>
 #include <set>
+#include <functional>
 #include "rs_entity.h"
+#include "lc_spatialindex.h"
+#include "lc_layerindex.h"
 
 /**
  * Class representing a tree of entities.
@@ -171,6 +174,26 @@ public:
 
     virtual bool optimizeContours();
 
+    /**
+     * Drops the spatial index of this container. Must be called after
+     * entities were modified in place without addEntity()/removeEntity().
+     */
+    void invalidateSpatialIndex() const;
+    /**
+     * Updates the spatial index and the borders of this container after
+     * the entity of this container was modified in place.
+     */
+    void entityModified(RS_Entity* entity);
+    /** Moves the spatial index entry of entity to its recalculated borders. */
+    virtual void entityBordersChanged(RS_Entity* entity);
+    /**
+     * @return entities of this container with the given layer, without
+     * sub-entities. Uses the layer index, built on the first call.
+     */
+    std::vector<RS_Entity*> getLayerEntities(RS_Layer* layer) const;
+    /** Updates the layer index after the layer of entity was changed. */
+    void entityLayerChanged(RS_Entity* entity);
+
     virtual bool hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2);
 
     virtual void move(const RS_Vector& offset);
@@ -217,6 +240,20 @@ public:
 
 protected:
 
+    /**
+     * Called before the entities are iterated with begin() and end().
+     * Containers which create their entities on demand override this.
+     */
+    virtual void prepareEntities() const {}
+
+    /**
+     * Visits entities in ascending distance of their bounding boxes to
+     * coord, using the spatial index for large containers.
+     * The visitor returns false to stop the search.
+     */
+    void visitByDistance(const RS_Vector& coord,
+                         const std::function<bool(RS_Entity*, double)>& visitor) const;
+
     /** entities in the container */
     QList<RS_Entity *> entities;
 
@@ -229,6 +266,11 @@ protected:
      */
     static bool autoUpdateBorders;
 
+    /** R-tree of entities, built on the first proximity query */
+    mutable LC_SpatialIndex spatialIndex;
+    /** entities by layer, built on the first layer query */
+    mutable LC_LayerIndex layerIndex;
+
 private:
     int entIdx;
     bool autoDelete;
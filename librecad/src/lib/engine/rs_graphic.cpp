@@ -24,8 +24,10 @@
 **
 **********************************************************************/
 
+#include <functional>
 #include <QDir>
 #include <QDebug>
+#include <QHash>
 
 #include "rs_graphic.h"
 #include "rs_dialogfactory.h"
@@ -37,6 +39,7 @@
 #include "rs_settings.h"
 #include "rs_layer.h"
 #include "rs_block.h"
+#include "rs_polyline.h"
 
 
 /**
@@ -101,12 +104,8 @@ unsigned long int RS_Graphic::countLayerEntities(RS_Layer* layer) {
     int c=0;
 
 	if (layer) {
-		for(auto t: entities){
-
-			if (t->getLayer() &&
-                    t->getLayer()->getName()==layer->getName()) {
-                c+=t->countDeep();
-            }
+		for(auto t: getLayerEntities(layer)){
+			c+=t->countDeep();
         }
     }
 
@@ -122,14 +121,8 @@ void RS_Graphic::removeLayer(RS_Layer* layer) {
 
     if (layer && layer->getName()!="0") {
 
-		std::vector<RS_Entity*> toRemove;
 		//find entities on layer
-		for(auto e: entities){
-			if (e->getLayer() &&
-                    e->getLayer()->getName()==layer->getName()) {
-				toRemove.push_back(e);
-            }
-        }
+		std::vector<RS_Entity*> toRemove = getLayerEntities(layer);
 		// remove all entities on that layer:
 		if(toRemove.size()){
 			startUndoCycle();
@@ -145,13 +138,8 @@ void RS_Graphic::removeLayer(RS_Layer* layer) {
         // remove all entities in blocks that are on that layer:
 		for(RS_Block* blk: blockList){
 			if(!blk) continue;
-			for(auto e: *blk){
-
-				if (e->getLayer() &&
-						e->getLayer()->getName()==layer->getName()) {
-					toRemove.push_back(e);
-				}
-			}
+			std::vector<RS_Entity*> const onLayer = blk->getLayerEntities(layer);
+			toRemove.insert(toRemove.end(), onLayer.begin(), onLayer.end());
 		}
 
 		for(auto e: toRemove){
@@ -398,6 +386,110 @@ bool RS_Graphic::save(bool isAutoSave)
 
 
 
+/**
+ * Creates a copy of the drawing for auto-saving it on another thread.
+ *
+ * Layers, blocks and entities are cloned and the clones refer to the
+ * layers and blocks of the copy only, so the drawing can be edited while
+ * the copy is written. The copy is named after the auto-save file and has
+ * no graphic view.
+ *
+ * @return the copy, to be passed to saveSnapshot()
+ */
+RS_Graphic* RS_Graphic::createSnapshot() {
+	RS_DEBUG->print("RS_Graphic::createSnapshot");
+
+	RS_Graphic* g = new RS_Graphic();
+	g->variableDict = variableDict;
+	g->crosshairType = crosshairType;
+	g->paperScaleFixed = paperScaleFixed;
+	g->filename = autosaveFilename;
+	g->formatType = (formatType == RS2::FormatUnknown) ? RS2::FormatDXFRW : formatType;
+
+	QHash<RS_Layer*, RS_Layer*> layers;
+	for (unsigned i = 0; i < layerList.count(); ++i) {
+		RS_Layer* l = layerList.at(i);
+		RS_Layer* lc = l->clone();
+		layers.insert(l, lc);
+		g->layerList.add(lc);
+	}
+	if (layerList.getActive()) {
+		g->layerList.activate(layers.value(layerList.getActive()));
+	}
+
+	// clones still refer to the layers of this drawing. Entities of
+	// inserts are not written, instanced inserts are not expanded for them,
+	// packed polylines are not unpacked and no spline lines are built:
+	std::function<void(RS_Entity*)> mapLayers = [&](RS_Entity* e) {
+		e->setLayer(layers.value(e->getLayer(false), nullptr));
+		if (e->isContainer() && e->rtti()!=RS2::EntityInsert
+				&& e->rtti()!=RS2::EntitySpline
+				&& !(e->rtti()==RS2::EntityPolyline
+					 && static_cast<RS_Polyline*>(e)->isPacked())) {
+			for (RS_Entity* c: *static_cast<RS_EntityContainer*>(e)) {
+				mapLayers(c);
+			}
+		}
+	};
+
+	for (RS_Block* b: blockList) {
+		if (b->isUndone()) continue;
+		RS_Block* bc = static_cast<RS_Block*>(b->clone());
+		bc->setParent(g);
+		for (RS_Entity* e: *bc) {
+			mapLayers(e);
+		}
+		g->blockList.add(bc, false);
+	}
+
+	for (RS_Entity* e: entities) {
+		if (e->isUndone()) continue;
+		RS_Entity* ec = e->clone();
+		ec->setParent(g);
+		mapLayers(ec);
+		g->RS_EntityContainer::addEntity(ec);
+	}
+
+	g->setModified(true);
+	return g;
+}
+
+
+
+/**
+ * Writes a copy made by createSnapshot() and deletes it with its layers
+ * and blocks. Can be called on any thread.
+ *
+ * @return true if the copy was written
+ */
+bool RS_Graphic::saveSnapshot(RS_Graphic* snapshot) {
+	if (!snapshot) return false;
+	RS_DEBUG->print("RS_Graphic::saveSnapshot: File: %s",
+					snapshot->filename.toLatin1().data());
+
+	bool const ret = !snapshot->filename.isEmpty()
+			&& RS_FileIO::instance()->fileExport(*snapshot, snapshot->filename,
+												 snapshot->formatType);
+
+	// layers and blocks are not owned by the lists
+	QList<RS_Layer*> layers;
+	for (unsigned i = 0; i < snapshot->layerList.count(); ++i) {
+		layers << snapshot->layerList.at(i);
+	}
+	QList<RS_Block*> blocks;
+	for (RS_Block* b: snapshot->blockList) {
+		blocks << b;
+	}
+	snapshot->blockList.clear();
+	delete snapshot;
+	qDeleteAll(blocks);
+	qDeleteAll(layers);
+
+	return ret;
+}
+
+
+
 /*
  *	Description:	- Saves this graphic with the given filename and current
  *						  settings.
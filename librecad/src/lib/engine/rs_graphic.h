@@ -69,6 +69,8 @@ public:
 
     virtual void newDoc();
     virtual bool save(bool isAutoSave = false);
+    RS_Graphic* createSnapshot();
+    static bool saveSnapshot(RS_Graphic* snapshot);
     virtual bool saveAs(const QString& filename, RS2::FormatType type, bool force = false);
     virtual bool open(const QString& filename, RS2::FormatType type);
     bool loadTemplate(const QString &filename, RS2::FormatType type);
@@ -23,7 +23,10 @@
 ** This copyright notice MUST APPEAR in all copies of the script!
 **
 **********************************************************************/
+#include <algorithm>
+#include <cmath>
 #include <memory>
+#include <vector>
 #include <QPainterPath>
 #include <QBrush>
 #include <QString>
@@ -42,6 +45,7 @@
 #include "rs_pattern.h"
 #include "rs_patternlist.h"
 #include "rs_math.h"
+#include "lc_trace.h"
 
 
 #if QT_VERSION < 0x040400
@@ -131,27 +135,435 @@ bool RS_Hatch::isContainer() const {
  * Recalculates the borders of this hatch.
  */
 void RS_Hatch::calculateBorders() {
-    RS_DEBUG->print("RS_Hatch::calculateBorders");
-
     activateContour(true);
 
     RS_EntityContainer::calculateBorders();
 
-        RS_DEBUG->print("RS_Hatch::calculateBorders: size: %f,%f",
-                getSize().x, getSize().y);
-
     activateContour(false);
 }
 
 
 
+namespace {
+/** maximum number of hatch lines created by the scan line hatch */
+const size_t maxScanLineEntities = 1000000;
+
+/**
+ * Part of a hatch boundary edge, monotone in the direction normal to the
+ * hatch lines. Lines are single pieces, arcs, circles and ellipses
+ * center + u*cos(t) + v*sin(t) are split at their extremes.
+ */
+struct HatchEdgePiece {
+	RS_Vector p1, p2;
+	// conics only:
+	bool conic;
+	RS_Vector center, u, v;
+	double t1, t2;
+	// offset of the ends normal to the hatch lines
+	double f1, f2;
+
+	double fMin() const {
+		return std::min(f1, f2);
+	}
+	double fMax() const {
+		return std::max(f1, f2);
+	}
+	bool crosses(double c) const {
+		return (f1 <= c) != (f2 <= c);
+	}
+
+	/** @return position along dir where the scan line at offset c crosses */
+	double crossing(double c, const RS_Vector& dir, const RS_Vector& normal) const {
+		if (!conic) {
+			RS_Vector const& p = p1 + (p2 - p1) * ((c - f1) / (f2 - f1));
+			return RS_Vector::dotP(p, dir);
+		}
+		double const a = RS_Vector::dotP(normal, u);
+		double const b = RS_Vector::dotP(normal, v);
+		double const r = std::hypot(a, b);
+		double const phi = std::atan2(b, a);
+		double const x = (c - RS_Vector::dotP(normal, center)) / r;
+		double const alpha = std::acos(std::max(-1., std::min(1., x)));
+		// increasing pieces lie in [phi-pi, phi], decreasing in [phi, phi+pi]
+		double t = (f2 > f1) ? phi - alpha : phi + alpha;
+		t += 2. * M_PI * std::floor((0.5 * (t1 + t2) - t) / (2. * M_PI) + 0.5);
+		RS_Vector const& p = center + u * cos(t) + v * sin(t);
+		return RS_Vector::dotP(p, dir);
+	}
+};
+
+/**
+ * Boundary edge of a hatch, parametrized for splitting into monotone
+ * pieces for any direction of hatch lines.
+ */
+struct HatchEdge {
+	bool conic;
+	RS_Vector p1, p2;
+	RS_Vector center, u, v;
+	double t1, t2;
+
+	/** appends the monotone pieces for hatch lines normal to normal */
+	void split(const RS_Vector& normal, std::vector<HatchEdgePiece>& pieces) const {
+		HatchEdgePiece piece;
+		piece.conic = conic;
+		if (!conic) {
+			piece.p1 = p1;
+			piece.p2 = p2;
+			piece.f1 = RS_Vector::dotP(normal, p1);
+			piece.f2 = RS_Vector::dotP(normal, p2);
+			pieces.push_back(piece);
+			return;
+		}
+		piece.center = center;
+		piece.u = u;
+		piece.v = v;
+		double const nc = RS_Vector::dotP(normal, center);
+		double const a = RS_Vector::dotP(normal, u);
+		double const b = RS_Vector::dotP(normal, v);
+		double const phi = std::atan2(b, a);
+		auto f = [&](double t) {
+			return nc + a * cos(t) + b * sin(t);
+		};
+		// extremes at phi + k*pi:
+		double t = t1;
+		double ext = phi + M_PI * std::floor((t1 - phi) / M_PI + 1.);
+		while (t < t2) {
+			double const te = std::min(ext, t2);
+			piece.t1 = t;
+			piece.t2 = te;
+			piece.f1 = f(t);
+			piece.f2 = f(te);
+			pieces.push_back(piece);
+			t = te;
+			ext += M_PI;
+		}
+	}
+};
+
+/**
+ * @return false, if the boundary contains entities the scan line hatch
+ * can not handle
+ */
+bool hatchBoundary(RS_EntityContainer* contour, std::vector<HatchEdge>& edges)
+{
+	for (RS_Entity* l: *contour) {
+		if (!l->isContainer() || l->getFlag(RS2::FlagTemp)) continue;
+		for (RS_Entity* e: *static_cast<RS_EntityContainer*>(l)) {
+			HatchEdge edge;
+			edge.conic = true;
+			switch (e->rtti()) {
+			case RS2::EntityLine:
+				edge.conic = false;
+				edge.p1 = e->getStartpoint();
+				edge.p2 = e->getEndpoint();
+				break;
+			case RS2::EntityArc: {
+				RS_Arc* arc = static_cast<RS_Arc*>(e);
+				edge.center = arc->getCenter();
+				edge.u = RS_Vector(arc->getRadius(), 0.);
+				edge.v = RS_Vector(0., arc->getRadius());
+				edge.t1 = arc->isReversed() ? arc->getAngle2() : arc->getAngle1();
+				edge.t2 = edge.t1 + RS_Math::correctAngle(arc->isReversed() ?
+							arc->getAngle1() - arc->getAngle2() :
+							arc->getAngle2() - arc->getAngle1());
+				break;
+			}
+			case RS2::EntityCircle: {
+				RS_Circle* circle = static_cast<RS_Circle*>(e);
+				edge.center = circle->getCenter();
+				edge.u = RS_Vector(circle->getRadius(), 0.);
+				edge.v = RS_Vector(0., circle->getRadius());
+				edge.t1 = 0.;
+				edge.t2 = 2. * M_PI;
+				break;
+			}
+			case RS2::EntityEllipse: {
+				RS_Ellipse* ellipse = static_cast<RS_Ellipse*>(e);
+				RS_Vector const& major = ellipse->getMajorP();
+				edge.center = ellipse->getCenter();
+				edge.u = major;
+				edge.v = RS_Vector(-major.y, major.x) * ellipse->getRatio();
+				if (ellipse->isEllipticArc()) {
+					edge.t1 = ellipse->isReversed() ? ellipse->getAngle2() : ellipse->getAngle1();
+					edge.t2 = edge.t1 + RS_Math::correctAngle(ellipse->isReversed() ?
+								ellipse->getAngle1() - ellipse->getAngle2() :
+								ellipse->getAngle2() - ellipse->getAngle1());
+				} else {
+					edge.t1 = 0.;
+					edge.t2 = 2. * M_PI;
+				}
+				break;
+			}
+			default:
+				return false;
+			}
+			edges.push_back(edge);
+		}
+	}
+	return !edges.empty();
+}
+
+/**
+ * Parallel hatch lines made of the pattern lines which lie on the same
+ * lines when the pattern is repeated over the lattice dvx, dvy.
+ *
+ * The lattice has the basis period, shift: line j passes through
+ * base + j*shift and repeats itself after period along dir. The dashes of
+ * line 0 within one period are kept in dashes.
+ */
+struct HatchLineFamily {
+	int k, m;               // period = k*dvx + m*dvy
+	RS_Vector dir;          // unit direction of the lines
+	RS_Vector normal;       // unit normal
+	double offset;          // normal offset of line 0
+	double spacing;         // normal distance from line j to j+1, > 0
+	double dashShift;       // dash shift along dir from line j to j+1
+	double period;          // length of the period along dir
+	std::vector<std::pair<double, double> > dashes;
+
+	/** adds a dash, cut into [0, period) */
+	void addDash(double start, double length) {
+		if (length >= period) {
+			dashes.push_back(std::make_pair(0., period));
+			return;
+		}
+		start -= period * std::floor(start / period);
+		if (start + length <= period) {
+			dashes.push_back(std::make_pair(start, start + length));
+		} else {
+			dashes.push_back(std::make_pair(start, period));
+			dashes.push_back(std::make_pair(0., start + length - period));
+		}
+	}
+
+	/** sorts and merges the dashes */
+	void mergeDashes() {
+		std::sort(dashes.begin(), dashes.end());
+		std::vector<std::pair<double, double> > merged;
+		double const tol = RS_TOLERANCE * period;
+		for (auto const& d: dashes) {
+			if (!merged.empty() && d.first <= merged.back().second + tol) {
+				merged.back().second = std::max(merged.back().second, d.second);
+			} else {
+				merged.push_back(d);
+			}
+		}
+		if (merged.size() == 1 && merged.front().first <= tol
+				&& merged.front().second >= period - tol) {
+			merged.front() = std::make_pair(0., period);
+		}
+		dashes.swap(merged);
+	}
+
+	bool isContinuous() const {
+		return dashes.size() == 1 && dashes.front().first == 0.
+				&& dashes.front().second == period;
+	}
+};
+
+/** @return g=gcd(a,b) and x, y with a*x + b*y = g */
+int extendedGcd(int a, int b, int& x, int& y)
+{
+	if (b == 0) {
+		x = (a >= 0) ? 1 : -1;
+		y = 0;
+		return std::abs(a);
+	}
+	int x1, y1;
+	int const g = extendedGcd(b, a % b, x1, y1);
+	x = y1;
+	y = x1 - (a / b) * y1;
+	return g;
+}
+
+/**
+ * Adds a pattern line to the family of hatch lines it belongs to.
+ *
+ * @return false, if the line does not repeat along its direction within
+ * a small number of pattern cells
+ */
+bool addToFamilies(std::vector<HatchLineFamily>& families, const RS_Line* line,
+				   const RS_Vector& dvx, const RS_Vector& dvy)
+{
+	RS_Vector start = line->getStartpoint();
+	RS_Vector dir = line->getEndpoint() - start;
+	double const length = dir.magnitude();
+	if (length < RS_TOLERANCE) return false;
+	dir /= length;
+
+	// shortest lattice vector along the line:
+	const int maxIndex = 32;
+	int k = 0, m = 0;
+	double period = RS_MAXDOUBLE;
+	for (int i = 0; i <= maxIndex; ++i) {
+		for (int j = -maxIndex; j <= maxIndex; ++j) {
+			if (i == 0 && j <= 0) continue;
+			RS_Vector const& t = dvx * i + dvy * j;
+			double const l = t.magnitude();
+			if (l >= period || std::abs(dir.x * t.y - dir.y * t.x) > 1e-6 * l) continue;
+			k = i;
+			m = j;
+			period = l;
+		}
+	}
+	if (k == 0 && m == 0) return false;
+
+	RS_Vector const& t = dvx * k + dvy * m;
+	if (RS_Vector::dotP(t, dir) < 0.) {
+		start = line->getEndpoint();
+	}
+	dir = t / period;
+	RS_Vector const normal(-dir.y, dir.x);
+
+	for (HatchLineFamily& f: families) {
+		if (f.k != k || f.m != m) continue;
+		double const r = (RS_Vector::dotP(normal, start) - f.offset) / f.spacing;
+		if (std::abs(r - std::round(r)) > 1e-6) continue;
+		f.addDash(RS_Vector::dotP(dir, start) - std::round(r) * f.dashShift, length);
+		return true;
+	}
+
+	// complete the basis of the lattice: p*m - q*k = 1
+	int x, y;
+	if (extendedGcd(m, k, x, y) != 1) return false;
+	RS_Vector shift = dvx * x - dvy * y;
+	double spacing = RS_Vector::dotP(normal, shift);
+	if (std::abs(spacing) < RS_TOLERANCE) return false;
+	if (spacing < 0.) {
+		shift = -shift;
+		spacing = -spacing;
+	}
+
+	HatchLineFamily f;
+	f.k = k;
+	f.m = m;
+	f.dir = dir;
+	f.normal = normal;
+	f.offset = RS_Vector::dotP(normal, start);
+	f.spacing = spacing;
+	f.dashShift = RS_Vector::dotP(dir, shift);
+	f.period = period;
+	f.addDash(RS_Vector::dotP(dir, start), length);
+	families.push_back(f);
+	return true;
+}
+
+/**
+ * Adds the parts of the hatch lines of the family inside the boundary
+ * to hatch. Scan lines are intersected with the boundary pieces crossing
+ * them and the spans between odd and even crossings are kept.
+ *
+ * @return false, if more than maxScanLineEntities lines would be needed
+ */
+bool hatchFamily(const HatchLineFamily& family, const std::vector<HatchEdge>& edges,
+				 RS_EntityContainer* hatch, size_t& count)
+{
+	std::vector<HatchEdgePiece> pieces;
+	for (HatchEdge const& e: edges) {
+		e.split(family.normal, pieces);
+	}
+	if (pieces.empty()) return true;
+	std::sort(pieces.begin(), pieces.end(),
+			  [](const HatchEdgePiece& a, const HatchEdgePiece& b) {
+		return a.fMin() < b.fMin();
+	});
+	double fMax = pieces.front().fMax();
+	for (HatchEdgePiece const& p: pieces) {
+		fMax = std::max(fMax, p.fMax());
+	}
+
+	double const j1 = std::ceil((pieces.front().fMin() - family.offset) / family.spacing);
+	double const j2 = std::floor((fMax - family.offset) / family.spacing);
+	if (j2 - j1 > maxScanLineEntities) return false;
+
+	auto addLine = [&](double u1, double u2, double c) {
+		if (u2 - u1 < RS_TOLERANCE) return true;
+		if (++count > maxScanLineEntities) return false;
+		RS_Vector const& n = family.normal * c;
+		RS_Line* line = new RS_Line(hatch, RS_LineData(n + family.dir * u1,
+													   n + family.dir * u2));
+		line->setPen(RS_Pen(RS2::FlagInvalid));
+		line->setLayer(NULL);
+		hatch->addEntity(line);
+		return true;
+	};
+
+	size_t next = 0;                      // next piece to activate
+	std::vector<const HatchEdgePiece*> active;
+	std::vector<double> crossings;
+	for (double j = j1; j <= j2; j += 1.) {
+		double const c = family.offset + j * family.spacing;
+		while (next < pieces.size() && pieces[next].fMin() <= c) {
+			active.push_back(&pieces[next++]);
+		}
+		active.erase(std::remove_if(active.begin(), active.end(),
+									[c](const HatchEdgePiece* p) {
+			return p->fMax() < c;
+		}), active.end());
+
+		crossings.clear();
+		for (const HatchEdgePiece* p: active) {
+			if (p->crosses(c)) {
+				crossings.push_back(p->crossing(c, family.dir, family.normal));
+			}
+		}
+		std::sort(crossings.begin(), crossings.end());
+
+		double const shift = j * family.dashShift;
+		for (size_t i = 1; i < crossings.size(); i += 2) {
+			double const s1 = crossings[i - 1];
+			double const s2 = crossings[i];
+			if (family.isContinuous()) {
+				if (!addLine(s1, s2, c)) return false;
+				continue;
+			}
+			for (auto const& d: family.dashes) {
+				double const b = d.first + shift;
+				double const e = d.second + shift;
+				double n1 = std::ceil((s1 - e) / family.period);
+				double const n2 = std::floor((s2 - b) / family.period);
+				for (; n1 <= n2; n1 += 1.) {
+					double const o = n1 * family.period;
+					if (!addLine(std::max(s1, b + o), std::min(s2, e + o), c)) return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+}
+
+
+
+/**
+ * Orders the edges of the loops of a solid hatch for drawing them as a
+ * polygon and puts the loops on the layer of the hatch.
+ */
+void RS_Hatch::prepareLoops() {
+    for(auto l: entities){
+        l->setLayer(getLayer());
+        if (l->rtti()!=RS2::EntityContainer) {
+            continue;
+        }
+        RS_EntityContainer* loop = static_cast<RS_EntityContainer*>(l);
+        if (needOptimization) {
+            loop->optimizeContours();
+        }
+        for(auto e: *loop){
+            e->setLayer(getLayer());
+        }
+    }
+    needOptimization = false;
+}
+
+
+
 /**
  * Updates the Hatch. Called when the
  * hatch or it's data, position, alignment, .. changes.
  */
 void RS_Hatch::update() {
-        RS_DEBUG->print("RS_Hatch::update");
-        RS_DEBUG->print("RS_Hatch::update: contour has %d loops", count());
+    LC_TRACE_SCOPE_ARG("update", "RS_Hatch::update", data.pattern.toStdString());
 
     updateError = HATCH_OK;
     if (updateRunning) {
@@ -163,11 +575,11 @@ void RS_Hatch::update() {
     }
 
     if (data.solid==true) {
+        prepareLoops();
         calculateBorders();
         return;
     }
 
-    RS_DEBUG->print("RS_Hatch::update");
     updateRunning = true;
 
     // delete old hatch:
@@ -190,7 +602,6 @@ void RS_Hatch::update() {
     }
 
     // search pattern:
-    RS_DEBUG->print("RS_Hatch::update: requesting pattern");
     RS_Pattern* pat = RS_PATTERNLIST->requestPattern(data.pattern);
     if (pat==NULL) {
         updateRunning = false;
@@ -198,18 +609,12 @@ void RS_Hatch::update() {
         updateError = HATCH_PATTERN_NOT_FOUND;
         return;
     }
-    RS_DEBUG->print("RS_Hatch::update: requesting pattern: OK");
-
-    RS_DEBUG->print("RS_Hatch::update: cloning pattern");
     pat = (RS_Pattern*)pat->clone();
-    RS_DEBUG->print("RS_Hatch::update: cloning pattern: OK");
 
     // scale pattern
-    RS_DEBUG->print("RS_Hatch::update: scaling pattern");
     pat->scale(RS_Vector(0.0,0.0), RS_Vector(data.scale, data.scale));
     pat->calculateBorders();
     forcedCalculateBorders();
-    RS_DEBUG->print("RS_Hatch::update: scaling pattern: OK");
 
     // find out how many pattern-instances we need in x/y:
     int px1, py1, px2, py2;
@@ -240,33 +645,76 @@ void RS_Hatch::update() {
         return;
     }
 
-    // avoid huge memory consumption:
-    else if ( cSize.x* cSize.y/(pSize.x*pSize.y)>1e4) {
+    RS_Vector dvx=RS_Vector(data.angle)*pSize.x;
+    RS_Vector dvy=RS_Vector(data.angle+M_PI*0.5)*pSize.y;
+    pat->rotate(rot_center, data.angle);
+    pat->move(-rot_center);
+
+    // the hatch pattern entities:
+    hatch = new RS_EntityContainer(this);
+    hatch->setPen(RS_Pen(RS2::FlagInvalid));
+    hatch->setLayer(NULL);
+    hatch->setFlag(RS2::FlagTemp);
+
+    // pattern lines which repeat along their direction are merged into
+    // hatch lines and cut by scan lines, without a carpet:
+    std::vector<HatchEdge> edges;
+    if (hatchBoundary(this, edges)) {
+        std::vector<HatchLineFamily> families;
+        QList<RS_Entity*> done;
+        for(auto e: *pat){
+            if (e->rtti()==RS2::EntityLine &&
+                    addToFamilies(families, static_cast<RS_Line*>(e), dvx, dvy)) {
+                done << e;
+            }
+        }
+        for (RS_Entity* e: done) {
+            pat->removeEntity(e);
+        }
+        size_t count = 0;
+        for (HatchLineFamily& family: families) {
+            family.mergeDashes();
+            if (!hatchFamily(family, edges, hatch, count)) {
+                RS_DEBUG->print("RS_Hatch::update: too many hatch lines");
+                delete pat;
+                delete copy;
+                delete hatch;
+                hatch = NULL;
+                updateRunning = false;
+                updateError = HATCH_AREA_TOO_BIG;
+                return;
+            }
+        }
+        LC_TRACE_COUNT("update", "hatch scan lines", count);
+    }
+
+    // avoid huge memory consumption of the carpet for the remaining entities:
+    if (pat->count()>0 && cSize.x* cSize.y/(pSize.x*pSize.y)>1e4) {
         RS_DEBUG->print("RS_Hatch::update: contour size too large or pattern size too small");
         delete pat;
         delete copy;
+        delete hatch;
+        hatch = NULL;
+        updateRunning = false;
         updateError = HATCH_AREA_TOO_BIG;
         return;
     }
 
-    f = copy->getMin().x/pSize.x;
-    px1 = (int)floor(f);
-    f = copy->getMin().y/pSize.y;
-    py1 = (int)floor(f);
-    f = copy->getMax().x/pSize.x;
-    px2 = (int)ceil(f);
-    f = copy->getMax().y/pSize.y;
-    py2 = (int)ceil(f);
-    RS_Vector dvx=RS_Vector(data.angle)*pSize.x;
-    RS_Vector dvy=RS_Vector(data.angle+M_PI*0.5)*pSize.y;
-    pat->rotate(rot_center, data.angle);
-    pat->move(-rot_center);
-
+    px1 = px2 = py1 = py2 = 0;
+    if (pat->count()>0) {
+        f = copy->getMin().x/pSize.x;
+        px1 = (int)floor(f);
+        f = copy->getMin().y/pSize.y;
+        py1 = (int)floor(f);
+        f = copy->getMax().x/pSize.x;
+        px2 = (int)ceil(f);
+        f = copy->getMax().y/pSize.y;
+        py2 = (int)ceil(f);
+    }
 
     RS_EntityContainer tmp;   // container for untrimmed lines
 
     // adding array of patterns to tmp:
-    RS_DEBUG->print("RS_Hatch::update: creating pattern carpet");
 
     for (int px=px1; px<px2; px++) {
 		for (int py=py1; py<py2; py++) {
@@ -282,10 +730,8 @@ void RS_Hatch::update() {
     pat = nullptr;
     delete copy;
     copy = nullptr;
-    RS_DEBUG->print("RS_Hatch::update: creating pattern carpet: OK");
+    LC_TRACE_COUNT("update", "hatch carpet entities", tmp.count());
 
-
-    RS_DEBUG->print("RS_Hatch::update: cutting pattern carpet");
     // cut pattern to contour shape:
     RS_EntityContainer tmp2;   // container for small cut lines
     RS_Line* line = NULL;
@@ -351,8 +797,6 @@ void RS_Hatch::update() {
 							is.append(std::shared_ptr<RS_Vector>(
 										  new RS_Vector(vp)
 										  ));
-							RS_DEBUG->print("  pattern line intersection: %f/%f",
-											vp.x, vp.y);
 						}
 					}
 				}
@@ -461,16 +905,9 @@ is2.append(std::shared_ptr<RS_Vector>(new RS_Vector(endPoint)));
     }
 
     // updating hatch / adding entities that are inside
-    RS_DEBUG->print("RS_Hatch::update: cutting pattern carpet: OK");
 
     //RS_EntityContainer* rubbish = new RS_EntityContainer(getGraphic());
 
-    // the hatch pattern entities:
-    hatch = new RS_EntityContainer(this);
-    hatch->setPen(RS_Pen(RS2::FlagInvalid));
-    hatch->setLayer(NULL);
-    hatch->setFlag(RS2::FlagTemp);
-
     //calculateBorders();
 
 	for(auto e: tmp2){
@@ -518,8 +955,6 @@ is2.append(std::shared_ptr<RS_Vector>(new RS_Vector(endPoint)));
     activateContour(false);
 
     updateRunning = false;
-
-    RS_DEBUG->print("RS_Hatch::update: OK");
 }
 
 
@@ -528,22 +963,11 @@ is2.append(std::shared_ptr<RS_Vector>(new RS_Vector(endPoint)));
  * Activates of deactivates the hatch boundary.
  */
 void RS_Hatch::activateContour(bool on) {
-        RS_DEBUG->print("RS_Hatch::activateContour: %d", (int)on);
-		for(auto e: entities){
-        if (!e->isUndone()) {
-            if (!e->getFlag(RS2::FlagTemp)) {
-                                RS_DEBUG->print("RS_Hatch::activateContour: set visible");
-                e->setVisible(on);
-            }
-                        else {
-                                RS_DEBUG->print("RS_Hatch::activateContour: entity temp");
-                        }
-        }
-                else {
-                        RS_DEBUG->print("RS_Hatch::activateContour: entity undone");
-                }
-    }
-        RS_DEBUG->print("RS_Hatch::activateContour: OK");
+	for(auto e: entities){
+		if (!e->isUndone() && !e->getFlag(RS2::FlagTemp)) {
+			e->setVisible(on);
+		}
+	}
 }
 
 //#include<QDebug>
@@ -566,30 +990,23 @@ void RS_Hatch::draw(RS_Painter* painter, RS_GraphicView* view, double& /*pattern
     QPolygon pa;
 //    QPolygon jp;   // jump points
 
-    // loops:
-    if (needOptimization==true) {
-		for(auto l: entities){
-
-            if (l->rtti()==RS2::EntityContainer) {
-                RS_EntityContainer* loop = (RS_EntityContainer*)l;
-
-                loop->optimizeContours();
-            }
-        }
-        needOptimization = false;
-    }
-
     // loops:
 	for(auto l: entities){
-        l->setLayer(getLayer());
 
         if (l->rtti()==RS2::EntityContainer) {
             RS_EntityContainer* loop = (RS_EntityContainer*)l;
+            // loops are prepared by update(), draw() runs on render threads
+            // and orders a copy of a loop not prepared yet
+            std::unique_ptr<RS_EntityContainer> optimized;
+            if (needOptimization) {
+                optimized.reset(static_cast<RS_EntityContainer*>(loop->clone()));
+                optimized->optimizeContours();
+                loop = optimized.get();
+            }
 
             // edges:
 			for(auto e: *loop){
 
-                e->setLayer(getLayer());
                 switch (e->rtti()) {
                 case RS2::EntityLine: {
                     QPoint pt1(RS_Math::round(view->toGuiX(e->getStartpoint().x)),
@@ -166,6 +166,8 @@ public:
         friend std::ostream& operator << (std::ostream& os, const RS_Hatch& p);
 
 protected:
+        void prepareLoops();
+
         RS_HatchData data;
         RS_EntityContainer* hatch;
         bool updateRunning;
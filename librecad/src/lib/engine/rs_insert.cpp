@@ -34,6 +34,10 @@
 #include "rs_graphic.h"
 #include "rs_layer.h"
 #include "rs_math.h"
+#include "rs_graphicview.h"
+#include "lc_trace.h"
+
+bool RS_Insert::instancing = true;
 
 RS_InsertData::RS_InsertData(const QString& _name,
 							 RS_Vector _insertionPoint,
@@ -90,8 +94,7 @@ RS_Entity* RS_Insert::clone() const{
  */
 void RS_Insert::update() {
 
-        RS_DEBUG->print("RS_Insert::update");
-        RS_DEBUG->print("RS_Insert::update: name: %s", data.name.toLatin1().data());
+        LC_TRACE_SCOPE_ARG("update", "RS_Insert::update", data.name.toStdString());
 //        RS_DEBUG->print("RS_Insert::update: insertionPoint: %f/%f",
 //                data.insertionPoint.x, data.insertionPoint.y);
 
@@ -100,8 +103,10 @@ void RS_Insert::update() {
         }
 
     clear();
+    instanced = false;
 
-    RS_Block* blk = getBlockForInsert();
+    block = getBlockForInsert();
+    RS_Block* blk = block;
 	if (blk==nullptr) {
 		//return nullptr;
 				RS_DEBUG->print("RS_Insert::update: Block is nullptr");
@@ -118,6 +123,34 @@ void RS_Insert::update() {
                 return;
         }
 
+    // sub-inserts of the block must be up to date:
+    if (data.updateMode!=RS2::PreviewUpdate) {
+        for(auto e: *blk){
+            if (e->rtti()==RS2::EntityInsert) {
+                ((RS_Insert*)e)->update();
+            }
+        }
+    }
+
+    if (isInstanceable()) {
+        // borders of the shared block must be up to date:
+        blk->calculateBorders();
+        instanced = true;
+        calculateBorders();
+        LC_TRACE_COUNT("update", "instanced inserts", 1);
+        return;
+    }
+
+    addCopies(blk);
+    calculateBorders();
+}
+
+
+
+/**
+ * Adds the copies of the block entities for all array cells.
+ */
+void RS_Insert::addCopies(RS_Block* blk) {
     RS_Pen tmpPen;
 
         /*QListIterator<RS_Entity> it = createIterator();
@@ -125,10 +158,8 @@ void RS_Insert::update() {
 	while ( (e = it.current()) != nullptr ) {
         ++it;*/
 
-        RS_DEBUG->print("RS_Insert::update: cols: %d, rows: %d",
-                data.cols, data.rows);
-        RS_DEBUG->print("RS_Insert::update: block has %d entities",
-                blk->count());
+        LC_TRACE_COUNT("update", "insert entity copies",
+                       (long long) data.cols*data.rows*blk->count());
 //int i_en_counts=0;
 		for(auto e: *blk){
         for (int c=0; c<data.cols; ++c) {
@@ -137,13 +168,6 @@ void RS_Insert::update() {
 //                i_en_counts++;
 //                RS_DEBUG->print("RS_Insert::update: row %d", r);
 
-                if (e->rtti()==RS2::EntityInsert &&
-                    data.updateMode!=RS2::PreviewUpdate) {
-
-//                                        RS_DEBUG->print("RS_Insert::update: updating sub-insert");
-                    ((RS_Insert*)e)->update();
-                }
-
 //                                RS_DEBUG->print("RS_Insert::update: cloning entity");
 
                 RS_Entity* ne;
@@ -237,9 +261,92 @@ void RS_Insert::update() {
             }
         }
     }
-    calculateBorders();
+}
+
+
+
+/**
+ * @return true if the block can be drawn with a transform of the view
+ * instead of entity copies: no rotation and a uniform positive scale.
+ * This includes the letters of texts, which share the glyph blocks of
+ * their font.
+ */
+bool RS_Insert::isInstanceable() const {
+    return instancing
+            && data.updateMode!=RS2::PreviewUpdate
+            && data.scaleFactor.x>1.0e-6
+            && fabs(data.scaleFactor.x-data.scaleFactor.y)<1.0e-6
+            && fabs(remainder(data.angle, 2.*M_PI))<RS_TOLERANCE_ANGLE;
+}
+
+
+
+/**
+ * Builds the entity copies of an instanced insert on the first request,
+ * e.g. by explode. The insert stays instanced: it is still drawn and
+ * snapped to with the shared block. The copies are dropped by update().
+ */
+void RS_Insert::buildCopies() {
+    if (!instanced || !entities.isEmpty()) return;
+    RS_Block* blk = getBlockForInsert();
+    if (blk) {
+        LC_TRACE_COUNT("update", "expanded inserts", 1);
+        addCopies(blk);
+    }
+}
+
+
+
+/**
+ * @return Origin of the block copy in the given array cell, such that
+ *    drawing coordinates are origin + scale * block coordinates.
+ */
+RS_Vector RS_Insert::getInstanceOrigin(int col, int row, const RS_Block* blk) const {
+    return data.insertionPoint
+            + RS_Vector(data.spacing.x*col, data.spacing.y*row)
+            - blk->getBasePoint()*data.scaleFactor.x;
+}
+
 
-        RS_DEBUG->print("RS_Insert::update: OK");
+
+/**
+ * Runs a nearest point query on the block in block coordinates for
+ * all array cells near coord.
+ *
+ * @return Closest point in drawing coordinates.
+ */
+RS_Vector RS_Insert::getNearestInstancePoint(const RS_Vector& coord, double* dist,
+                                             const std::function<RS_Vector(RS_Block*, const RS_Vector&, double*)>& query) const {
+    double minDist = RS_MAXDOUBLE;
+    RS_Vector closestPoint(false);
+    RS_Block* blk = getBlockForInsert();
+    if (blk) {
+        double const s = data.scaleFactor.x;
+        for (int c=0; c<data.cols; ++c) {
+            for (int r=0; r<data.rows; ++r) {
+                RS_Vector const origin = getInstanceOrigin(c, r, blk);
+                // skip cells too far away:
+                RS_Vector const vMin = origin + blk->getMin()*s;
+                RS_Vector const vMax = origin + blk->getMax()*s;
+                RS_Vector const gap(std::max(0., std::max(vMin.x-coord.x, coord.x-vMax.x)),
+                                    std::max(0., std::max(vMin.y-coord.y, coord.y-vMax.y)));
+                if (gap.magnitude()>=minDist) {
+                    continue;
+                }
+
+                double curDist = RS_MAXDOUBLE;
+                RS_Vector const point = query(blk, (coord-origin)/s, &curDist);
+                if (point.valid && curDist*s<minDist) {
+                    minDist = curDist*s;
+                    closestPoint = origin + point*s;
+                }
+            }
+        }
+    }
+    if (dist) {
+        *dist = minDist;
+    }
+    return closestPoint;
 }
 
 
@@ -248,7 +355,8 @@ void RS_Insert::update() {
  * @return Pointer to the block associated with this Insert or
  *   nullptr if the block couldn't be found. Blocks are requested
  *   from the blockSource if one was supplied and otherwise from
- *   the closest parent graphic.
+ *   the closest parent graphic. The block is cached by update(), this
+ *   method doesn't modify the insert, so render threads may call it.
  */
 RS_Block* RS_Insert::getBlockForInsert() const{
 	RS_Block* blk = nullptr;
@@ -273,11 +381,6 @@ RS_Block* RS_Insert::getBlockForInsert() const{
         blk = blkList->find(data.name);
     }
 
-	if (blk) {
-    }
-
-        block = blk;
-
     return blk;
 }
 
@@ -384,6 +487,252 @@ void RS_Insert::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2)
 }
 
 
+RS_Entity* RS_Insert::firstEntity(RS2::ResolveLevel level) {
+    buildCopies();
+    return RS_EntityContainer::firstEntity(level);
+}
+
+
+
+RS_Entity* RS_Insert::lastEntity(RS2::ResolveLevel level) {
+    buildCopies();
+    return RS_EntityContainer::lastEntity(level);
+}
+
+
+
+RS_Entity* RS_Insert::entityAt(int index) {
+    buildCopies();
+    return RS_EntityContainer::entityAt(index);
+}
+
+
+
+/**
+ * Range-based loops over an instanced insert need the entity copies.
+ */
+void RS_Insert::prepareEntities() const {
+    const_cast<RS_Insert*>(this)->buildCopies();
+}
+
+
+
+/**
+ * Instanced inserts count the block entities of all array cells, as the
+ * entity copies would be counted.
+ */
+unsigned RS_Insert::count() const {
+    if (!instanced) {
+        return RS_EntityContainer::count();
+    }
+    RS_Block* blk = getBlockForInsert();
+    return blk ? blk->count()*data.cols*data.rows : 0;
+}
+
+
+
+unsigned RS_Insert::countDeep() const {
+    if (!instanced) {
+        return RS_EntityContainer::countDeep();
+    }
+    RS_Block* blk = getBlockForInsert();
+    return blk ? blk->countDeep()*data.cols*data.rows : 0;
+}
+
+
+
+/**
+ * Instanced inserts get their borders from the block borders
+ * transformed to all array cells.
+ */
+void RS_Insert::calculateBorders() {
+    if (!instanced) {
+        RS_EntityContainer::calculateBorders();
+        return;
+    }
+
+    resetBorders();
+    RS_Block* blk = getBlockForInsert();
+    if (blk!=nullptr && blk->getMin().x<=blk->getMax().x
+            && blk->getMin().y<=blk->getMax().y) {
+        double const s = data.scaleFactor.x;
+        // borders of the array are reached in the corner cells:
+        for (int c: {0, data.cols-1}) {
+            for (int r: {0, data.rows-1}) {
+                RS_Vector const origin = getInstanceOrigin(c, r, blk);
+                minV = RS_Vector::minimum(minV, origin + blk->getMin()*s);
+                maxV = RS_Vector::maximum(maxV, origin + blk->getMax()*s);
+            }
+        }
+    }
+    bordersChanged();
+}
+
+
+
+void RS_Insert::forcedCalculateBorders() {
+    if (instanced) {
+        calculateBorders();
+    } else {
+        RS_EntityContainer::forcedCalculateBorders();
+    }
+}
+
+
+
+RS_Vector RS_Insert::getNearestEndpoint(const RS_Vector& coord,
+                                        double* dist) const {
+    if (!instanced) {
+        return RS_EntityContainer::getNearestEndpoint(coord, dist);
+    }
+    return getNearestInstancePoint(coord, dist,
+                                   [](RS_Block* blk, const RS_Vector& v, double* d) {
+        return blk->getNearestEndpoint(v, d);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestEndpoint(const RS_Vector& coord,
+                                        double* dist, RS_Entity** pEntity) const {
+    if (!instanced) {
+        return RS_EntityContainer::getNearestEndpoint(coord, dist, pEntity);
+    }
+    RS_Vector const point = getNearestEndpoint(coord, dist);
+    if (pEntity && point.valid) {
+        *pEntity = const_cast<RS_Insert*>(this);
+    }
+    return point;
+}
+
+
+
+RS_Vector RS_Insert::getNearestPointOnEntity(const RS_Vector& coord,
+                                             bool onEntity, double* dist,
+                                             RS_Entity** entity) const {
+    if (!instanced) {
+        return RS_EntityContainer::getNearestPointOnEntity(coord, onEntity, dist, entity);
+    }
+    RS_Vector const point = getNearestInstancePoint(coord, dist,
+                                                    [onEntity](RS_Block* blk, const RS_Vector& v, double* d) {
+        return blk->getNearestPointOnEntity(v, onEntity, d);
+    });
+    if (entity && point.valid) {
+        *entity = const_cast<RS_Insert*>(this);
+    }
+    return point;
+}
+
+
+
+RS_Vector RS_Insert::getNearestCenter(const RS_Vector& coord,
+                                      double* dist) const {
+    if (!instanced) {
+        return RS_EntityContainer::getNearestCenter(coord, dist);
+    }
+    return getNearestInstancePoint(coord, dist,
+                                   [](RS_Block* blk, const RS_Vector& v, double* d) {
+        return blk->getNearestCenter(v, d);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestMiddle(const RS_Vector& coord,
+                                      double* dist, int middlePoints) const {
+    if (!instanced) {
+        return RS_EntityContainer::getNearestMiddle(coord, dist, middlePoints);
+    }
+    return getNearestInstancePoint(coord, dist,
+                                   [middlePoints](RS_Block* blk, const RS_Vector& v, double* d) {
+        return blk->getNearestMiddle(v, d, middlePoints);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestDist(double distance,
+                                    const RS_Vector& coord,
+                                    double* dist) const {
+    if (!instanced) {
+        return RS_EntityContainer::getNearestDist(distance, coord, dist);
+    }
+    double const s = data.scaleFactor.x;
+    return getNearestInstancePoint(coord, dist,
+                                   [distance, s](RS_Block* blk, const RS_Vector& v, double* d) {
+        return blk->getNearestDist(distance/s, v, d);
+    });
+}
+
+
+
+double RS_Insert::getDistanceToPoint(const RS_Vector& coord,
+                                     RS_Entity** entity,
+                                     RS2::ResolveLevel level,
+                                     double solidDist) const {
+    if (!instanced) {
+        return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+    }
+
+    if (entity && level!=RS2::ResolveNone) {
+        // the caller resolves the entities, e.g. to intersect or trim one
+        // of them. The shared block entities won't do, they are not
+        // transformed.
+        prepareEntities();
+        return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+    }
+
+    // the block is queried in block coordinates
+    double const s = data.scaleFactor.x;
+    double minDist = RS_MAXDOUBLE;
+    getNearestInstancePoint(coord, &minDist,
+                            [level, solidDist, s](RS_Block* blk, const RS_Vector& v, double* d) {
+        RS_Entity* e = nullptr;
+        *d = blk->getDistanceToPoint(v, &e, level, solidDist/s);
+        return e ? v : RS_Vector(false);
+    });
+    if (entity) {
+        *entity = const_cast<RS_Insert*>(this);
+    }
+    return minDist;
+}
+
+
+
+/**
+ * Instanced inserts draw the block entities in block coordinates with
+ * the transform of each array cell set in the graphic view.
+ */
+void RS_Insert::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset) {
+    if (!instanced) {
+        RS_EntityContainer::draw(painter, view, patternOffset);
+        return;
+    }
+    RS_Block* blk = getBlockForInsert();
+    if (painter==nullptr || view==nullptr || blk==nullptr) {
+        return;
+    }
+
+    double const s = data.scaleFactor.x;
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            RS_Vector const origin = getInstanceOrigin(c, r, blk);
+            if (!view->isPrinting()
+                    && !view->isInViewport(origin + blk->getMin()*s,
+                                           origin + blk->getMax()*s)) {
+                continue;
+            }
+            view->pushInstance(this, origin, s);
+            for(auto e: *blk){
+                view->drawEntity(painter, e);
+            }
+            view->popInstance();
+        }
+    }
+}
+
+
+
 std::ostream& operator << (std::ostream& os, const RS_Insert& i) {
     os << " Insert: " << i.getData() << std::endl;
     return os;
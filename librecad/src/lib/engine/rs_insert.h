@@ -28,8 +28,10 @@
 #ifndef RS_INSERT_H
 #define RS_INSERT_H
 
+#include <functional>
 #include "rs_entitycontainer.h"
 
+class RS_Block;
 class RS_BlockList;
 
 /**
@@ -87,6 +89,13 @@ std::ostream& operator << (std::ostream& os, const RS_InsertData& d);
  * refer to a block. However, to the outside world they act exactly
  * like EntityContainer.
  *
+ * Inserts without rotation and with a uniform positive scale are
+ * instanced: they keep no copies of the block entities, but draw and
+ * snap to the shared block with the transform of each array cell.
+ * The copies are only built when the entities of the insert are
+ * iterated, e.g. for explode, and dropped again by update(). Letters of unrotated texts are instanced
+ * the same way, so each glyph of a font is stored only once.
+ *
  * @author Andrew Mustun
  */
 class RS_Insert : public RS_EntityContainer {
@@ -119,6 +128,27 @@ public:
 
     virtual void update();
 
+    /**
+     * Enables / disables instancing of inserts updated from now on.
+     * By default this is turned on.
+     */
+    static void setInstancing(bool enable) {
+        instancing = enable;
+    }
+    /** @return true if the insert draws the shared block entities */
+    bool isInstanced() const {
+        return instanced;
+    }
+
+    virtual RS_Entity* firstEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* lastEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* entityAt(int index);
+    virtual unsigned count() const;
+    virtual unsigned countDeep() const;
+
+    virtual void calculateBorders();
+    virtual void forcedCalculateBorders();
+
     QString getName() const {
         return data.name;
     }
@@ -179,6 +209,26 @@ public:
     }
     virtual RS_Vector getNearestRef(const RS_Vector& coord,
 									 double* dist = nullptr) const;
+    virtual RS_Vector getNearestEndpoint(const RS_Vector& coord,
+                                         double* dist = nullptr)const;
+    virtual RS_Vector getNearestEndpoint(const RS_Vector& coord,
+                                         double* dist, RS_Entity** pEntity )const;
+    virtual RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+                                              bool onEntity = true,
+                                              double* dist = nullptr,
+                                              RS_Entity** entity=nullptr)const;
+    virtual RS_Vector getNearestCenter(const RS_Vector& coord,
+                                       double* dist = nullptr)const;
+    virtual RS_Vector getNearestMiddle(const RS_Vector& coord,
+                                       double* dist = nullptr,
+                                       int middlePoints = 1)const;
+    virtual RS_Vector getNearestDist(double distance,
+                                     const RS_Vector& coord,
+                                     double* dist = nullptr) const;
+    virtual double getDistanceToPoint(const RS_Vector& coord,
+                                      RS_Entity** entity,
+                                      RS2::ResolveLevel level=RS2::ResolveNone,
+                                      double solidDist = RS_MAXDOUBLE) const;
 
     virtual void move(const RS_Vector& offset);
     virtual void rotate(const RS_Vector& center, const double& angle);
@@ -186,11 +236,28 @@ public:
     virtual void scale(const RS_Vector& center, const RS_Vector& factor);
     virtual void mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2);
 
+    virtual void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset);
+
     friend std::ostream& operator << (std::ostream& os, const RS_Insert& i);
 
 protected:
+    virtual void prepareEntities() const;
+
     RS_InsertData data;
-	mutable RS_Block* block;
+	//! cached by update()
+	RS_Block* block;
+
+private:
+    bool isInstanceable() const;
+    void addCopies(RS_Block* blk);
+    void buildCopies();
+    RS_Vector getInstanceOrigin(int col, int row, const RS_Block* blk) const;
+    RS_Vector getNearestInstancePoint(const RS_Vector& coord, double* dist,
+                                      const std::function<RS_Vector(RS_Block*, const RS_Vector&, double*)>& query) const;
+
+    /** true: no entity copies, the block is drawn with the insert transform */
+    bool instanced = false;
+    static bool instancing;
 };
 
 
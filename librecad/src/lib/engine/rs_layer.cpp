@@ -49,9 +49,21 @@ RS_Layer* RS_Layer::clone() const{
 	return new RS_Layer(*this);
 }
 
+namespace {
+//! renames of all layers, see RS_Layer::getRenameCount()
+unsigned renameCount = 0;
+}
+
 /** sets a new name for this layer. */
 void RS_Layer::setName(const QString& name) {
-	data.name = name;
+	if (name!=data.name) {
+		data.name = name;
+		++renameCount;
+	}
+}
+
+unsigned RS_Layer::getRenameCount() {
+	return renameCount;
 }
 
 /** @return the name of this layer. */
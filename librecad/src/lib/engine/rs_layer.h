@@ -91,6 +91,8 @@ public:
 
     /** sets a new name for this layer. */
 	void setName(const QString& name);
+	/** @return number of layer renames so far, indexes by name are stale when it changed */
+	static unsigned getRenameCount();
 
     /** @return the name of this layer. */
 	QString getName() const;
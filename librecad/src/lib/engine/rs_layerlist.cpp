@@ -35,11 +35,19 @@
 #include "emu_qt44.h"
 #endif
 
+namespace {
+//! key of a layer name in the name index
+QString nameKey(const QString& name) {
+    return name.toCaseFolded();
+}
+}
+
 /**
  * Default constructor.
  */
 RS_LayerList::RS_LayerList() {
     activeLayer = NULL;
+    indexedRenames = RS_Layer::getRenameCount();
 	setModified(false);
 }
 
@@ -50,6 +58,7 @@ RS_LayerList::RS_LayerList() {
  */
 void RS_LayerList::clear() {
     layers.clear();
+    layerNames.clear();
 	setModified(true);
 }
 
@@ -137,6 +146,7 @@ void RS_LayerList::add(RS_Layer* layer) {
     RS_Layer* l = find(layer->getName());
     if (l==NULL) {
         layers.append(layer);
+        layerNames.insert(nameKey(layer->getName()), layer);
         this->sort();
         // notify listeners
         for (int i=0; i<layerListListeners.size(); ++i) {
@@ -187,6 +197,9 @@ void RS_LayerList::remove(RS_Layer* layer) {
 #else
     layers.removeOne(layer);
 #endif
+    if (layerNames.value(nameKey(layer->getName()))==layer) {
+        layerNames.remove(nameKey(layer->getName()));
+    }
 
 
     for (int i=0; i<layerListListeners.size(); ++i) {
@@ -217,7 +230,11 @@ void RS_LayerList::edit(RS_Layer* layer, const RS_Layer& source) {
         return;
     }
 
+    if (layerNames.value(nameKey(layer->getName()))==layer) {
+        layerNames.remove(nameKey(layer->getName()));
+    }
     *layer = source;
+    layerNames.insert(nameKey(layer->getName()), layer);
 
     for (int i=0; i<layerListListeners.size(); ++i) {
         RS_LayerListListener* l = layerListListeners.at(i);
@@ -231,25 +248,21 @@ void RS_LayerList::edit(RS_Layer* layer, const RS_Layer& source) {
 
 
 /**
- * @return Pointer to the layer with the given name or
+ * @return Pointer to the layer with the given name (ignoring case) or
  * \p NULL if no such layer was found.
  */
 RS_Layer* RS_LayerList::find(const QString& name) {
-    //RS_DEBUG->print("RS_LayerList::find begin");
-
-    RS_Layer* ret = NULL;
-
-    for (int i=0; i<layers.size(); ++i) {
-        RS_Layer* l = layers.at(i);
-        if (l->getName()==name) {
-            ret = l;
-            break;
+    if (indexedRenames!=RS_Layer::getRenameCount()) {
+        // a layer was renamed, index all names again:
+        indexedRenames = RS_Layer::getRenameCount();
+        layerNames.clear();
+        for (RS_Layer* l: layers) {
+            if (!layerNames.contains(nameKey(l->getName()))) {
+                layerNames.insert(nameKey(l->getName()), l);
+            }
         }
     }
-
-    //RS_DEBUG->print("RS_LayerList::find end");
-
-    return ret;
+    return layerNames.value(nameKey(name));
 }
 
 
@@ -259,22 +272,8 @@ RS_Layer* RS_LayerList::find(const QString& name) {
  * was not found.
  */
 int RS_LayerList::getIndex(const QString& name) {
-    //RS_DEBUG->print("RS_LayerList::find begin");
-
-    int ret = -1;
-
-    for (int i=0; i<layers.size(); i++) {
-        RS_Layer* l = layers.at(i);
-
-        if (l->getName()==name) {
-            ret = i;
-            break;
-        }
-    }
-
-    //RS_DEBUG->print("RS_LayerList::find end");
-
-    return ret;
+    RS_Layer* l = find(name);
+    return l ? layers.indexOf(l) : -1;
 }
 
 
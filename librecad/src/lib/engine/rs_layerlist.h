@@ -29,6 +29,7 @@
 #ifndef RS_LAYERLIST_H
 #define RS_LAYERLIST_H
 
+#include <QHash>
 #include <QList>
 
 class RS_Layer;
@@ -126,6 +127,10 @@ public:
 private:
     //! layers in the graphic
     QList<RS_Layer*> layers;
+    //! layers by case folded name, DXF names are case insensitive
+    QHash<QString, RS_Layer*> layerNames;
+    //! RS_Layer::getRenameCount() when layerNames was complete
+    unsigned indexedRenames;
     //! List of registered LayerListListeners
     QList<RS_LayerListListener*> layerListListeners;
     QG_LayerWidget* layerWidget;
@@ -35,6 +35,7 @@
 #include "rs_linetypepattern.h"
 #include "rs_information.h"
 #include "lc_quadratic.h"
+#include "lc_clipping.h"
 #include "rs_painterqt.h"
 #include "rs_circle.h"
 
@@ -89,6 +90,7 @@ RS_Entity* RS_Line::clone() const {
 void RS_Line::calculateBorders() {
     minV = RS_Vector::minimum(data.startpoint, data.endpoint);
     maxV = RS_Vector::maximum(data.startpoint, data.endpoint);
+    bordersChanged();
 }
 
 
@@ -542,68 +544,21 @@ void RS_Line::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOff
     }
 
     //only draw the visible portion of line
-	std::vector<RS_Vector> endPoints(0);
-        RS_Vector vpMin(view->toGraph(0,view->getHeight()));
-        RS_Vector vpMax(view->toGraph(view->getWidth(),0));
-         QPolygonF visualBox(QRectF(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y));
-	if( getStartpoint().isInWindowOrdered(vpMin, vpMax) ) endPoints.push_back(getStartpoint());
-	if( getEndpoint().isInWindowOrdered(vpMin, vpMax) ) endPoints.push_back(getEndpoint());
-    if(endPoints.size()<2){
-
-		 std::vector<RS_Vector> vertex;
-         for(unsigned short i=0;i<4;i++){
-             const QPointF& vp(visualBox.at(i));
-			 vertex.push_back(RS_Vector(vp.x(),vp.y()));
-         }
-         for(unsigned short i=0;i<4;i++){
-             RS_Line line(NULL,RS_LineData(vertex.at(i),vertex.at((i+1)%4)));
-			 auto vpIts=RS_Information::getIntersection(static_cast<RS_Entity*>(this), &line, true);
-             if( vpIts.size()==0) continue;
-			 endPoints.push_back(vpIts.get(0));
-         }
-    }
-    if(endPoints.size()<2) return;
-    if( (endPoints[0] - getStartpoint()).squared() >
-            (endPoints[1] - getStartpoint()).squared() ) std::swap(endPoints[0],endPoints[1]);
-
-    RS_Vector pStart(view->toGui(endPoints.at(0)));
-    RS_Vector pEnd(view->toGui(endPoints.at(1)));
+    RS_Vector vpMin(view->toGraph(0,view->getHeight()));
+    RS_Vector vpMax(view->toGraph(view->getWidth(),0));
+    //extend line on a construction layer to fill the whole view
+    bool extend=isConstruction(true) &&
+            (getEndpoint()-getStartpoint()).squared() > RS_TOLERANCE2;
+    double t1=extend?-RS_MAXDOUBLE:0.;
+    double t2=extend?RS_MAXDOUBLE:1.;
+    if(!LC_Clipping::clipLine(getStartpoint(), getEndpoint(),
+                              vpMin, vpMax, t1, t2)) return;
+
+    RS_Vector delta(getEndpoint()-getStartpoint());
+    RS_Vector pStart(view->toGui(getStartpoint()+delta*t1));
+    RS_Vector pEnd(view->toGui(getStartpoint()+delta*t2));
     //    std::cout<<"draw line: "<<pStart<<" to "<<pEnd<<std::endl;
     RS_Vector direction=pEnd-pStart;
-    if(isConstruction(true) && direction.squared() > RS_TOLERANCE){
-        //extend line on a construction layer to fill the whole view
-        RS_Vector lb(0,0);
-        RS_Vector rt(view->getWidth(),view->getHeight());
-		std::vector<RS_Vector> rect;
-		rect.push_back(lb);
-		rect.push_back({rt.x,lb.y});
-		rect.push_back(rt);
-		rect.push_back({lb.x,rt.y});
-		rect.push_back(lb);
-        RS_VectorSolutions sol;
-        RS_Line dLine(pStart,pEnd);
-        for(int i=0;i<4;i++){
-            RS_Line bLine(rect.at(i),rect.at(i+1));
-            RS_VectorSolutions sol2=RS_Information::getIntersection(&bLine, &dLine);
-            if( sol2.getNumber()>0 && bLine.isPointOnEntity(sol2.get(0),RS_TOLERANCE)) {
-                sol.push_back(sol2.get(0));
-            }
-        }
-        switch(sol.getNumber()){
-        case 2:
-            pStart=sol.get(0);
-            pEnd=sol.get(1);
-            break;
-        case 3:
-        case 4:
-            pStart=sol.get(0);
-            pEnd=sol.get(2);
-            break;
-        default:
-            return;
-        }
-        direction=pEnd-pStart;
-    }
     double  length=direction.magnitude();
     patternOffset -= length;
     if (( !isSelected() && (
@@ -643,44 +598,32 @@ void RS_Line::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOff
     pen.setLineType(RS2::SolidLine);
     painter->setPen(pen);
 
-    // index counter
-	size_t i;
-
     // pattern segment length:
     double patternSegmentLength = pat->totalLength;
 
-    // create pattern:
-	size_t const patnum=pat->num > 0?pat->num:0;
-	std::vector<RS_Vector> dp(patnum);
-	std::vector<double> ds(patnum, 0.);
-    if (pat->num >0 ){
-        double dpmm=static_cast<RS_PainterQt*>(painter)->getDpmm();
-        for (i=0; i<pat->num; ++i) {
-            //        ds[j]=pat->pattern[i] * styleFactor;
-            //fixme, styleFactor support needed
-
-            ds[i]=dpmm*pat->pattern[i];
-            if( fabs(ds[i]) < 1. ) ds[i] = (ds[i]>=0.)?1.:-1.;
-            dp[i] = direction*fabs(ds[i]);
-        }
-	}else {
+    if (pat->num==0) {
         RS_DEBUG->print(RS_Debug::D_WARNING,"invalid line pattern for line, draw solid line instread");
-        painter->drawLine(view->toGui(getStartpoint()),
-                          view->toGui(getEndpoint()));
+        painter->drawLine(pStart,pEnd);
         return;
     }
-    double total= remainder(patternOffset-0.5*patternSegmentLength,patternSegmentLength) -0.5*patternSegmentLength;
+    // pattern segments are scaled on the fly
+    double dpmm=static_cast<RS_PainterQt*>(painter)->getDpmm();
+    // phase of the pattern at the unclipped start point, so the pattern
+    // does not move with the visible portion of the line
+    double const clipped=RS_Vector::dotP(pStart-view->toGui(getStartpoint()), direction);
+    double total= remainder(patternOffset-clipped-0.5*patternSegmentLength,patternSegmentLength) -0.5*patternSegmentLength;
     //    double total= patternOffset-patternSegmentLength;
 
     RS_Vector p1,p2,p3;
     RS_Vector curP(pStart+direction*total);
-    double t2;
-    for(int j=0;total<length;j=(j+1)%i) {
+    for(size_t j=0;total<length;j=(j+1)%pat->num) {
+        double ds=dpmm*pat->pattern[j];
+        if( fabs(ds) < 1. ) ds = (ds>=0.)?1.:-1.;
 
         // line segment (otherwise space segment)
-        t2=total+fabs(ds[j]);
-        p3=curP+dp[j];
-        if (ds[j]>0.0 && t2 > 0.0) {
+        t2=total+fabs(ds);
+        p3=curP+direction*fabs(ds);
+        if (ds>0.0 && t2 > 0.0) {
             // drop the whole pattern segment line, for ds[i]<0:
             // trim end points of pattern segment line to line
             p1 =(total > -0.5)? curP:pStart;
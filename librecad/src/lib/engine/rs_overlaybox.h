@@ -77,6 +77,10 @@ public:
         return RS2::EntityOverlayBox;
     }
     virtual void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset);
+    /** no borders, never culled by the graphic view */
+    virtual bool isCullable() const {
+        return false;
+    }
 
     /** @return Start point of the entity */
     virtual RS_Vector getCorner1() const {
@@ -43,6 +43,10 @@ public:
 	RS_OverlayLine(RS_EntityContainer* parent, const RS_LineData& d);
 	
     virtual void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset);
+    /** screen coordinates, never culled by the graphic view */
+    virtual bool isCullable() const {
+        return false;
+    }
 }
 ;
 
@@ -25,6 +25,7 @@
 **********************************************************************/
 
 
+#include <algorithm>
 #include "rs_polyline.h"
 
 #include "rs_debug.h"
@@ -34,6 +35,44 @@
 #include "rs_math.h"
 #include "rs_information.h"
 
+namespace {
+/**
+ * @return the arc from p1 to p2 with the given bulge (see DXF documentation)
+ */
+RS_ArcData bulgeArc(const RS_Vector& p1, const RS_Vector& p2, double bulge)
+{
+	bool reversed = (bulge<0.0);
+	double alpha = atan(bulge)*4.0;
+
+	RS_Vector middle = (p1+p2)/2.0;
+	double dist = p1.distanceTo(p2)/2.0;
+	double angle = p1.angleTo(p2);
+
+	// alpha can't be 0.0 at this point
+	double radius = fabs(dist / sin(alpha/2.0));
+
+	double wu = fabs(RS_Math::pow(radius, 2.0) - RS_Math::pow(dist, 2.0));
+	double h = sqrt(wu);
+
+	if (bulge>0.0) {
+		angle+=M_PI_2;
+	} else {
+		angle-=M_PI_2;
+	}
+
+	if (fabs(alpha)>M_PI) {
+		h*=-1.0;
+	}
+
+	RS_Vector center = RS_Vector::polar(h, angle);
+	center+=middle;
+
+	return RS_ArcData(center, radius,
+					  center.angleTo(p1), center.angleTo(p2),
+					  reversed);
+}
+}
+
 RS_PolylineData::RS_PolylineData():
 	startpoint(false)
 	,endpoint(false)
@@ -96,6 +135,7 @@ RS_Entity* RS_Polyline::clone() const {
  * Removes the last vertex of this polyline.
  */
 void RS_Polyline::removeLastVertex() {
+	unpack();
         RS_Entity* last = lastEntity();
 		if (last) {
                 removeEntity(last);
@@ -131,6 +171,7 @@ void RS_Polyline::removeLastVertex() {
 RS_Entity* RS_Polyline::addVertex(const RS_Vector& v, double bulge, bool prepend) {
 
 	RS_Entity* entity=nullptr;
+	unpack();
     //static double nextBulge = 0.0;
 
     // very first vertex:
@@ -168,6 +209,8 @@ RS_Entity* RS_Polyline::addVertex(const RS_Vector& v, double bulge, bool prepend
  *
  * The very first vertex added with this method is the startpoint if not exists.
  *
+ * The vertices of a new polyline are packed, see unpack().
+ *
  * @param vl list of vertexs coordinate to be added
  * @param Pair are RS_Vector of coord and the bulge of the arc or 0 for a line segment (see DXF documentation)
  *
@@ -177,6 +220,20 @@ void RS_Polyline::appendVertexs(const std::vector< std::pair<RS_Vector, double>
 	RS_Entity* entity=nullptr;
     //static double nextBulge = 0.0;
 	if (!vl.size()) return;
+
+	// a new polyline keeps the vertices packed:
+	if (!data.startpoint.valid && entities.isEmpty() && vl.size()>1) {
+		vertices.reserve(vl.size());
+		for (auto const& v: vl)
+			vertices.push_back({v.first.x, v.first.y, v.second});
+		data.startpoint = vl.front().first;
+		data.endpoint = vl.back().first;
+		nextBulge = vl.back().second;
+		calculateBorders();
+		return;
+	}
+
+	unpack();
 	size_t idx = 0;
     // very first vertex:
     if (!data.startpoint.valid) {
@@ -233,67 +290,113 @@ RS_Entity* RS_Polyline::createVertex(const RS_Vector& v, double bulge, bool prep
 
     // create arc for the polyline:
     else {
-        bool reversed = (bulge<0.0);
-        double alpha = atan(bulge)*4.0;
+        RS_ArcData d = prepend ? bulgeArc(v, data.startpoint, bulge)
+                               : bulgeArc(data.endpoint, v, bulge);
 
-        double radius;
-        RS_Vector middle;
-        double dist;
-        double angle;
-
-                if (prepend==false) {
-                middle = (data.endpoint+v)/2.0;
-            dist = data.endpoint.distanceTo(v)/2.0;
-                angle = data.endpoint.angleTo(v);
-                }
-                else {
-                middle = (data.startpoint+v)/2.0;
-            dist = data.startpoint.distanceTo(v)/2.0;
-                angle = v.angleTo(data.startpoint);
-                }
+        entity = new RS_Arc(this, d);
+        entity->setSelected(isSelected());
+        entity->setPen(RS_Pen(RS2::FlagInvalid));
+		entity->setLayer(nullptr);
+    }
 
-        // alpha can't be 0.0 at this point
-        radius = fabs(dist / sin(alpha/2.0));
+    return entity;
+}
 
-        double wu = fabs(RS_Math::pow(radius, 2.0) - RS_Math::pow(dist, 2.0));
-        double h = sqrt(wu);
 
-        if (bulge>0.0) {
-			angle+=M_PI_2;
-        } else {
-			angle-=M_PI_2;
-        }
+/**
+ * Creates the line and arc entities of a packed polyline.
+ */
+void RS_Polyline::unpack() {
+	if (!isPacked()) return;
+	RS_DEBUG->print("RS_Polyline::unpack: %d vertices", (int) vertices.size());
+
+	std::vector<RS_PolylineVertex> vl;
+	vl.swap(vertices);
+	data.endpoint = RS_Vector(vl.front().x, vl.front().y);
+	nextBulge = vl.front().bulge;
+	for (size_t i=1; i<vl.size(); ++i) {
+		RS_Vector const v(vl[i].x, vl[i].y);
+		RS_Entity* entity = createVertex(v, nextBulge, false);
+		data.endpoint = v;
+		RS_EntityContainer::addEntity(entity);
+		nextBulge = vl[i].bulge;
+	}
+	closingEntity = nullptr;
+	endPolyline();
+}
 
-        if (fabs(alpha)>M_PI) {
-            h*=-1.0;
-        }
 
-		RS_Vector center = RS_Vector::polar(h, angle);
-        center+=middle;
+void RS_Polyline::prepareEntities() const {
+	// iterating code may keep or edit the segments, temporary ones won't do
+	const_cast<RS_Polyline*>(this)->unpack();
+}
 
-                double a1;
-                double a2;
 
-                if (prepend==false) {
-                        a1 = center.angleTo(data.endpoint);
-                        a2 = center.angleTo(v);
-                }
-                else {
-                        a1 = center.angleTo(v);
-                        a2 = center.angleTo(data.startpoint);
-                }
+bool RS_Polyline::visitSegments(const std::function<bool(RS_AtomicEntity*)>& visitor) const {
+	if (!isPacked()) {
+		for (RS_Entity* e: entities) {
+			if (e->isAtomic() && !visitor(static_cast<RS_AtomicEntity*>(e)))
+				return false;
+		}
+		return true;
+	}
 
-        RS_ArcData d(center, radius,
-                     a1, a2,
-                     reversed);
+	// one temporary line and arc, drawn with the pen of the polyline
+	RS_Line line(nullptr, RS_LineData(RS_Vector(0., 0.), RS_Vector(0., 0.)));
+	RS_Arc arc(nullptr, RS_ArcData(RS_Vector(0., 0.), 1., 0., M_PI, false));
+	line.setPen(getPen());
+	line.setSelected(isSelected());
+	arc.setPen(getPen());
+	arc.setSelected(isSelected());
+
+	size_t const n = vertices.size();
+	size_t const segments = isClosed() ? n : n - 1;
+	for (size_t i=0; i<segments; ++i) {
+		RS_PolylineVertex const& v1 = vertices[i];
+		RS_PolylineVertex const& v2 = vertices[(i + 1) % n];
+		RS_Vector const p1(v1.x, v1.y);
+		RS_Vector const p2(v2.x, v2.y);
+		RS_AtomicEntity* segment;
+		if (fabs(v1.bulge)<RS_TOLERANCE) {
+			line.setStartpoint(p1);
+			line.setEndpoint(p2);
+			segment = &line;
+		} else {
+			arc.setData(bulgeArc(p1, p2, v1.bulge));
+			arc.calculateBorders();
+			segment = &arc;
+		}
+		if (!visitor(segment)) return false;
+	}
+	return true;
+}
 
-        entity = new RS_Arc(this, d);
-        entity->setSelected(isSelected());
-        entity->setPen(RS_Pen(RS2::FlagInvalid));
-		entity->setLayer(nullptr);
-    }
 
-    return entity;
+std::unique_ptr<RS_Entity> RS_Polyline::getNearestSegment(const RS_Vector& coord,
+															int* index) const {
+	double minDist = RS_MAXDOUBLE;
+	int nearest = -1;
+	int i = 0;
+	visitSegments([&](RS_AtomicEntity* e) {
+		double const curDist = e->getDistanceToPoint(coord);
+		if (curDist<minDist) {
+			minDist = curDist;
+			nearest = i;
+		}
+		++i;
+		return true;
+	});
+	std::unique_ptr<RS_Entity> ret;
+	i = 0;
+	visitSegments([&](RS_AtomicEntity* e) {
+		if (i++!=nearest) return true;
+		ret.reset(e->clone());
+		return false;
+	});
+	if (index) {
+		*index = nearest;
+	}
+	return ret;
 }
 
 
@@ -302,6 +405,7 @@ RS_Entity* RS_Polyline::createVertex(const RS_Vector& v, double bulge, bool prep
  */
 void RS_Polyline::endPolyline() {
         RS_DEBUG->print("RS_Polyline::endPolyline");
+	unpack();
 
     if (isClosed()) {
                 RS_DEBUG->print("RS_Polyline::endPolyline: adding closing entity");
@@ -324,6 +428,12 @@ void RS_Polyline::endPolyline() {
 //RLZ: rewrite this:
 void RS_Polyline::setClosed(bool cl, double bulge) {
     Q_UNUSED(bulge);
+    if (isPacked()) {
+        // the closing segment is not stored, it starts at the last vertex
+        setClosed(cl);
+        calculateBorders();
+        return;
+    }
     bool areClosed = isClosed();
     setClosed(cl);
     if (isClosed()) {
@@ -338,6 +448,9 @@ void RS_Polyline::setClosed(bool cl, double bulge) {
  * @return The bulge of the closing entity.
  */
 double RS_Polyline::getClosingBulge() {
+    if (isPacked()) {
+        return isClosed() ? vertices.back().bulge : 0.0;
+    }
     if (isClosed()) {
                 RS_Entity* e = lastEntity();
 				if (e && e->rtti()==RS2::EntityArc) {
@@ -398,6 +511,14 @@ void RS_Polyline::addEntity(RS_Entity* /*entity*/) {
 
 RS_VectorSolutions RS_Polyline::getRefPoints() const{
 	RS_VectorSolutions ret({data.startpoint});
+	if (isPacked()) {
+		for (size_t i=1; i<vertices.size(); ++i)
+			ret.push_back(RS_Vector(vertices[i].x, vertices[i].y));
+		if (isClosed())
+			ret.push_back(data.startpoint);
+		ret.push_back(data.endpoint);
+		return ret;
+	}
 	for(auto e: *this){
 		if (e->isAtomic()) {
 			ret.push_back((static_cast<RS_AtomicEntity*>(e))->getEndpoint());
@@ -425,6 +546,340 @@ RS_Vector RS_Polyline::getNearestSelectedRef( const RS_Vector& coord,
     return RS_Entity::getNearestSelectedRef( coord, dist);
 }
 
+/*
+ * Entities of a packed polyline are created before they are accessed.
+ */
+void RS_Polyline::appendEntity(RS_Entity* entity) {
+	unpack();
+	RS_EntityContainer::appendEntity(entity);
+}
+
+void RS_Polyline::prependEntity(RS_Entity* entity) {
+	unpack();
+	RS_EntityContainer::prependEntity(entity);
+}
+
+void RS_Polyline::moveEntity(int index, QList<RS_Entity *>& entList) {
+	unpack();
+	RS_EntityContainer::moveEntity(index, entList);
+}
+
+void RS_Polyline::insertEntity(int index, RS_Entity* entity) {
+	unpack();
+	RS_EntityContainer::insertEntity(index, entity);
+}
+
+bool RS_Polyline::removeEntity(RS_Entity* entity) {
+	unpack();
+	return RS_EntityContainer::removeEntity(entity);
+}
+
+RS_Entity* RS_Polyline::firstEntity(RS2::ResolveLevel level) {
+	unpack();
+	return RS_EntityContainer::firstEntity(level);
+}
+
+RS_Entity* RS_Polyline::lastEntity(RS2::ResolveLevel level) {
+	unpack();
+	return RS_EntityContainer::lastEntity(level);
+}
+
+RS_Entity* RS_Polyline::nextEntity(RS2::ResolveLevel level) {
+	unpack();
+	return RS_EntityContainer::nextEntity(level);
+}
+
+RS_Entity* RS_Polyline::prevEntity(RS2::ResolveLevel level) {
+	unpack();
+	return RS_EntityContainer::prevEntity(level);
+}
+
+RS_Entity* RS_Polyline::entityAt(int index) {
+	unpack();
+	return RS_EntityContainer::entityAt(index);
+}
+
+void RS_Polyline::setEntityAt(int index,RS_Entity* en) {
+	unpack();
+	RS_EntityContainer::setEntityAt(index, en);
+}
+
+int RS_Polyline::findEntity(RS_Entity const* const entity) {
+	unpack();
+	return RS_EntityContainer::findEntity(entity);
+}
+
+void RS_Polyline::clear() {
+	vertices.clear();
+	RS_EntityContainer::clear();
+}
+
+unsigned RS_Polyline::count() const {
+	if (isPacked()) {
+		return isClosed() ? vertices.size() : vertices.size() - 1;
+	}
+	return RS_EntityContainer::count();
+}
+
+unsigned RS_Polyline::countDeep() const {
+	if (isPacked()) {
+		return count();
+	}
+	return RS_EntityContainer::countDeep();
+}
+
+unsigned RS_Polyline::countSelected(bool deep, std::set<RS2::EntityType> const& types) {
+	if (!isPacked()) {
+		return RS_EntityContainer::countSelected(deep, types);
+	}
+	// segments are selected with the polyline
+	unsigned c = 0;
+	if (isSelected()) {
+		visitSegments([&](RS_AtomicEntity* e) {
+			if (!types.size() || types.count(e->rtti()))
+				c++;
+			return true;
+		});
+	}
+	return c;
+}
+
+void RS_Polyline::selectWindow(RS_Vector v1, RS_Vector v2, bool select, bool cross) {
+	unpack();
+	RS_EntityContainer::selectWindow(v1, v2, select, cross);
+}
+
+void RS_Polyline::calculateBorders() {
+	if (!isPacked()) {
+		RS_EntityContainer::calculateBorders();
+		return;
+	}
+	resetBorders();
+	visitSegments([this](RS_AtomicEntity* e) {
+		minV = RS_Vector::minimum(e->getMin(), minV);
+		maxV = RS_Vector::maximum(e->getMax(), maxV);
+		return true;
+	});
+	bordersChanged();
+}
+
+void RS_Polyline::forcedCalculateBorders() {
+	if (!isPacked()) {
+		RS_EntityContainer::forcedCalculateBorders();
+		return;
+	}
+	calculateBorders();
+}
+
+double RS_Polyline::getLength() const {
+	if (!isPacked()) {
+		return RS_EntityContainer::getLength();
+	}
+	double ret = 0.0;
+	visitSegments([&ret](RS_AtomicEntity* e) {
+		ret += e->getLength();
+		return true;
+	});
+	return ret;
+}
+
+double RS_Polyline::areaLineIntegral() const {
+	if (!isPacked()) {
+		return RS_EntityContainer::areaLineIntegral();
+	}
+	double contourArea = 0.;
+	visitSegments([&contourArea](RS_AtomicEntity* e) {
+		contourArea += e->areaLineIntegral();
+		return true;
+	});
+	return fabs(contourArea);
+}
+
+RS_Vector RS_Polyline::getNearestEndpoint(const RS_Vector& coord,
+										  double* dist) const {
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestEndpoint(coord, dist);
+	}
+	double minDist = RS_MAXDOUBLE;
+	RS_Vector closestPoint(false);
+	for (RS_PolylineVertex const& v: vertices) {
+		RS_Vector const point(v.x, v.y);
+		double const curDist = coord.distanceTo(point);
+		if (curDist<minDist) {
+			closestPoint = point;
+			minDist = curDist;
+		}
+	}
+	if (dist && closestPoint.valid) {
+		*dist = minDist;
+	}
+	return closestPoint;
+}
+
+RS_Vector RS_Polyline::getNearestEndpoint(const RS_Vector& coord,
+										  double* dist, RS_Entity** pEntity) const {
+	if (pEntity) {
+		// the caller wants the segment
+		const_cast<RS_Polyline*>(this)->unpack();
+	}
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestEndpoint(coord, dist, pEntity);
+	}
+	return getNearestEndpoint(coord, dist);
+}
+
+RS_Vector RS_Polyline::getNearestPointOnEntity(const RS_Vector& coord,
+											   bool onEntity, double* dist,
+											   RS_Entity** entity) const {
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestPointOnEntity(coord, onEntity, dist, entity);
+	}
+	double minDist = RS_MAXDOUBLE;
+	RS_Vector point(false);
+	visitSegments([&](RS_AtomicEntity* e) {
+		double const curDist = e->getDistanceToPoint(coord);
+		if (curDist<minDist) {
+			minDist = curDist;
+			point = e->getNearestPointOnEntity(coord, onEntity, dist);
+		}
+		return true;
+	});
+	if (entity && point.valid) {
+		*entity = const_cast<RS_Polyline*>(this);
+	}
+	return point;
+}
+
+RS_Vector RS_Polyline::getNearestCenter(const RS_Vector& coord,
+										double* dist) const {
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestCenter(coord, dist);
+	}
+	double minDist = RS_MAXDOUBLE;
+	RS_Vector closestPoint(false);
+	visitSegments([&](RS_AtomicEntity* e) {
+		double curDist = RS_MAXDOUBLE;
+		RS_Vector const point = e->getNearestCenter(coord, &curDist);
+		if (point.valid && curDist<minDist) {
+			closestPoint = point;
+			minDist = curDist;
+		}
+		return true;
+	});
+	if (dist) {
+		*dist = minDist;
+	}
+	return closestPoint;
+}
+
+RS_Vector RS_Polyline::getNearestMiddle(const RS_Vector& coord,
+										double* dist,
+										int middlePoints) const {
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestMiddle(coord, dist, middlePoints);
+	}
+	double minDist = RS_MAXDOUBLE;
+	RS_Vector closestPoint(false);
+	visitSegments([&](RS_AtomicEntity* e) {
+		double curDist = RS_MAXDOUBLE;
+		RS_Vector const point = e->getNearestMiddle(coord, &curDist, middlePoints);
+		if (point.valid && curDist<minDist) {
+			closestPoint = point;
+			minDist = curDist;
+		}
+		return true;
+	});
+	if (dist) {
+		*dist = minDist;
+	}
+	return closestPoint;
+}
+
+RS_Vector RS_Polyline::getNearestDist(double distance,
+									  const RS_Vector& coord,
+									  double* dist) const {
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestDist(distance, coord, dist);
+	}
+	double minDist = RS_MAXDOUBLE;
+	RS_Vector point(false);
+	visitSegments([&](RS_AtomicEntity* e) {
+		double const curDist = e->getDistanceToPoint(coord);
+		if (curDist<minDist) {
+			minDist = curDist;
+			point = e->getNearestDist(distance, coord, dist);
+		}
+		return true;
+	});
+	return point;
+}
+
+RS_Vector RS_Polyline::getNearestIntersection(const RS_Vector& coord,
+											  double* dist) {
+	if (!isPacked()) {
+		return RS_EntityContainer::getNearestIntersection(coord, dist);
+	}
+	int index = -1;
+	std::unique_ptr<RS_Entity> const closest = getNearestSegment(coord, &index);
+	double minDist = RS_MAXDOUBLE;
+	RS_Vector closestPoint(false);
+	if (closest) {
+		int i = 0;
+		visitSegments([&](RS_AtomicEntity* e) {
+			if (i++==index) return true;
+			double curDist = RS_MAXDOUBLE;
+			RS_VectorSolutions const sol =
+					RS_Information::getIntersection(closest.get(), e, true);
+			RS_Vector const point = sol.getClosest(coord, &curDist, nullptr);
+			if (sol.getNumber()>0 && curDist<minDist) {
+				closestPoint = point;
+				minDist = curDist;
+			}
+			return true;
+		});
+	}
+	if (dist && closestPoint.valid) {
+		*dist = minDist;
+	}
+	return closestPoint;
+}
+
+double RS_Polyline::getDistanceToPoint(const RS_Vector& coord,
+									   RS_Entity** entity,
+									   RS2::ResolveLevel level,
+									   double solidDist) const {
+	if (entity) {
+		// the caller keeps the segment, a temporary one won't do
+		const_cast<RS_Polyline*>(this)->unpack();
+	}
+	if (!isPacked()) {
+		return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+	}
+	double minDist = RS_MAXDOUBLE;
+	visitSegments([&](RS_AtomicEntity* e) {
+		minDist = std::min(minDist, e->getDistanceToPoint(coord, nullptr, level, solidDist));
+		return true;
+	});
+	return minDist;
+}
+
+bool RS_Polyline::optimizeContours() {
+	unpack();
+	return RS_EntityContainer::optimizeContours();
+}
+
+bool RS_Polyline::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2) {
+	if (!isPacked()) {
+		return RS_EntityContainer::hasEndpointsWithinWindow(v1, v2);
+	}
+	for (RS_PolylineVertex const& v: vertices) {
+		if (RS_Vector(v.x, v.y).isInWindow(v1, v2))
+			return true;
+	}
+	return false;
+}
+
+
 /*
 void RS_Polyline::reorder() {
         // current point:
@@ -446,6 +901,7 @@ void RS_Polyline::reorder() {
   *@Author, Dongxu Li
   */
 bool RS_Polyline::offset(const RS_Vector& coord, const double& distance){
+    unpack();
     double dist;
     //find the nearest one
     int length=count();
@@ -581,6 +1037,10 @@ bool RS_Polyline::offset(const RS_Vector& coord, const double& distance){
 }
 
 void RS_Polyline::move(const RS_Vector& offset) {
+    for (RS_PolylineVertex& v: vertices) {
+        v.x += offset.x;
+        v.y += offset.y;
+    }
     RS_EntityContainer::move(offset);
     data.startpoint.move(offset);
     data.endpoint.move(offset);
@@ -595,6 +1055,11 @@ void RS_Polyline::rotate(const RS_Vector& center, const double& angle) {
 
 
 void RS_Polyline::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
+    for (RS_PolylineVertex& v: vertices) {
+        RS_Vector const p = RS_Vector(v.x, v.y).rotate(center, angleVector);
+        v.x = p.x;
+        v.y = p.y;
+    }
     RS_EntityContainer::rotate(center, angleVector);
     data.startpoint.rotate(center, angleVector);
     data.endpoint.rotate(center, angleVector);
@@ -604,6 +1069,15 @@ void RS_Polyline::rotate(const RS_Vector& center, const RS_Vector& angleVector)
 
 
 void RS_Polyline::scale(const RS_Vector& center, const RS_Vector& factor) {
+    if (fabs(factor.x - factor.y)>RS_TOLERANCE) {
+        // arcs are not kept by non-uniform scaling
+        unpack();
+    }
+    for (RS_PolylineVertex& v: vertices) {
+        RS_Vector const p = RS_Vector(v.x, v.y).scale(center, factor);
+        v.x = p.x;
+        v.y = p.y;
+    }
     RS_EntityContainer::scale(center, factor);
     data.startpoint.scale(center, factor);
     data.endpoint.scale(center, factor);
@@ -613,6 +1087,12 @@ void RS_Polyline::scale(const RS_Vector& center, const RS_Vector& factor) {
 
 
 void RS_Polyline::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2) {
+    for (RS_PolylineVertex& v: vertices) {
+        RS_Vector const p = RS_Vector(v.x, v.y).mirror(axisPoint1, axisPoint2);
+        v.x = p.x;
+        v.y = p.y;
+        v.bulge = -v.bulge;
+    }
     RS_EntityContainer::mirror(axisPoint1, axisPoint2);
     data.startpoint.mirror(axisPoint1, axisPoint2);
     data.endpoint.mirror(axisPoint1, axisPoint2);
@@ -622,6 +1102,7 @@ void RS_Polyline::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint
 
 
 void RS_Polyline::moveRef(const RS_Vector& ref, const RS_Vector& offset) {
+        unpack();
         RS_EntityContainer::moveRef(ref, offset);
     if (ref.distanceTo(data.startpoint)<1.0e-4) {
        data.startpoint.move(offset);
@@ -633,7 +1114,13 @@ void RS_Polyline::moveRef(const RS_Vector& ref, const RS_Vector& offset) {
     //update();
 }
 
+void RS_Polyline::moveSelectedRef(const RS_Vector& ref, const RS_Vector& offset) {
+	unpack();
+	RS_EntityContainer::moveSelectedRef(ref, offset);
+}
+
 void RS_Polyline::revertDirection() {
+	unpack();
 	RS_EntityContainer::revertDirection();
 	RS_Vector tmp = data.startpoint;
 	data.startpoint = data.endpoint;
@@ -644,6 +1131,7 @@ void RS_Polyline::stretch(const RS_Vector& firstCorner,
                           const RS_Vector& secondCorner,
                           const RS_Vector& offset) {
 
+    unpack();
     if (data.startpoint.isInWindow(firstCorner, secondCorner)) {
         data.startpoint.move(offset);
     }
@@ -665,23 +1153,17 @@ void RS_Polyline::draw(RS_Painter* painter,RS_GraphicView* view, double& /*patte
         return;
     }
 
-    // draw first entity and set correct pen:
-    RS_Entity* e = firstEntity(RS2::ResolveNone);
-    // We get the pen from the entitycontainer and apply it to the
-    // first line so that subsequent line are draw in the right color
-    //prevent segfault if polyline is empty
-	if (e) {
-        RS_Pen p=this->getPen(true);
-        e->setPen(p);
-        double patternOffset=0.;
-        view->drawEntity(painter, e, patternOffset);
-
-        e = nextEntity(RS2::ResolveNone);
-		while(e) {
+    // the pen of the polyline is set, segments are drawn with it
+    double patternOffset=0.;
+	visitSegments([&](RS_AtomicEntity* e) {
+        // skip segments outside of the viewport, the pattern continues
+        // behind them (pattern offsets are in pixels)
+        if (!e->isCullable() || e->isVisibleInWindow(view))
             view->drawEntityPlain(painter, e, patternOffset);
-            e = nextEntity(RS2::ResolveNone);
-        }
-    }
+        else
+            patternOffset -= e->getLength()*view->getFactor().x;
+        return true;
+    });
 }
 
 
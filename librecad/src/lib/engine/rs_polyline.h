@@ -28,9 +28,13 @@
 #ifndef RS_POLYLINE_H
 #define RS_POLYLINE_H
 
+#include <functional>
+#include <memory>
+#include <vector>
 #include "rs_entity.h"
 #include "rs_entitycontainer.h"
 
+class RS_AtomicEntity;
 
 
 /**
@@ -49,9 +53,26 @@ struct RS_PolylineData : public RS_Flags {
 
 std::ostream& operator << (std::ostream& os, const RS_PolylineData& pd);
 
+/**
+ * Vertex of a packed polyline: coordinate and the bulge of the segment
+ * starting at the vertex (see DXF documentation).
+ */
+struct RS_PolylineVertex {
+    double x;
+    double y;
+    double bulge;
+};
+
 /**
  * Class for a poly line entity (lots of connected lines and arcs).
  *
+ * Polylines created from a vertex list with appendVertexs() are packed:
+ * they keep the vertices in an array instead of line and arc entities.
+ * Drawing, borders, length, area, intersections and the nearest point
+ * queries work on the array with one temporary segment. The segment
+ * entities are created with unpack() whenever the polyline is iterated or
+ * edited, or a segment entity is requested, e.g. for explode or trim.
+ *
  * @author Andrew Mustun
  */
 class RS_Polyline : public RS_EntityContainer {
@@ -129,6 +150,29 @@ public:
 
 	void appendVertexs(const std::vector< std::pair<RS_Vector, double> >& vl);
 
+    /** @return true if the vertices are kept in the packed array */
+    bool isPacked() const {
+        return !vertices.empty();
+    }
+    /** @return the vertices of a packed polyline */
+    const std::vector<RS_PolylineVertex>& getPackedVertices() const {
+        return vertices;
+    }
+    void unpack();
+    /**
+     * Visits the segments in order, the visitor returns false to stop.
+     * Segments of a packed polyline are temporary and only valid
+     * during the call of the visitor.
+     */
+    bool visitSegments(const std::function<bool(RS_AtomicEntity*)>& visitor) const;
+    /**
+     * @return a copy of the segment closest to coord, which is not part
+     * of the polyline, or nullptr for a polyline without segments
+     * @param index receives the position of the segment
+     */
+    std::unique_ptr<RS_Entity> getNearestSegment(const RS_Vector& coord,
+                                                 int* index=nullptr) const;
+
         virtual void setNextBulge(double bulge) {
                 nextBulge = bulge;
         }
@@ -137,6 +181,63 @@ public:
     virtual void removeLastVertex();
     virtual void endPolyline();
 
+    virtual void appendEntity(RS_Entity* entity);
+    virtual void prependEntity(RS_Entity* entity);
+    virtual void moveEntity(int index, QList<RS_Entity *>& entList);
+    virtual void insertEntity(int index, RS_Entity* entity);
+    virtual bool removeEntity(RS_Entity* entity);
+    virtual RS_Entity* firstEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* lastEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* nextEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* prevEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* entityAt(int index);
+    virtual void setEntityAt(int index,RS_Entity* en);
+    virtual int findEntity(RS_Entity const* const entity);
+    virtual void clear();
+    virtual unsigned count() const;
+    virtual unsigned countDeep() const;
+    virtual unsigned countSelected(bool deep=true, std::set<RS2::EntityType> const& types = std::set<RS2::EntityType>());
+
+    virtual void selectWindow(RS_Vector v1, RS_Vector v2,
+                              bool select=true, bool cross=false);
+    virtual void calculateBorders();
+    virtual void forcedCalculateBorders();
+    virtual double getLength() const;
+    virtual double areaLineIntegral() const;
+
+    virtual RS_Vector getNearestEndpoint(const RS_Vector& coord,
+                                         double* dist = nullptr)const;
+    virtual RS_Vector getNearestEndpoint(const RS_Vector& coord,
+                                         double* dist, RS_Entity** pEntity ) const;
+    /**
+     * A packed polyline returns itself as entity, unpack() it to get
+     * the segment.
+     */
+    virtual RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+                                              bool onEntity = true,
+                                              double* dist = nullptr,
+                                              RS_Entity** entity=nullptr) const;
+    virtual RS_Vector getNearestCenter(const RS_Vector& coord,
+                                       double* dist = nullptr) const;
+    virtual RS_Vector getNearestMiddle(const RS_Vector& coord,
+                                       double* dist = nullptr,
+                                       int middlePoints = 1 ) const;
+    virtual RS_Vector getNearestDist(double distance,
+                                     const RS_Vector& coord,
+                                     double* dist = nullptr) const;
+    virtual RS_Vector getNearestIntersection(const RS_Vector& coord,
+                                             double* dist = nullptr);
+    /**
+     * A packed polyline is unpacked if entity is requested, callers keep
+     * the segment. Containers only request it when resolving segments.
+     */
+    virtual double getDistanceToPoint(const RS_Vector& coord,
+                                      RS_Entity** entity,
+                                      RS2::ResolveLevel level=RS2::ResolveNone,
+                                      double solidDist = RS_MAXDOUBLE) const;
+    virtual bool optimizeContours();
+    virtual bool hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2);
+
     //virtual void reorder();
 
     virtual bool offset(const RS_Vector& coord, const double& distance);
@@ -150,6 +251,7 @@ public:
                          const RS_Vector& offset);
 
     virtual void moveRef(const RS_Vector& ref, const RS_Vector& offset);
+    virtual void moveSelectedRef(const RS_Vector& ref, const RS_Vector& offset);
 	virtual void revertDirection();
 
 
@@ -161,11 +263,14 @@ public:
 protected:
     virtual RS_Entity* createVertex(const RS_Vector& v,
                 double bulge=0.0, bool prepend=false);
+    virtual void prepareEntities() const;
 
 protected:
     RS_PolylineData data;
     RS_Entity* closingEntity;
         double nextBulge;
+    /** vertices of a packed polyline, empty if the segments are entities */
+    std::vector<RS_PolylineVertex> vertices;
 };
 
 #endif
@@ -138,6 +138,7 @@ void RS_Solid::calculateBorders() {
             maxV = RS_Vector::maximum(maxV, data.corner[i]);
         }
     }
+    bordersChanged();
 }
 
 
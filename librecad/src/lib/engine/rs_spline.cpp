@@ -25,6 +25,8 @@
 **********************************************************************/
 
 
+#include <algorithm>
+#include <cmath>
 #include "rs_spline.h"
 
 
@@ -35,6 +37,138 @@
 #include "rs_graphic.h"
 
 
+namespace {
+/** tolerance of the child lines, relative to the control polygon size */
+const double relativeTolerance = 5e-4;
+/** knot spans are split into at most 2^maxSpanDepth chords */
+const int maxSpanDepth = 12;
+
+/**
+ * @return depth of the subdivision of knot spans into at most segments
+ * chords, $SPLINESEGS bounds the chords per knot span this way
+ */
+int spanDepth(int segments) {
+	int depth = 0;
+	while (depth < maxSpanDepth && (2 << depth) <= segments) {
+		++depth;
+	}
+	return depth;
+}
+
+/** @return point of the segment p0, p1 closest to coord */
+RS_Vector nearestOnSegment(const RS_Vector& p0, const RS_Vector& p1,
+						   const RS_Vector& coord) {
+	RS_Vector const dir = p1 - p0;
+	double const length2 = dir.squared();
+	if (length2 < RS_TOLERANCE2) {
+		return p0;
+	}
+	double const t = RS_Vector::dotP(coord - p0, dir)/length2;
+	return p0 + dir*std::min(1., std::max(0., t));
+}
+
+/**
+ * The uniform B-spline of RS_SplineData, evaluated by de Boor's algorithm.
+ * Open splines have knots of multiplicity order at the ends as knot().
+ * Closed splines repeat the first degree control points and use the
+ * periodic knots of knotu().
+ */
+class SplineCurve {
+public:
+	SplineCurve(const RS_SplineData& data):
+		degree(data.degree)
+	  ,points(data.controlPoints)
+	{
+		if (data.closed) {
+			for (size_t i=0; i<degree; ++i) {
+				points.push_back(data.controlPoints.at(i));
+			}
+		}
+		int const n = points.size();
+		int const p = degree;
+		knots.resize(n + p + 1);
+		for (int i=0; i<n+p+1; ++i) {
+			knots[i] = data.closed ? i : std::min(std::max(i - p, 0), n - p);
+		}
+	}
+
+	/**
+	 * @return point at parameter t of the knot span [knots[span],
+	 * knots[span+1]], degree <= span < number of control points
+	 */
+	RS_Vector evaluate(size_t span, double t) const {
+		RS_Vector d[4];
+		for (size_t j=0; j<=degree; ++j) {
+			d[j] = points[span - degree + j];
+		}
+		for (size_t r=1; r<=degree; ++r) {
+			for (size_t j=degree; j>=r; --j) {
+				double const u0 = knots[span - degree + j];
+				double const u1 = knots[span + 1 + j - r];
+				double const alpha = (t - u0)/(u1 - u0);
+				d[j] = d[j-1]*(1. - alpha) + d[j]*alpha;
+			}
+		}
+		return d[degree];
+	}
+
+	void tessellate(double tolerance, int maxDepth, std::vector<RS_Vector>& out) const {
+		out.push_back(evaluate(degree, knots[degree]));
+		for (size_t span=degree; span<points.size(); ++span) {
+			double const t1 = knots[span+1];
+			subdivide(span, knots[span], out.back(), t1, evaluate(span, t1),
+					  0, maxDepth, tolerance*tolerance, out);
+		}
+	}
+
+private:
+	/** appends the points after p0 up to p1, halving until flat */
+	void subdivide(size_t span, double t0, const RS_Vector& p0,
+				   double t1, const RS_Vector& p1,
+				   int depth, int maxDepth, double tolerance2,
+				   std::vector<RS_Vector>& out) const {
+		double const tm = 0.5*(t0 + t1);
+		RS_Vector const pm = evaluate(span, tm);
+		// an inflection can put the middle point onto the chord
+		int const minDepth = degree > 1 ? 1 : 0;
+		if (depth >= maxDepth
+				|| (depth >= minDepth && chordDistance2(pm, p0, p1) <= tolerance2)) {
+			out.push_back(p1);
+			return;
+		}
+		subdivide(span, t0, p0, tm, pm, depth + 1, maxDepth, tolerance2, out);
+		subdivide(span, tm, pm, t1, p1, depth + 1, maxDepth, tolerance2, out);
+	}
+
+	/** @return squared distance of p to the chord p0, p1 */
+	static double chordDistance2(const RS_Vector& p,
+								 const RS_Vector& p0, const RS_Vector& p1) {
+		RS_Vector const chord = p1 - p0;
+		double const length2 = chord.squared();
+		if (length2 < RS_TOLERANCE2) {
+			return (p - p0).squared();
+		}
+		double const cross = RS_Vector::crossP(chord, p - p0).z;
+		return cross*cross/length2;
+	}
+
+	size_t degree;
+	std::vector<RS_Vector> points;
+	std::vector<double> knots;
+};
+
+/** @return diagonal of the borders of the control points */
+double controlPolygonSize(const std::vector<RS_Vector>& controlPoints) {
+	RS_Vector vMin(RS_MAXDOUBLE, RS_MAXDOUBLE);
+	RS_Vector vMax(RS_MINDOUBLE, RS_MINDOUBLE);
+	for (const RS_Vector& vp: controlPoints) {
+		vMin = RS_Vector::minimum(vMin, vp);
+		vMax = RS_Vector::maximum(vMax, vp);
+	}
+	return vMin.distanceTo(vMax);
+}
+}
+
 RS_SplineData::RS_SplineData(int _degree, bool _closed):
 	degree(_degree)
   ,closed(_closed)
@@ -53,7 +187,7 @@ std::ostream& operator << (std::ostream& os, const RS_SplineData& ld) {
  */
 RS_Spline::RS_Spline(RS_EntityContainer* parent,
                      const RS_SplineData& d)
-        :RS_EntityContainer(parent), data(d) {
+        :RS_EntityContainer(parent), data(d), maxDepth(spanDepth(8)) {
     calculateBorders();
 }
 
@@ -68,23 +202,19 @@ RS_Entity* RS_Spline::clone() const{
 
 
 void RS_Spline::calculateBorders() {
-    /*minV = RS_Vector::minimum(data.startpoint, data.endpoint);
-    maxV = RS_Vector::maximum(data.startpoint, data.endpoint);
-
-    QList<RS_Vector>::iterator it;
-    for (it = data.controlPoints.begin();
-    it!=data.controlPoints.end(); ++it) {
-
-    minV = RS_Vector::minimum(*it, minV);
-    maxV = RS_Vector::maximum(*it, maxV);
-}
-    */
+    resetBorders();
+    for (const RS_Vector& vp: polygon) {
+        minV = RS_Vector::minimum(vp, minV);
+        maxV = RS_Vector::maximum(vp, maxV);
+    }
+    bordersChanged();
 }
 
 
 void RS_Spline::setDegree(size_t deg) {
 	if (deg>=1 && deg<=3) {
 		data.degree = deg;
+		drawPoints.reset();
 	}
 }
 
@@ -143,6 +273,9 @@ void RS_Spline::update() {
     RS_DEBUG->print("RS_Spline::update");
 
     clear();
+    drawPoints.reset();
+    polygon.clear();
+    maxDepth = spanDepth(getGraphicVariableInt("$SPLINESEGS", 8));
 
     if (isUndone()) {
         return;
@@ -158,66 +291,88 @@ void RS_Spline::update() {
         return;
     }
 
-    resetBorders();
+    // chords within a fraction of the size of the spline
+    double const size = controlPolygonSize(data.controlPoints);
+    polygon = tessellate(std::max(size*relativeTolerance, RS_TOLERANCE), maxDepth);
+    calculateBorders();
+}
 
-	std::vector<RS_Vector> tControlPoints = data.controlPoints;
 
-    if (data.closed) {
-		for (size_t i=0; i<data.degree; ++i) {
-			tControlPoints.push_back(data.controlPoints.at(i));
-        }
+
+/**
+ * Lines along the polygon, built on the first request and dropped by
+ * update().
+ */
+void RS_Spline::buildLines() {
+    if (!entities.isEmpty()) {
+        return;
     }
+    for (size_t i=1; i<polygon.size(); ++i) {
+        RS_Line* line = new RS_Line(this, RS_LineData(polygon[i-1], polygon[i]));
+        line->setLayer(nullptr);
+        line->setPen(RS_Pen(RS2::FlagInvalid));
+        addEntity(line);
+    }
+}
+
 
-	size_t i;
-	const size_t npts = tControlPoints.size();
-    // order:
-	const size_t  k = data.degree+1;
-    // resolution:
-	const size_t  p1 = getGraphicVariableInt("$SPLINESEGS", 8) * npts;
 
-	std::vector<double> b(npts*3+2, 0.);
-	std::vector<double> h(npts+2, 1.);
-	std::vector<double> p(3*p1+2, 0.);
+void RS_Spline::prepareEntities() const {
+    const_cast<RS_Spline*>(this)->buildLines();
+}
 
-    i = 1;
-	for(auto const& vp: tControlPoints){
-		b[i] = vp.x;
-		b[i+1] = vp.y;
 
-        RS_DEBUG->print("RS_Spline::update: b[%d]: %f/%f", i, b[i], b[i+1]);
-        i+=3;
-    }
 
-    if (data.closed) {
-        rbsplinu(npts,k,p1,b,h,p);
-    } else {
-        rbspline(npts,k,p1,b,h,p);
-    }
+RS_Entity* RS_Spline::firstEntity(RS2::ResolveLevel level) {
+    buildLines();
+    return RS_EntityContainer::firstEntity(level);
+}
 
-    RS_Vector prev(false);
-	for (i = 1; i <= 3*p1; i += 3) {
-        if (prev.valid) {
-            RS_Line* line = new RS_Line(this,
-                                        RS_LineData(prev, RS_Vector(p[i], p[i+1])));
-			line->setLayer(nullptr);
-            line->setPen(RS_Pen(RS2::FlagInvalid));
-            addEntity(line);
-        }
-        prev = RS_Vector(p[i], p[i+1]);
 
-        minV = RS_Vector::minimum(prev, minV);
-        maxV = RS_Vector::maximum(prev, maxV);
-	}
+
+RS_Entity* RS_Spline::lastEntity(RS2::ResolveLevel level) {
+    buildLines();
+    return RS_EntityContainer::lastEntity(level);
+}
+
+
+
+RS_Entity* RS_Spline::entityAt(int index) {
+    buildLines();
+    return RS_EntityContainer::entityAt(index);
+}
+
+
+
+/** @return number of chords of the polygon */
+unsigned RS_Spline::count() const {
+    return polygon.size()>1 ? polygon.size()-1 : 0;
+}
+
+
+
+unsigned RS_Spline::countDeep() const {
+    return count();
+}
+
+
+
+double RS_Spline::getLength() const {
+    double ret = 0.;
+    for (size_t i=1; i<polygon.size(); ++i) {
+        ret += polygon[i-1].distanceTo(polygon[i]);
+    }
+    return ret;
 }
 
 RS_Vector RS_Spline::getStartpoint() const {
-   if (data.closed) return RS_Vector(false);
-   return static_cast<RS_Line*>(const_cast<RS_Spline*>(this)->firstEntity())->getStartpoint();
+   if (data.closed || polygon.empty()) return RS_Vector(false);
+   return polygon.front();
 }
 
 RS_Vector RS_Spline::getEndpoint() const {
-   if (data.closed) return RS_Vector(false);
-   return static_cast<RS_Line*>(const_cast<RS_Spline*>(this)->lastEntity())->getEndpoint();
+   if (data.closed || polygon.empty()) return RS_Vector(false);
+   return polygon.back();
 }
 
 
@@ -254,13 +409,43 @@ RS_Vector RS_Spline::getNearestEndpoint(const RS_Vector& coord,
 
 
 
-/*
-// The default implementation of RS_EntityContainer is inaccurate but
-//   has to do for now..
 RS_Vector RS_Spline::getNearestPointOnEntity(const RS_Vector& coord,
-        bool onEntity, double* dist, RS_Entity** entity) {
+                                             bool /*onEntity*/, double* dist,
+                                             RS_Entity** entity) const {
+    RS_Vector ret(false);
+    double minDist = RS_MAXDOUBLE;
+    for (size_t i=1; i<polygon.size(); ++i) {
+        RS_Vector const vp = nearestOnSegment(polygon[i-1], polygon[i], coord);
+        double const d = vp.distanceTo(coord);
+        if (d<minDist) {
+            minDist = d;
+            ret = vp;
+        }
+    }
+    if (dist!=nullptr) {
+        *dist = minDist;
+    }
+    if (entity!=nullptr && ret.valid) {
+        *entity = const_cast<RS_Spline*>(this);
+    }
+    return ret;
+}
+
+
+
+double RS_Spline::getDistanceToPoint(const RS_Vector& coord,
+                                     RS_Entity** entity,
+                                     RS2::ResolveLevel level,
+                                     double solidDist) const {
+    if (entity && level!=RS2::ResolveNone) {
+        // the caller resolves the lines, e.g. to intersect one of them
+        prepareEntities();
+        return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+    }
+    double dist = RS_MAXDOUBLE;
+    getNearestPointOnEntity(coord, true, &dist, entity);
+    return dist;
 }
-*/
 
 
 
@@ -301,10 +486,14 @@ RS_Vector RS_Spline::getNearestDist(double /*distance*/,
 
 
 void RS_Spline::move(const RS_Vector& offset) {
-    RS_EntityContainer::move(offset);
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.move(offset);
     }
+	for (RS_Vector& vp: polygon) {
+		vp.move(offset);
+	}
+    RS_EntityContainer::move(offset);
+	drawPoints.reset();
 //    update();
 }
 
@@ -317,10 +506,15 @@ void RS_Spline::rotate(const RS_Vector& center, const double& angle) {
 
 
 void RS_Spline::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
-	RS_EntityContainer::rotate(center, angleVector);
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.rotate(center, angleVector);
 	}
+	for (RS_Vector& vp: polygon) {
+		vp.rotate(center, angleVector);
+	}
+	// borders from the rotated polygon:
+	RS_EntityContainer::rotate(center, angleVector);
+	drawPoints.reset();
 //    update();
 }
 
@@ -338,6 +532,12 @@ void RS_Spline::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2)
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.mirror(axisPoint1, axisPoint2);
 	}
+	for (RS_Vector& vp: polygon) {
+		vp.mirror(axisPoint1, axisPoint2);
+	}
+	RS_EntityContainer::mirror(axisPoint1, axisPoint2);
+	calculateBorders();
+	drawPoints.reset();
 
 //    update();
 }
@@ -356,6 +556,9 @@ void RS_Spline::moveRef(const RS_Vector& ref, const RS_Vector& offset) {
 
 void RS_Spline::revertDirection() {
 	std::reverse(data.controlPoints.begin(), data.controlPoints.end());
+	std::reverse(polygon.begin(), polygon.end());
+	clear();
+	drawPoints.reset();
 }
 
 
@@ -366,22 +569,39 @@ void RS_Spline::draw(RS_Painter* painter, RS_GraphicView* view, double& /*patter
 	if (painter==nullptr || view==nullptr) {
         return;
     }
+    if (count()==0
+            || view->isDrawnSelected(this)!=painter->shouldDrawSelected()) {
+        return;
+    }
 
+    // chords within a fraction of a pixel, sampled again on zoom only
+    double const pixels = painter->getDrawingMode()==RS2::ModePreview ? 2. : 0.25;
+    double const size = getMin().distanceTo(getMax());
+    double const tolerance = std::max(pixels/view->getFactor().x,
+                                      std::max(size*1e-6, RS_TOLERANCE));
+    int const level = static_cast<int>(floor(log2(tolerance)));
+    // render threads may tessellate at the same time, the last one is kept.
+    // $SPLINESEGS only limits the polygon, the drawing follows the zoom.
+    std::shared_ptr<const DrawPoints> cache = std::atomic_load(&drawPoints);
+    if (!cache || cache->level!=level) {
+        cache = std::make_shared<const DrawPoints>(
+                    DrawPoints{level, tessellate(ldexp(1., level), maxSpanDepth)});
+        std::atomic_store(&drawPoints, cache);
+    }
+    std::vector<RS_Vector> const& points = cache->points;
+    if (points.size()<2) {
+        return;
+    }
 
-    RS_Entity* e=firstEntity(RS2::ResolveNone);
-	if (e) {
-        RS_Pen p=this->getPen(true);
-        e->setPen(p);
-        double patternOffset(0.0);
-        view->drawEntity(painter, e, patternOffset);
-        //RS_DEBUG->print("offset: %f\nlength was: %f", offset, e->getLength());
-
-        e = nextEntity(RS2::ResolveNone);
-		while(e) {
-            view->drawEntityPlain(painter, e, patternOffset);
-            e = nextEntity(RS2::ResolveNone);
-            //RS_DEBUG->print("offset: %f\nlength was: %f", offset, e->getLength());
-        }
+    // the pen of the spline is set, segments are drawn with it
+    RS_Line line(nullptr, RS_LineData(points.front(), points.front()));
+    line.setPen(getPen());
+    line.setSelected(isSelected());
+    double patternOffset(0.0);
+    for (size_t i=1; i<points.size(); ++i) {
+        line.setStartpoint(points[i-1]);
+        line.setEndpoint(points[i]);
+        line.draw(painter, view, patternOffset);
     }
 }
 
@@ -466,11 +686,24 @@ const std::vector<RS_Vector>& RS_Spline::getControlPoints() const{
 
 
 
+std::vector<RS_Vector> RS_Spline::tessellate(double tolerance, int depth) const {
+	std::vector<RS_Vector> points;
+	if (data.degree<1 || data.degree>3
+			|| data.controlPoints.size() < data.degree+1) {
+		return points;
+	}
+	SplineCurve(data).tessellate(tolerance, depth, points);
+	return points;
+}
+
+
+
 /**
  * Appends the given point to the control points.
  */
 void RS_Spline::addControlPoint(const RS_Vector& v) {
 	data.controlPoints.push_back(v);
+	drawPoints.reset();
 }
 
 
@@ -480,6 +713,7 @@ void RS_Spline::addControlPoint(const RS_Vector& v) {
  */
 void RS_Spline::removeLastControlPoint() {
     data.controlPoints.pop_back();
+    drawPoints.reset();
 }
 
 
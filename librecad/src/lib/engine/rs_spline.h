@@ -28,6 +28,7 @@
 #ifndef RS_SPLINE_H
 #define RS_SPLINE_H
 
+#include <memory>
 #include <vector>
 #include "rs_entitycontainer.h"
 
@@ -165,8 +166,22 @@ public:
 
     virtual RS_Vector getNearestEndpoint(const RS_Vector& coord,
 										 double* dist = nullptr)const;
-    //virtual RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
-	//        bool onEntity=true, double* dist = nullptr, RS_Entity** entity=nullptr);
+    /** The spline itself is returned as entity. */
+    virtual RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+                                              bool onEntity=true, double* dist = nullptr,
+                                              RS_Entity** entity=nullptr) const;
+    /** Returns one of the lines as entity if the level resolves them. */
+    virtual double getDistanceToPoint(const RS_Vector& coord,
+                                      RS_Entity** entity,
+                                      RS2::ResolveLevel level=RS2::ResolveNone,
+                                      double solidDist = RS_MAXDOUBLE) const;
+    virtual double getLength() const;
+    virtual unsigned count() const;
+    virtual unsigned countDeep() const;
+
+    virtual RS_Entity* firstEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* lastEntity(RS2::ResolveLevel level=RS2::ResolveNone);
+    virtual RS_Entity* entityAt(int index);
     virtual RS_Vector getNearestCenter(const RS_Vector& coord,
 									   double* dist = nullptr)const;
     virtual RS_Vector getNearestMiddle(const RS_Vector& coord,
@@ -177,10 +192,6 @@ public:
 									 double* dist = nullptr)const;
         //virtual RS_Vector getNearestRef(const RS_Vector& coord,
 		//                                 double* dist = nullptr);
-        /*virtual double getDistanceToPoint(const RS_Vector& coord,
-									  RS_Entity** entity=nullptr,
-                                      RS2::ResolveLevel level=RS2::ResolveNone,
-                                                                          double solidDist = RS_MAXDOUBLE);*/
 
         virtual void addControlPoint(const RS_Vector& v);
         virtual void removeLastControlPoint();
@@ -196,6 +207,13 @@ public:
 
         virtual void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset);
 		const std::vector<RS_Vector>& getControlPoints() const;
+		/**
+		 * @return points along the spline, the chords between them are
+		 * at most about tolerance away from the curve. Sampled by de Boor
+		 * evaluation, densely where the curvature is high. Knot spans
+		 * are split into at most 2^depth chords.
+		 */
+		std::vector<RS_Vector> tessellate(double tolerance, int depth) const;
 
         friend std::ostream& operator << (std::ostream& os, const RS_Spline& l);
 
@@ -212,7 +230,29 @@ public:
 							 const std::vector<double>& b, const std::vector<double>& h, std::vector<double>& p);
 
 protected:
+		/** Builds the lines along the polygon, for code iterating them. */
+		virtual void prepareEntities() const;
+		void buildLines();
+
 		RS_SplineData data;
+		/**
+		 * Points along the spline, within a fraction of the size of the
+		 * spline. Lines along them are only built when the sub-entities
+		 * are requested, e.g. for hatch contours.
+		 */
+		std::vector<RS_Vector> polygon;
+		/** knot spans of the polygon are split into at most 2^maxDepth chords, see $SPLINESEGS */
+		int maxDepth;
+		/** points drawn at a zoom, level is the log2 of their tolerance */
+		struct DrawPoints {
+			int level;
+			std::vector<RS_Vector> points;
+		};
+		/**
+		 * Points drawn at the current zoom, shared by clones until their
+		 * update(). Render threads replace them atomically.
+		 */
+		mutable std::shared_ptr<const DrawPoints> drawPoints;
 }
 ;
 
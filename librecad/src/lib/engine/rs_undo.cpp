@@ -25,7 +25,9 @@
 **********************************************************************/
 
 
+#include <algorithm>
 #include "qc_applicationwindow.h"
+#include "rs_settings.h"
 #include "rs_undocycle.h"
 #include "rs_undo.h"
 
@@ -80,6 +82,47 @@ void RS_Undo::addUndoCycle(std::shared_ptr<RS_UndoCycle> const& i) {
 
 
 
+/**
+ * Drops the oldest undo cycles while the undo list keeps more memory
+ * than the setting "/Defaults/UndoMemoryLimit" in MB, 0 for no limit.
+ * The last cycle is always kept.
+ */
+void RS_Undo::trimUndoList() {
+	// read once for all documents and blocks
+	static size_t const limit =
+			RS_SETTINGS->readNumEntry("/Defaults/UndoMemoryLimit", 256) * size_t(1024*1024);
+	if (limit==0) return;
+
+	size_t total = 0;
+	for (auto const& cycle: undoList) {
+		if (cycle) total += cycle->memory;
+	}
+	while (total > limit && undoPointer > 0) {
+		std::shared_ptr<RS_UndoCycle> l = undoList.front();
+		undoList.pop_front();
+		--undoPointer;
+		if (!l) continue;
+		total -= std::min(total, l->memory);
+		// entities undone for good, unless still needed by another cycle:
+		for (auto u: l->undoables) {
+			if (!u || u->undoRtti()==RS2::UndoableDelta || !u->isUndone())
+				continue;
+			bool referenced = false;
+			for (auto const& cycle: undoList) {
+				if (cycle && cycle->undoables.count(u)) {
+					referenced = true;
+					break;
+				}
+			}
+			if (!referenced) {
+				removeUndoable(u);
+			}
+		}
+	}
+}
+
+
+
 /**
  * Starts a new cycle for one undo step. Every undoable that is
  * added after calling this method goes into this cycle.
@@ -131,7 +174,11 @@ void RS_Undo::addUndoable(RS_Undoable* u) {
  * Ends the current undo cycle.
  */
 void RS_Undo::endUndoCycle() {
+    if (currentCycle) {
+        currentCycle->memory = currentCycle->memoryUsage();
+    }
     addUndoCycle(currentCycle);
+    trimUndoList();
     QC_ApplicationWindow::getAppWindow()->setUndoEnable(true);
     QC_ApplicationWindow::getAppWindow()->setRedoEnable(false);
     currentCycle = NULL;
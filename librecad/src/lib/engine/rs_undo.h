@@ -28,6 +28,7 @@
 #ifndef RS_UNDO_H
 #define RS_UNDO_H
 
+#include <cstddef>
 #include <memory>
 #include <QList>
 
@@ -79,6 +80,7 @@ public:
 protected:
 
 	void addUndoCycle(std::shared_ptr<RS_UndoCycle> const& i);
+	void trimUndoList();
     //! List of undo list items. every item is something that can be undone.
 	QList<std::shared_ptr<RS_UndoCycle>> undoList;
 
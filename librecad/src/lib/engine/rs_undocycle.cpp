@@ -1,11 +1,15 @@
+#include <algorithm>
 #include"rs_undocycle.h"
+#include "lc_undodelta.h"
 
 /**
  * Adds an Undoable to this Undo Cycle. Every Cycle can contain one or
  * more Undoables.
  */
 void RS_UndoCycle::addUndoable(RS_Undoable* u) {
-	undoables.insert(u);
+	if (undoables.insert(u).second && u->undoRtti()==RS2::UndoableDelta) {
+		deltas.emplace_back(u);
+	}
 }
 
 /**
@@ -15,6 +19,31 @@ void RS_UndoCycle::removeUndoable(RS_Undoable* u) {
 	undoables.erase(u);
 }
 
+size_t RS_UndoCycle::memoryUsage() const {
+	// rough size of an atomic entity
+	const size_t entitySize = 256;
+	// node of the set
+	const size_t nodeSize = 48;
+
+	size_t ret = sizeof(*this) + undoables.size() * nodeSize;
+	for (auto u: undoables) {
+		switch (u->undoRtti()) {
+		case RS2::UndoableEntity:
+			if (u->isUndone()) {
+				RS_Entity* e = static_cast<RS_Entity*>(u);
+				ret += entitySize * std::max(1u, e->countDeep());
+			}
+			break;
+		case RS2::UndoableDelta:
+			ret += static_cast<LC_UndoDelta*>(u)->memoryUsage();
+			break;
+		default:
+			break;
+		}
+	}
+	return ret;
+}
+
 std::ostream& operator << (std::ostream& os,
 								  RS_UndoCycle& uc) {
 	os << " Undo item: " << "\n";
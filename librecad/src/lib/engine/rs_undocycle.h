@@ -29,7 +29,9 @@
 #define RS_UNDOLISTITEM_H
 
 #include <iostream>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include "rs_entity.h"
 #include "rs_undoable.h"
@@ -56,7 +58,7 @@ public:
 
     /**
      * Adds an Undoable to this Undo Cycle. Every Cycle can contain one or
-     * more Undoables.
+     * more Undoables. The cycle takes the ownership of deltas.
      */
 	void addUndoable(RS_Undoable* u);
 
@@ -65,6 +67,12 @@ public:
      */
 	void removeUndoable(RS_Undoable* u);
 
+	/**
+	 * @return estimated memory in bytes kept by this cycle: deltas,
+	 * entities which are undone and the list itself
+	 */
+	size_t memoryUsage() const;
+
     friend std::ostream& operator << (std::ostream& os,
 									  RS_UndoCycle& uc);
 
@@ -75,6 +83,10 @@ private:
     //RS2::UndoType type;
     //! List of entity id's that were affected by this action
 	std::set<RS_Undoable*> undoables;
+	//! deltas of this cycle, owned by the cycle
+	std::vector<std::unique_ptr<RS_Undoable>> deltas;
+	//! memoryUsage() when the cycle was ended
+	size_t memory=0;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include "rs_filterjww.h"
 #include "rs_filterlff.h"
 #include "rs_filterdxfrw.h"
+#include "lc_trace.h"
 
 /**
  * Calls the import method of the filter responsible for the format
@@ -50,7 +51,7 @@
 bool RS_FileIO::fileImport(RS_Graphic& graphic, const QString& file,
         RS2::FormatType type) {
 
-    RS_DEBUG->print("Trying to import file '%s'...", file.toLatin1().data());
+    LC_TRACE_SCOPE_ARG("load", "RS_FileIO::fileImport", file.toStdString());
 
     RS2::FormatType t;
     if (type == RS2::FormatUnknown) {
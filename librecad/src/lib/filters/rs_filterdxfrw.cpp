@@ -131,6 +131,7 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
         RS_DEBUG->print("RS_FilterDXFRW::fileImport: reading DWG file");
         if (RS_DEBUG->getLevel()== RS_Debug::D_DEBUGGING)
             dwgr.setDebug(DRW::DEBUG);
+        dwgr.setThreads(0);
         bool success = dwgr.read(this, true);
         RS_DEBUG->print("RS_FilterDXFRW::fileImport: reading DWG file: OK");
         RS_DIALOGFACTORY->commandMessage(QObject::tr("Opened dwg file version %1.").arg(printDwgVersion(dwgr.getVersion())));
@@ -2118,6 +2119,17 @@ void RS_FilterDXFRW::writeLWPolyline(RS_Polyline* l) {
         return;
     }
     DRW_LWPolyline pol;
+    if (l->isPacked()) {
+        // write the vertex array without creating the segments
+        for (RS_PolylineVertex const& v: l->getPackedVertices())
+            pol.addVertex(DRW_Vertex2D(v.x, v.y, v.bulge));
+        if (l->isClosed())
+            pol.flags = 1;
+        pol.vertexnum = pol.vertlist.size();
+        getEntityAttributes(&pol, l);
+        dxfW->writeLWPolyline(&pol);
+        return;
+    }
     RS_Entity* currEntity = 0;
     RS_Entity* nextEntity = 0;
     RS_AtomicEntity* ae = NULL;
@@ -54,6 +54,7 @@
 #include "lc_splinepoints.h"
 #include "rs_system.h"
 #include "rs_math.h"
+#include "lc_trace.h"
 
 
 /**
@@ -72,6 +73,7 @@ RS_FilterJWW::RS_FilterJWW()
         hatchLoop = NULL;
         currentContainer = NULL;
         graphic = NULL;
+        cachedLayer = NULL;
 		spline = NULL;
 		splinePoints = NULL;
         //exportVersion = DL_Codes::VER_2002;
@@ -106,14 +108,18 @@ bool RS_FilterJWW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatTyp
         graphic = &g;
         currentContainer = graphic;
         this->file = file;
+        cachedLayerName.clear();
+        cachedLayer = NULL;
 
         RS_DEBUG->print("graphic->countLayers(): %d", graphic->countLayers());
 
-        //graphic->setAutoUpdateBorders(false);
+        // the borders are calculated once after all entities are added:
+        graphic->setAutoUpdateBorders(false);
         RS_DEBUG->print("RS_FilterJWW::fileImport: reading file");
         bool success = jww.in((const char*)QFile::encodeName(file), this);
         RS_DEBUG->print("RS_FilterJWW::fileImport: reading file: OK");
-        //graphic->setAutoUpdateBorders(true);
+        graphic->setAutoUpdateBorders(true);
+        graphic->calculateBorders();
 
         if (success==false) {
                 RS_DEBUG->print(RS_Debug::D_WARNING,
@@ -244,6 +250,7 @@ void RS_FilterJWW::endBlock() {
  * Implementation of the method which handles point entities.
  */
 void RS_FilterJWW::addPoint(const DL_PointData& data) {
+        LC_TRACE_SCOPE("load", "RS_FilterJWW::addPoint");
         RS_Vector v(data.x, data.y);
 
         RS_Point* entity = new RS_Point(currentContainer,
@@ -259,27 +266,20 @@ void RS_FilterJWW::addPoint(const DL_PointData& data) {
  * Implementation of the method which handles line entities.
  */
 void RS_FilterJWW::addLine(const DL_LineData& data) {
-        RS_DEBUG->print("RS_FilterJWW::addLine");
+        LC_TRACE_SCOPE("load", "RS_FilterJWW::addLine");
 
         RS_Vector v1(data.x1, data.y1);
         RS_Vector v2(data.x2, data.y2);
 
-        RS_DEBUG->print("RS_FilterJWW::addLine: create line");
-
         if (currentContainer==NULL) {
                 RS_DEBUG->print("RS_FilterJWW::addLine: currentContainer is NULL");
         }
 
         RS_Line* entity = new RS_Line(currentContainer,
                                                                   RS_LineData(v1, v2));
-        RS_DEBUG->print("RS_FilterJWW::addLine: set attributes");
         setEntityAttributes(entity, attributes);
 
-        RS_DEBUG->print("RS_FilterJWW::addLine: add entity");
-
         currentContainer->addEntity(entity);
-
-        RS_DEBUG->print("RS_FilterJWW::addLine: OK");
 }
 
 
@@ -291,7 +291,7 @@ void RS_FilterJWW::addLine(const DL_LineData& data) {
  * @param angle2 End angle in deg (!)
  */
 void RS_FilterJWW::addArc(const DL_ArcData& data) {
-        RS_DEBUG->print("RS_FilterJWW::addArc");
+        LC_TRACE_SCOPE("load", "RS_FilterJWW::addArc");
         //printf("LINE	 (%12.6f, %12.6f, %12.6f) (%12.6f, %12.6f, %12.6f)\n",
         //	   p1[0], p1[1], p1[2],
         //	   p2[0], p2[1], p2[2]);
@@ -315,7 +315,7 @@ void RS_FilterJWW::addArc(const DL_ArcData& data) {
  * @param angle2 End angle in rad (!)
  */
 void RS_FilterJWW::addEllipse(const DL_EllipseData& data) {
-        RS_DEBUG->print("RS_FilterJWW::addEllipse");
+        LC_TRACE_SCOPE("load", "RS_FilterJWW::addEllipse");
 
         RS_Vector v1(data.cx, data.cy);
         RS_Vector v2(data.mx, data.my);
@@ -337,7 +337,7 @@ void RS_FilterJWW::addEllipse(const DL_EllipseData& data) {
  * Implementation of the method which handles circle entities.
  */
 void RS_FilterJWW::addCircle(const DL_CircleData& data) {
-        RS_DEBUG->print("RS_FilterJWW::addCircle");
+        LC_TRACE_SCOPE("load", "RS_FilterJWW::addCircle");
         //printf("LINE	 (%12.6f, %12.6f, %12.6f) (%12.6f, %12.6f, %12.6f)\n",
         //	   p1[0], p1[1], p1[2],
         //	   p2[0], p2[1], p2[2]);
@@ -585,7 +585,7 @@ void RS_FilterJWW::addMText(const DL_MTextData& data) {
  * texts (TEXT).
  */
 void RS_FilterJWW::addText(const DL_TextData& data) {
-        RS_DEBUG->print("RS_FilterJWW::addText");
+        LC_TRACE_SCOPE("load", "RS_FilterJWW::addText");
         int attachmentPoint;
         RS_Vector refPoint;
         double angle = data.angle;
@@ -2492,8 +2492,6 @@ void RS_FilterJWW::writeImageDef(DL_WriterA& dw, RS_Image* i) {
  */
 void RS_FilterJWW::setEntityAttributes(RS_Entity* entity,
                                                                            const DL_Attributes& attrib) {
-        RS_DEBUG->print("RS_FilterJWW::setEntityAttributes");
-
         RS_Pen pen;
         pen.setColor(Qt::black);
         pen.setLineType(RS2::SolidLine);
@@ -2503,18 +2501,24 @@ void RS_FilterJWW::setEntityAttributes(RS_Entity* entity,
                 entity->setLayer("0");
         } else {
 //-------------------------
-                //2007-02-24 added
-                QString enc = RS_System::getEncoding(
-                                                        variables.getString("$DWGCODEPAGE", "ANSI_1252"));
-                // get the codec for Japanese
-                QString lName = attrib.getLayer().c_str();
-                QTextCodec *codec = QTextCodec::codecForName(enc.toLatin1());
-                if(codec)
-                        lName = codec->toUnicode(attrib.getLayer().c_str());
-                if (graphic->findLayer(lName)==NULL) {
-                        addLayer(DL_LayerData(attrib.getLayer(), 0));
+                // consecutive entities are mostly on the same layer, the
+                // codec lookup and conversion is done on a change only
+                if (attrib.getLayer() != cachedLayerName || cachedLayer==NULL) {
+                        //2007-02-24 added
+                        QString enc = RS_System::getEncoding(
+                                                                variables.getString("$DWGCODEPAGE", "ANSI_1252"));
+                        // get the codec for Japanese
+                        QString lName = attrib.getLayer().c_str();
+                        QTextCodec *codec = QTextCodec::codecForName(enc.toLatin1());
+                        if(codec)
+                                lName = codec->toUnicode(attrib.getLayer().c_str());
+                        if (graphic->findLayer(lName)==NULL) {
+                                addLayer(DL_LayerData(attrib.getLayer(), 0));
+                        }
+                        cachedLayerName = attrib.getLayer();
+                        cachedLayer = graphic->findLayer(lName);
                 }
-                entity->setLayer(lName);
+                entity->setLayer(cachedLayer);
 //-------------------------
                 // add layer in case it doesn't exist:
 /*		if (graphic->findLayer(attrib.getLayer().c_str())==NULL) {
@@ -2534,7 +2538,6 @@ void RS_FilterJWW::setEntityAttributes(RS_Entity* entity,
         pen.setWidth(numberToWidth(attrib.getWidth()));
 
         entity->setPen(pen);
-        RS_DEBUG->print("RS_FilterJWW::setEntityAttributes: OK");
 }
 
 
@@ -234,6 +234,10 @@ private:
     /** Pointer to current hatch loop or NULL. */
     RS_EntityContainer* hatchLoop;
 
+    /** Layer of the last entity, as named in the file and in the graphic. */
+    std::string cachedLayerName;
+    RS_Layer* cachedLayer;
+
     DL_Jww jww;
     RS_VariableDict variables;
 }
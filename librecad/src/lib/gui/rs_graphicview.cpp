@@ -43,6 +43,9 @@
 #include "rs_settings.h"
 #include "rs_dialogfactory.h"
 #include "rs_layer.h"
+#include "rs_insert.h"
+#include "rs_block.h"
+#include "lc_trace.h"
 
 #ifdef EMU_C99
 #include "emu_c99.h"
@@ -510,7 +513,7 @@ void RS_GraphicView::zoomIn(double f, const RS_Vector& center) {
 	//adjustOffsetControls();
 	//adjustZoomControls();
 	// updateGrid();
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -524,7 +527,7 @@ void RS_GraphicView::zoomInX(double f) {
 	adjustOffsetControls();
 	adjustZoomControls();
 	// updateGrid();
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -538,7 +541,7 @@ void RS_GraphicView::zoomInY(double f) {
 	adjustOffsetControls();
 	adjustZoomControls();
 	//    updateGrid();
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -571,7 +574,7 @@ void RS_GraphicView::zoomOutX(double f) {
 	adjustOffsetControls();
 	adjustZoomControls();
 	//    updateGrid();
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -590,7 +593,7 @@ void RS_GraphicView::zoomOutY(double f) {
 	adjustOffsetControls();
 	adjustZoomControls();
 	//    updateGrid();
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 /**
@@ -748,7 +751,7 @@ void RS_GraphicView::restoreView() {
 	adjustZoomControls();
 	//    updateGrid();
 
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -901,7 +904,7 @@ void RS_GraphicView::zoomWindow(RS_Vector v1, RS_Vector v2,
 	adjustZoomControls();
 	//    updateGrid();
 
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -920,7 +923,7 @@ void RS_GraphicView::zoomPan(int dx, int dy) {
 	//adjustZoomControls();
 	//    updateGrid();
 
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -947,7 +950,7 @@ void RS_GraphicView::zoomScroll(RS2::Direction direction) {
 	adjustZoomControls();
 	//    updateGrid();
 
-	redraw();
+	redraw(RS2::RedrawView);
 }
 
 
@@ -1078,7 +1081,11 @@ void RS_GraphicView::drawLayer1(RS_Painter *painter) {
 
 void RS_GraphicView::drawLayer2(RS_Painter *painter)
 {
-	drawEntity(painter, container);	//	Draw all entities.
+	LC_TRACE_SCOPE("render", "RS_GraphicView::drawLayer2");
+	//	Draw all entities, lines and polylines grouped by pen.
+	painter->beginBatch();
+	drawEntity(painter, container);
+	painter->endBatch();
 
 	//	If not in print preview, draw the absolute zero reference.
 	//	----------------------------------------------------------
@@ -1096,6 +1103,26 @@ void RS_GraphicView::drawLayer3(RS_Painter *painter) {
 }
 
 
+void RS_GraphicView::copyDrawingState(const RS_GraphicView& view) {
+	container = view.container;
+	background = view.background;
+	foreground = view.foreground;
+	selectedColor = view.selectedColor;
+	highlightedColor = view.highlightedColor;
+	startHandleColor = view.startHandleColor;
+	handleColor = view.handleColor;
+	endHandleColor = view.endHandleColor;
+	drawingMode = view.drawingMode;
+	deleteMode = view.deleteMode;
+	draftMode = view.draftMode;
+	factor = view.factor;
+	offsetX = view.offsetX;
+	offsetY = view.offsetY;
+	printPreview = view.printPreview;
+	printing = view.printing;
+}
+
+
 /*	*
  *	Function name:
  *
@@ -1123,7 +1150,7 @@ void RS_GraphicView::setPenForEntity(RS_Painter *painter,RS_Entity *e)
 	}
 
 	// Getting pen from entity (or layer)
-	RS_Pen pen = e->getPen(true);
+	RS_Pen pen = instances.empty() ? e->getPen(true) : getInstancePen(e);
 
 	int w = pen.getWidth();
 	if (w<0) {
@@ -1194,7 +1221,7 @@ void RS_GraphicView::setPenForEntity(RS_Painter *painter,RS_Entity *e)
 	}
 
 	// this entity is selected:
-	if (e->isSelected()) {
+	if (isDrawnSelected(e)) {
 		pen.setLineType(RS2::DotLine);
 		pen.setColor(selectedColor);
 	}
@@ -1222,23 +1249,17 @@ void RS_GraphicView::setPenForEntity(RS_Painter *painter,RS_Entity *e)
  *        lines e.g. in splines).
  * @param db Double buffering on (recommended) / off
  */
-void RS_GraphicView::drawEntity(RS_Entity* /*e*/, double& /*patternOffset*/) {
-	RS_DEBUG->print("RS_GraphicView::drawEntity(RS_Entity*,patternOffset) not supported anymore");
-	// RVT_PORT this needs to be optimized
-	// ONe way to do is to send a RS2::RedrawSelected, then teh draw routine will onyl draw all selected entities
-	// Dis-advantage is that we still need to iterate over all entities, but
-	// this might be very fast
-	// For now we just redraw the drawing untill we are going to optmize drawing
-	redraw(RS2::RedrawDrawing);
-}
-void RS_GraphicView::drawEntity(RS_Entity* /*e*/ /*patternOffset*/) {
-	RS_DEBUG->print("RS_GraphicView::drawEntity(RS_Entity*,patternOffset) not supported anymore");
-	// RVT_PORT this needs to be optimized
-	// ONe way to do is to send a RS2::RedrawSelected, then teh draw routine will onyl draw all selected entities
-	// Dis-advantage is that we still need to iterate over all entities, but
-	// this might be very fast
-	// For now we just redraw the drawing untill we are going to optmize drawing
-	redraw(RS2::RedrawDrawing);
+void RS_GraphicView::drawEntity(RS_Entity* e, double& /*patternOffset*/) {
+	drawEntity(e);
+}
+void RS_GraphicView::drawEntity(RS_Entity* e) {
+	// only the part of the drawing covered by the entity is drawn again
+	if (e==nullptr) {
+		redraw(RS2::RedrawDrawing);
+		return;
+	}
+	invalidateEntity(e);
+	redraw(RS2::RedrawDrawingCached);
 }
 void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e) {
 	double offset(0.);
@@ -1248,12 +1269,12 @@ void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e, double& patte
 
 	// update is diabled:
     // given entity is nullptr:
-    if (e==nullptr) {
+    if (e==nullptr || isDrawingCancelled()) {
 		return;
 	}
 
 	// entity is not visible:
-	if (!e->isVisible()) {
+	if (instances.empty() ? !e->isVisible() : !isInstanceVisible(e)) {
 		return;
 	}
 	if( isPrintPreview() || isPrinting() ) {
@@ -1263,18 +1284,22 @@ void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e, double& patte
 			return;
 	}
 
-	// test if the entity is in the viewport
-	/* temporary disabled so rs_overlaylien can be drawn
-	if (!e->isContainer() && !isPrinting() &&
-            (painter==nullptr || !painter->isPreviewMode()) &&
-			(toGuiX(e->getMax().x)<0 || toGuiX(e->getMin().x)>getWidth() ||
-			 toGuiY(e->getMin().y)<0 || toGuiY(e->getMax().y)>getHeight())) {
+	// test if the entity is in the viewport, sub-entities of containers
+	// are tested again when the container draws them
+	if (!isPrinting() && !e->isDocument() && e->isCullable()
+			&& !e->isVisibleInWindow(this)) {
 		return;
-	} */
+	}
 
 	// set pen (color):
 	setPenForEntity(painter, e );
 
+	// level of detail, tiny entities are not drawn in full:
+	if (!isPrinting() && !e->isDocument() && e->isCullable()
+			&& drawEntitySimplified(painter, e)) {
+		return;
+	}
+
 	//RS_DEBUG->print("draw plain");
 	if (isDraftMode()) {
         switch(e->rtti()){
@@ -1331,6 +1356,173 @@ void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e, double& patte
 }
 
 
+/**
+ * Level of detail: entities of a pixel or two are drawn as a point,
+ * small inserts and texts as their borders. Containers smaller than a
+ * pixel are skipped.
+ *
+ * @return true if the entity was drawn (or skipped) here, false if it
+ * has to be drawn in full.
+ */
+bool RS_GraphicView::drawEntitySimplified(RS_Painter *painter, RS_Entity* e) {
+	const double pointSize = 2.;
+	const double boxSize = 4.;
+
+	RS_Vector const& vMin = e->getMin();
+	RS_Vector const& vMax = e->getMax();
+	double const size = std::max(toGuiDX(vMax.x - vMin.x),
+								 toGuiDY(vMax.y - vMin.y));
+	if (e->isContainer() && size < 1.) {
+		return true;
+	}
+	switch (e->rtti()) {
+	case RS2::EntityInsert:
+	case RS2::EntityMText:
+	case RS2::EntityText:
+		if (size >= boxSize) {
+			return false;
+		}
+		break;
+	case RS2::EntityPoint:
+		// points have a size of their own
+		return false;
+	default:
+		if (size >= pointSize) {
+			return false;
+		}
+	}
+
+	if (isDrawnSelected(e)==painter->shouldDrawSelected()) {
+		if (size < pointSize) {
+			painter->drawGridPoint(toGui((vMin + vMax)*0.5));
+		} else {
+			painter->drawRect(toGui(vMin), toGui(vMax));
+		}
+	}
+	return true;
+}
+
+
+/**
+ * @return true if the box vMin, vMax intersects the viewport.
+ * A margin of a few pixels keeps wide pens and handles at the
+ * viewport edges.
+ */
+bool RS_GraphicView::isInViewport(const RS_Vector& vMin, const RS_Vector& vMax) const {
+	const double margin = 8.;
+	return toGuiX(vMax.x) >= -margin
+			&& toGuiX(vMin.x) <= getWidth() + margin
+			&& toGuiY(vMin.y) >= -margin
+			&& toGuiY(vMax.y) <= getHeight() + margin;
+}
+
+
+void RS_GraphicView::pushInstance(RS_Insert const* insert, const RS_Vector& origin, double scale) {
+	Instance inst;
+	inst.factor = factor;
+	inst.offset = instanceOffset;
+	if (instances.empty()) {
+		inst.pen = insert->getPen(true);
+		inst.layer = insert->getLayer(true);
+		inst.selected = insert->isSelected();
+	} else {
+		// nested insert, resolve against the insert drawing its block
+		inst.pen = getInstancePen(insert);
+		inst.layer = getInstanceLayer(insert);
+		inst.selected = instances.back().selected || insert->isSelected();
+	}
+	instances.push_back(inst);
+
+	instanceOffset += RS_Vector(origin.x*factor.x, origin.y*factor.y);
+	factor *= scale;
+}
+
+void RS_GraphicView::popInstance() {
+	if (instances.empty()) return;
+	factor = instances.back().factor;
+	instanceOffset = instances.back().offset;
+	instances.pop_back();
+}
+
+bool RS_GraphicView::isDrawnSelected(RS_Entity const* e) const {
+	return e->isSelected() || (!instances.empty() && instances.back().selected);
+}
+
+/**
+ * @return pen of a block entity, as RS_Insert::update() assigns it to
+ * the entity copies of a regular insert
+ */
+RS_Pen RS_GraphicView::getInstancePen(RS_Entity const* e) const {
+	Instance const& inst = instances.back();
+	RS_Pen pen = e->getPen(false);
+	if (!pen.isValid()) {
+		// letters of a text use the pen of the text:
+		RS_Entity const* parent = e->getParent();
+		if (parent && parent->rtti()!=RS2::EntityBlock) {
+			return getInstancePen(parent);
+		}
+		return inst.pen;
+	}
+	if (pen.getColor().isByBlock()) {
+		pen.setColor(inst.pen.getColor());
+	}
+	if (pen.getWidth()==RS2::WidthByBlock) {
+		pen.setWidth(inst.pen.getWidth());
+	}
+	if (pen.getLineType()==RS2::LineByBlock) {
+		pen.setLineType(inst.pen.getLineType());
+	}
+
+	RS_Layer* layer = getInstanceLayer(e);
+	if (layer) {
+		if (pen.getColor().isByLayer()) {
+			pen.setColor(layer->getPen().getColor());
+		}
+		if (pen.getWidth()==RS2::WidthByLayer) {
+			pen.setWidth(layer->getPen().getWidth());
+		}
+		if (pen.getLineType()==RS2::LineByLayer) {
+			pen.setLineType(layer->getPen().getLineType());
+		}
+	}
+	return pen;
+}
+
+/**
+ * @return true if a block entity drawn by an instanced insert is visible.
+ * Entities on layer "0" are hidden with the layer of the insert, as the
+ * entity copies of a regular insert are.
+ */
+bool RS_GraphicView::isInstanceVisible(RS_Entity const* e) const {
+	if (!e->getFlag(RS2::FlagVisible) || e->isUndone()) {
+		return false;
+	}
+	if (e->rtti()==RS2::EntityInsert) {
+		RS_Block* blk = static_cast<RS_Insert const*>(e)->getBlockForInsert();
+		if (blk && blk->isFrozen()) {
+			return false;
+		}
+	}
+	RS_Layer* layer = getInstanceLayer(e);
+	return layer==nullptr || !layer->isFrozen();
+}
+
+/**
+ * @return Layer of a block entity drawn by an instanced insert. Entities
+ * without a layer are on the layer of their parent (e.g. letters of a
+ * text), entities on layer "0" on the layer of the insert.
+ */
+RS_Layer* RS_GraphicView::getInstanceLayer(RS_Entity const* e) const {
+	for (; e && e->rtti()!=RS2::EntityBlock; e = e->getParent()) {
+		RS_Layer* layer = e->getLayer(false);
+		if (layer) {
+			return layer->getName()=="0" ? instances.back().layer : layer;
+		}
+	}
+	return instances.back().layer;
+}
+
+
 /**
  * Draws an entity.
  * The painter must be initialized and all the attributes (pen) must be set.
@@ -1340,7 +1532,7 @@ void RS_GraphicView::drawEntityPlain(RS_Painter *painter, RS_Entity* e, double&
 		return;
 	}
 
-	if (!e->isContainer() && (e->isSelected()!=painter->shouldDrawSelected())) {
+	if (!e->isContainer() && (isDrawnSelected(e)!=painter->shouldDrawSelected())) {
 		return;
 	}
 
@@ -1352,7 +1544,7 @@ void RS_GraphicView::drawEntityPlain(RS_Painter *painter, RS_Entity* e) {
 		return;
 	}
 
-	if (!e->isContainer() && (e->isSelected()!=painter->shouldDrawSelected())) {
+	if (!e->isContainer() && (isDrawnSelected(e)!=painter->shouldDrawSelected())) {
 		return;
 	}
 	double patternOffset(0.);
@@ -1364,13 +1556,7 @@ void RS_GraphicView::drawEntityPlain(RS_Painter *painter, RS_Entity* e) {
  * Might be recusively called e.g. for polylines.
  */
 void RS_GraphicView::deleteEntity(RS_Entity* e) {
-
-	// RVT_PORT When we delete a single entoty, we can do this but we need to remove this then also from containerEntities
-	RS_DEBUG->print("RS_GraphicView::deleteEntity will for now redraw the whole screen instead of just deleting the entity");
-	setDeleteMode(true);
 	drawEntity(e);
-	setDeleteMode(false);
-	redraw(RS2::RedrawDrawing);
 }
 
 
@@ -1762,7 +1948,7 @@ RS_Vector RS_GraphicView::toGui(RS_Vector v) const{
  * after the call if the coordinate is within the visible range.
  */
 double RS_GraphicView::toGuiX(double x) const{
-	return x*factor.x + offsetX;
+	return x*factor.x + offsetX + instanceOffset.x;
 }
 
 
@@ -1771,7 +1957,7 @@ double RS_GraphicView::toGuiX(double x) const{
  * Translates a real coordinate in Y to a screen coordinate Y.
  */
 double RS_GraphicView::toGuiY(double y) const{
-	return -y*factor.y + getHeight() - offsetY;
+	return -y*factor.y + getHeight() - offsetY - instanceOffset.y;
 }
 
 
@@ -1816,7 +2002,7 @@ RS_Vector RS_GraphicView::toGraph(int x, int y) const{
  * Translates a screen coordinate in X to a real coordinate X.
  */
 double RS_GraphicView::toGraphX(int x) const{
-	return (x - offsetX)/factor.x;
+	return (x - offsetX - instanceOffset.x)/factor.x;
 }
 
 
@@ -1825,7 +2011,7 @@ double RS_GraphicView::toGraphX(int x) const{
  * Translates a screen coordinate in Y to a real coordinate Y.
  */
 double RS_GraphicView::toGraphY(int y) const{
-	return -(y - getHeight() + offsetY)/factor.y;
+	return -(y - getHeight() + offsetY + instanceOffset.y)/factor.y;
 }
 
 
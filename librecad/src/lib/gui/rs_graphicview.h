@@ -33,6 +33,7 @@
 
 #include <QDateTime>
 #include <QMap>
+#include <atomic>
 #include <tuple>
 #include <memory>
 #include <QAction>
@@ -44,6 +45,7 @@ class RS_ActionInterface;
 class RS_EventHandler;
 class RS_Grid;
 class RS_CommandEvent;
+class RS_Insert;
 struct RS_LineTypePattern;
 
 
@@ -109,6 +111,11 @@ public:
 	/** This virtual method must be overwritten to redraw
 	  the widget. */
 	virtual void redraw(RS2::RedrawMethod method=RS2::RedrawAll) = 0;
+	/**
+	 * Marks the part of a cached drawing covered by the entity as out of
+	 * date. Views without a cache ignore this.
+	 */
+	virtual void invalidateEntity(RS_Entity const* /*e*/) {}
 	/** This virtual method must be overwritten and is then
 	  called whenever the view changed */
     virtual void adjustOffsetControls() = 0;
@@ -278,6 +285,11 @@ public:
 	virtual void drawLayer1(RS_Painter *painter);
 	virtual void drawLayer2(RS_Painter *painter);
 	virtual void drawLayer3(RS_Painter *painter);
+	/**
+	 * Takes the container, transform, colors and modes of view, so this
+	 * view draws the same picture, e.g. a part of it on a render thread.
+	 */
+	void copyDrawingState(const RS_GraphicView& view);
 	virtual void deleteEntity(RS_Entity* e);
 	virtual void drawEntity(RS_Painter *painter, RS_Entity* e, double& patternOffset);
 	virtual void drawEntity(RS_Painter *painter, RS_Entity* e);
@@ -285,6 +297,28 @@ public:
 	virtual void drawEntity(RS_Entity* e);
 	virtual void drawEntityPlain(RS_Painter *painter, RS_Entity* e);
 	virtual void drawEntityPlain(RS_Painter *painter, RS_Entity* e, double& patternOffset);
+	bool drawEntitySimplified(RS_Painter *painter, RS_Entity* e);
+	bool isInViewport(const RS_Vector& vMin, const RS_Vector& vMax) const;
+	/**
+	 * Block entities of an instanced insert are drawn in block coordinates.
+	 * pushInstance() maps them to the drawing by p*scale + origin until the
+	 * matching popInstance(). The insert also provides the pen for ByBlock
+	 * attributes, the layer for entities on layer "0" and the selection.
+	 */
+	void pushInstance(RS_Insert const* insert, const RS_Vector& origin, double scale);
+	void popInstance();
+	/** @return true, if the entity is drawn as selected */
+	bool isDrawnSelected(RS_Entity const* e) const;
+	/**
+	 * Entities are not drawn any more once the flag is set, so a render
+	 * thread drawing through this view can be stopped early.
+	 */
+	void setCancelFlag(const std::atomic_bool* flag) {
+		cancelFlag = flag;
+	}
+	bool isDrawingCancelled() const {
+		return cancelFlag && cancelFlag->load(std::memory_order_relaxed);
+	}
 	virtual void setPenForEntity(RS_Painter *painter, RS_Entity* e );
     virtual RS_Vector getMousePosition() const = 0;
 
@@ -438,6 +472,22 @@ private:
 	int offsetX=0;
 	int offsetY=0;
 
+	//! transform of an instanced insert to restore on popInstance()
+	struct Instance {
+		RS_Vector factor;
+		RS_Vector offset;
+		RS_Pen pen;
+		RS_Layer* layer;
+		bool selected;
+	};
+	std::vector<Instance> instances;
+	//! offset in pixels of the block being drawn by an instanced insert
+	RS_Vector instanceOffset=RS_Vector(0.,0.);
+	const std::atomic_bool* cancelFlag = nullptr;
+	RS_Pen getInstancePen(RS_Entity const* e) const;
+	RS_Layer* getInstanceLayer(RS_Entity const* e) const;
+	bool isInstanceVisible(RS_Entity const* e) const;
+
 	//circular buffer for saved views
 	std::vector<std::tuple<int, int, RS_Vector> > savedViews;
 	unsigned short savedViewIndex=0;
@@ -24,10 +24,21 @@
 **
 **********************************************************************/
 
+#include <algorithm>
 #include<QPolygon>
 #include "rs_painter.h"
 
 
+double RS_Painter::getArcStep(double radius) const {
+    // maximum distance in pixels of chords to the arc:
+    const double tolerance = drawingMode==RS2::ModePreview ? 2. : 0.25;
+    if (radius <= 2. * tolerance) {
+        return M_PI/4.;
+    }
+    return std::min(M_PI/4., 2.*acos(1. - tolerance/radius));
+}
+
+
 void RS_Painter::createArc(QPolygon& pa,
                              const RS_Vector& cp, double radius,
                              double a1, double a2,
@@ -39,8 +50,7 @@ void RS_Painter::createArc(QPolygon& pa,
         return;
     }
 
-    double aStep=fabs(2.0/radius);         // Angle Step (rad)
-    if(aStep>=0.5) aStep=0.5;
+    double aStep=getArcStep(radius);         // Angle Step (rad)
     if(reversed) {
         if(a1<=a2+RS_TOLERANCE) a1+=2.*M_PI;
         aStep *= -1;
@@ -60,7 +70,7 @@ void RS_Painter::createArc(QPolygon& pa,
     //}
 
     //QPointArray pa;
-    pa.clear();
+    pa.resize(0); // keeps the capacity of a reused polygon
     //    pa<<QPoint(toScreenX(cp.x+cos(aStart)*radius), toScreenY(cp.y-sin(aStart)*radius));
     double da=fabs(a2-a1);
     for(a=a1; fabs(a-a1)<da; a+=aStep) {
@@ -116,7 +126,9 @@ void RS_Painter::createEllipse(QPolygon& pa,
         vp=va;
         double r2=va.scale(rvp).squared();
         if( r2<RS_TOLERANCE15) r2=RS_TOLERANCE15;
-        double aStep=ab/(r2*sqrt(r2));
+        // step of the tangent angle for the local radius of curvature,
+        // the tangent turns by ab/r2 per parameter unit
+        double aStep=getArcStep(r2*sqrt(r2)/ab)*r2/ab;
         if(aStep < minDea) aStep=minDea;
         if(aStep > M_PI/4.) aStep=M_PI/4.;
         ea1 += reversed?-aStep:aStep;
@@ -77,6 +77,15 @@ public:
         return drawingMode;
     }
 
+    /**
+     * Starts batched drawing: lines and polylines may be collected and
+     * drawn grouped by pen, until endBatch(). Other primitives draw the
+     * collected ones first, so they stay on top of them.
+     */
+    virtual void beginBatch() {}
+    /** draws the collected primitives and ends batched drawing */
+    virtual void endBatch() {}
+
     virtual void moveTo(int x, int y) = 0;
     virtual void lineTo(int x, int y) = 0;
 
@@ -91,6 +100,12 @@ public:
     virtual void drawArc(const RS_Vector& cp, double radius,
                          double a1, double a2,
                          bool reversed) = 0;
+    /**
+     * @return angle step (rad) of the polygon of an arc with the given
+     * radius in pixels, so its chords stay within a fraction of a pixel
+     * of the arc (a few pixels for previews)
+     */
+    double getArcStep(double radius) const;
     void createArc(QPolygon& pa,
                    const RS_Vector& cp, double radius,
                    double a1, double a2,
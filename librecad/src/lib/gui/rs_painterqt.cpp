@@ -25,7 +25,10 @@
 **********************************************************************/
 
 
+#include <algorithm>
+#include <cmath>
 #include "rs_painterqt.h"
+#include "lc_clipping.h"
 
 /**
  * Constructor.
@@ -34,6 +37,85 @@
 RS_PainterQt::RS_PainterQt( QPaintDevice* pd)
         : QPainter(pd), RS_Painter() {}
 
+void RS_PainterQt::beginBatch() {
+    batching=true;
+}
+
+void RS_PainterQt::endBatch() {
+    flushBatch();
+    batching=false;
+}
+
+void RS_PainterQt::applyPen(const QPen& pen) {
+    qpen=pen;
+    if (!batching) {
+        QPainter::setPen(pen);
+    }
+}
+
+RS_PainterQt::Batch& RS_PainterQt::currentBatch() {
+    if (batchIndex<batchCount && batches[batchIndex].pen==qpen) {
+        return batches[batchIndex];
+    }
+    for (batchIndex=0; batchIndex<batchCount; ++batchIndex) {
+        if (batches[batchIndex].pen==qpen) {
+            return batches[batchIndex];
+        }
+    }
+    if (batchCount==maxBatches) {
+        flushBatch();
+    }
+    if (batchCount==batches.size()) {
+        batches.emplace_back();
+    }
+    batchIndex=batchCount++;
+    batches[batchIndex].pen=qpen;
+    return batches[batchIndex];
+}
+
+void RS_PainterQt::addPolyline(const QPolygon& pa) {
+    if (!batching) {
+        drawPolyline(pa);
+        return;
+    }
+    if (pa.size()<2) {
+        return;
+    }
+    Batch& batch=currentBatch();
+    batch.points += pa;
+    batch.polylineEnds << batch.points.size();
+}
+
+/**
+ * Draws the collected grid points and lines with one call per pen and the collected
+ * polylines without pen changes in between. The painter is left with
+ * the current pen, also if nothing was collected: applyPen() does not
+ * set it while batching, and primitives which are not batched rely on it.
+ */
+void RS_PainterQt::flushBatch() {
+    for (size_t i=0; i<batchCount; ++i) {
+        Batch& batch=batches[i];
+        QPainter::setPen(batch.pen);
+        if (!batch.gridPoints.isEmpty()) {
+            QPainter::drawPoints(batch.gridPoints);
+        }
+        if (!batch.lines.isEmpty()) {
+            QPainter::drawLines(batch.lines);
+        }
+        int start=0;
+        for (int end: batch.polylineEnds) {
+            QPainter::drawPolyline(batch.points.constData()+start, end-start);
+            start=end;
+        }
+        batch.gridPoints.resize(0);
+        batch.lines.resize(0);
+        batch.points.resize(0);
+        batch.polylineEnds.resize(0);
+    }
+    batchCount=0;
+    QPainter::setPen(qpen);
+}
+
 void RS_PainterQt::moveTo(int x, int y) {
         //RVT_PORT changed from QPainter::moveTo(x,y);
         rememberX=x;
@@ -43,6 +125,7 @@ void RS_PainterQt::moveTo(int x, int y) {
 
 void RS_PainterQt::lineTo(int x, int y) {
         // RVT_PORT changed from QPainter::lineTo(x, y);
+        flushBatch();
         QPainterPath path;
         path.moveTo(rememberX,rememberY);
         path.lineTo(x,y);
@@ -55,6 +138,10 @@ void RS_PainterQt::lineTo(int x, int y) {
  * Draws a grid point at (x1, y1).
  */
 void RS_PainterQt::drawGridPoint(const RS_Vector& p) {
+    if (batching) {
+        currentBatch().gridPoints << QPoint(toScreenX(p.x), toScreenY(p.y));
+        return;
+    }
     QPainter::drawPoint(toScreenX(p.x), toScreenY(p.y));
 }
 
@@ -64,6 +151,14 @@ void RS_PainterQt::drawGridPoint(const RS_Vector& p) {
  * Draws a point at (x1, y1).
  */
 void RS_PainterQt::drawPoint(const RS_Vector& p) {
+    if (batching) {
+        Batch& batch=currentBatch();
+        batch.lines << QLine(toScreenX(p.x-1), toScreenY(p.y),
+                             toScreenX(p.x+1), toScreenY(p.y))
+                    << QLine(toScreenX(p.x), toScreenY(p.y-1),
+                             toScreenX(p.x), toScreenY(p.y+1));
+        return;
+    }
     QPainter::drawLine(toScreenX(p.x-1), toScreenY(p.y),
                        toScreenX(p.x+1), toScreenY(p.y));
     QPainter::drawLine(toScreenX(p.x), toScreenY(p.y-1),
@@ -81,6 +176,11 @@ void RS_PainterQt::drawLine(const RS_Vector& p1, const RS_Vector& p2) {
     QPainter::drawLine(toScreenX(p1.x-w2), toScreenY(p1.y-w2),
                        toScreenX(p2.x-w2), toScreenY(p2.y-w2));
 #else
+    if (batching) {
+        currentBatch().lines << QLine(toScreenX(p1.x), toScreenY(p1.y),
+                                      toScreenX(p2.x), toScreenY(p2.y));
+        return;
+    }
     QPainter::drawLine(toScreenX(p1.x), toScreenY(p1.y),
                        toScreenX(p2.x), toScreenY(p2.y));
 #endif
@@ -139,71 +239,32 @@ void RS_PainterQt::drawArc(const RS_Vector& cp, double radius,
 #ifdef __APPLE1__
                 drawArcMac(cp, radius, a1, a2, reversed);
 #else
-        int   cix;            // Next point on circle
-        int   ciy;            //
-        double aStep;         // Angle Step (rad)
+        double aStep=getArcStep(radius);         // Angle Step (rad)
         double a;             // Current Angle (rad)
-        double linStep;       // linear step (pixels)
-
-        if (drawingMode==RS2::ModePreview) {
-            linStep = 20.0;
-        } else {
-            linStep = 6.0;
-        }
-
-        if (fabs(linStep/radius)<=1.0) {
-            aStep=asin(linStep/radius);
-        } else {
-            aStep=1.0;
-        }
-
-        if (aStep<0.05) {
-            aStep = 0.05;
-        }
 
         if(!reversed) {
             // Arc Counterclockwise:
             if(a1>a2-1.0e-10) {
                 a2+=2*M_PI;
             }
-            //moveTo(toScreenX(p1.x), toScreenY(p1.y));
-            QPolygon pa;
-            int i=0;
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p1.x), toScreenY(p1.y));
-            for(a=a1+aStep; a<=a2; a+=aStep) {
-                cix = toScreenX(cp.x+cos(a)*radius);
-                ciy = toScreenY(cp.y-sin(a)*radius);
-                //lineTo(cix, ciy);
-                pa.resize(i+1);
-                pa.setPoint(i++, cix, ciy);
-            }
-            //lineTo(toScreenX(p2.x), toScreenY(p2.y));
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p2.x), toScreenY(p2.y));
-            drawPolyline(pa);
         } else {
             // Arc Clockwise:
             if(a1<a2+1.0e-10) {
                 a2-=2*M_PI;
             }
-            QPolygon pa;
-            int i=0;
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p1.x), toScreenY(p1.y));
-            //moveTo(toScreenX(p1.x), toScreenY(p1.y));
-            for(a=a1-aStep; a>=a2; a-=aStep) {
-                cix = toScreenX(cp.x+cos(a)*radius);
-                ciy = toScreenY(cp.y-sin(a)*radius);
-                //lineTo(cix, ciy);
-                pa.resize(i+1);
-                pa.setPoint(i++, cix, ciy);
-            }
-            //lineTo(toScreenX(p2.x), toScreenY(p2.y));
-            pa.resize(i+1);
-            pa.setPoint(i++, toScreenX(p2.x), toScreenY(p2.y));
-            drawPolyline(pa);
+            aStep=-aStep;
+        }
+        // inner points at a1+aStep, a1+2*aStep, ... up to a2
+        int n=std::max(0, static_cast<int>(floor((a2-a1)/aStep)));
+        arcPoints.resize(n+2);
+        arcPoints.setPoint(0, toScreenX(p1.x), toScreenY(p1.y));
+        for(int i=1; i<=n; ++i) {
+            a=a1+i*aStep;
+            arcPoints.setPoint(i, toScreenX(cp.x+cos(a)*radius),
+                               toScreenY(cp.y-sin(a)*radius));
         }
+        arcPoints.setPoint(n+1, toScreenX(p2.x), toScreenY(p2.y));
+        addPolyline(arcPoints);
 #endif
     }
 }
@@ -229,9 +290,23 @@ void RS_PainterQt::drawArc(const RS_Vector& cp, double radius,
 #ifdef __APPL1E__
                 drawArcMac(cp, radius, a1, a2, reversed);
 #else
-        QPolygon pa;
-        createArc(pa, cp, radius, a1, a2, reversed);
-        drawPolyline(pa);
+        // only the parts of the arc inside the device, widened by the pen
+        double base=reversed?a2:a1;
+        double length=reversed?a1-a2:a2-a1;
+        if(length<=RS_TOLERANCE) length+=2.*M_PI;
+        double margin=2.+qpen.widthF();
+        double pieces[2*LC_Clipping::maxArcPieces];
+        // screen coordinates with y upwards, to keep the angles
+        int n=LC_Clipping::clipArc(RS_Vector(cp.x, -cp.y), radius,
+                                   base, length,
+                                   RS_Vector(-margin, -getHeight()-margin),
+                                   RS_Vector(getWidth()+margin, margin),
+                                   pieces);
+        for(int i=0; i<n; ++i) {
+            createArc(arcPoints, cp, radius,
+                      base+pieces[2*i], base+pieces[2*i+1], false);
+            addPolyline(arcPoints);
+        }
 #endif
     }
 }
@@ -340,6 +415,7 @@ void RS_PainterQt::drawCircle(const RS_Vector& cp, double radius) {
 // RVT_PORT    if (drawingMode==RS2::ModeXOR && radius<500) {
                 if (radius<500) {
         // This is _very_ slow for large arcs:
+        flushBatch();
         QPainter::drawEllipse(toScreenX(cp.x-radius),
                               toScreenY(cp.y-radius),
                               RS_Math::round(2.0*radius),
@@ -351,11 +427,10 @@ void RS_PainterQt::drawCircle(const RS_Vector& cp, double radius) {
                 0.0, 2*M_PI,
                 false);
 #else
+        // clipped to the device
         drawArc(cp,
                 radius,
                 0.0, 2*M_PI,
-                cp + RS_Vector(radius, 0.0),
-                cp + RS_Vector(radius, 0.0),
                 false);
 #endif
         }
@@ -373,7 +448,7 @@ void RS_PainterQt::drawEllipse(const RS_Vector& cp,
                                bool reversed) {
     QPolygon pa;
     createEllipse(pa, cp, radius1, radius2, angle, a1, a2, reversed);
-    drawPolyline(pa);
+    addPolyline(pa);
 }
 
 
@@ -383,6 +458,7 @@ void RS_PainterQt::drawEllipse(const RS_Vector& cp,
  */
 void RS_PainterQt::drawImg(QImage& img, const RS_Vector& pos,
                            double angle, const RS_Vector& factor) {
+    flushBatch();
     save();
 
     // Render smooth only at close zooms
@@ -410,6 +486,7 @@ void RS_PainterQt::drawImg(QImage& img, const RS_Vector& pos,
 void RS_PainterQt::drawTextH(int x1, int y1,
                              int x2, int y2,
                              const QString& text) {
+    flushBatch();
     drawText(x1, y1, x2, y2,
              Qt::AlignRight|Qt::AlignVCenter,
              text);
@@ -420,6 +497,7 @@ void RS_PainterQt::drawTextH(int x1, int y1,
 void RS_PainterQt::drawTextV(int x1, int y1,
                              int x2, int y2,
                              const QString& text) {
+    flushBatch();
     save();
     QMatrix wm = worldMatrix();
     wm.rotate(-90.0);
@@ -435,6 +513,7 @@ void RS_PainterQt::drawTextV(int x1, int y1,
 
 void RS_PainterQt::fillRect(int x1, int y1, int w, int h,
                             const RS_Color& col) {
+    flushBatch();
     QPainter::fillRect(x1, y1, w, h, col);
 }
 
@@ -443,6 +522,7 @@ void RS_PainterQt::fillTriangle(const RS_Vector& p1,
                                 const RS_Vector& p2,
                                 const RS_Vector& p3) {
 
+    flushBatch();
     QPolygon arr(3);
     QBrush brushSaved=brush();
     arr.putPoints(0, 3,
@@ -456,6 +536,7 @@ void RS_PainterQt::fillTriangle(const RS_Vector& p1,
 
 
 void RS_PainterQt::erase() {
+    flushBatch();
     QPainter::eraseRect(0,0,getWidth(),getHeight());
 }
 
@@ -501,16 +582,16 @@ void RS_PainterQt::setPen(const RS_Pen& pen) {
            RS2::rsToQtLineType(lpen.getLineType()));
     p.setJoinStyle(Qt::RoundJoin);
     p.setCapStyle(Qt::RoundCap);
-    QPainter::setPen(p);
+    applyPen(p);
 }
 
 void RS_PainterQt::setPen(const RS_Color& color) {
     if (drawingMode==RS2::ModeBW) {
         lpen.setColor(RS_Color(0,0,0));
-        QPainter::setPen(RS_Color(0,0,0));
+        applyPen(QPen(RS_Color(0,0,0)));
     } else {
         lpen.setColor(color);
-        QPainter::setPen(color);
+        applyPen(QPen(color));
     }
 }
 
@@ -524,7 +605,7 @@ void RS_PainterQt::setPen(int r, int g, int b) {
 
 void RS_PainterQt::disablePen() {
     lpen = RS_Pen(RS2::FlagInvalid);
-    QPainter::setPen(Qt::NoPen);
+    applyPen(QPen(Qt::NoPen));
 }
 
 void RS_PainterQt::setBrush(const RS_Color& color) {
@@ -540,24 +621,29 @@ void RS_PainterQt::setBrush(const QBrush& color) {
 }
 
 void RS_PainterQt::drawPolygon(const QPolygon& a, Qt::FillRule rule) {
+    flushBatch();
     QPainter::drawPolygon(a,rule);
 }
 
 void RS_PainterQt::drawPath ( const QPainterPath & path ) {
+    flushBatch();
     QPainter::drawPath(path);
 }
 
 
 void RS_PainterQt::setClipRect(int x, int y, int w, int h) {
+    flushBatch();
     QPainter::setClipRect(x, y, w, h);
     setClipping(true);
 }
 
 void RS_PainterQt::resetClipping() {
+    flushBatch();
     setClipping(false);
 }
 
 void RS_PainterQt::fillRect ( const QRectF & rectangle, const RS_Color & color ) {
+        flushBatch();
 
         double x1=rectangle.left();
         double x2=rectangle.right();
@@ -567,6 +653,7 @@ void RS_PainterQt::fillRect ( const QRectF & rectangle, const RS_Color & color )
         QPainter::fillRect(toScreenX(x1),toScreenY(y1),toScreenX(x2)-toScreenX(x1),toScreenY(y2)-toScreenX(y1), color);
 }
 void RS_PainterQt::fillRect ( const QRectF & rectangle, const QBrush & brush ) {
+        flushBatch();
         double x1=rectangle.left();
         double x2=rectangle.right();
         double y1=rectangle.top();
@@ -28,6 +28,7 @@
 #ifndef RS_PAINTERQT_H
 #define RS_PAINTERQT_H
 
+#include <vector>
 #include <QPainter>
 
 #include "rs_painter.h"
@@ -43,6 +44,9 @@ public:
     RS_PainterQt( QPaintDevice* pd);
     virtual ~RS_PainterQt()=default;
 
+    virtual void beginBatch();
+    virtual void endBatch();
+
     virtual void moveTo(int x, int y);
     virtual void lineTo(int x, int y);
     virtual void drawGridPoint(const RS_Vector& p);
@@ -107,7 +111,36 @@ public:
     virtual void resetClipping();
 
 protected:
+    /** sets the pen of the painter, or of the next batched primitives */
+    void applyPen(const QPen& pen);
+    /** draws a polyline, or adds it to the batch of the current pen */
+    void addPolyline(const QPolygon& pa);
+    /** draws the batched primitives, one pen change per batch */
+    void flushBatch();
+
+    //! lines and polylines of one pen, collected in batched drawing
+    struct Batch {
+        QPen pen;
+        QPolygon gridPoints;
+        QVector<QLine> lines;
+        //! points of all polylines and the end index of each
+        QVector<QPoint> points;
+        QVector<int> polylineEnds;
+    };
+    Batch& currentBatch();
+
+    //! batches are flushed when more pens than this are used
+    static const size_t maxBatches = 64;
+    bool batching = false;
+    //! batches keep their capacity, only the first batchCount are in use
+    std::vector<Batch> batches;
+    size_t batchCount = 0;
+    size_t batchIndex = 0;
+    QPen qpen;
+
     RS_Pen lpen;
+    //! points of arcs, reused to avoid an allocation for every arc drawn
+    QPolygon arcPoints;
     long rememberX; // Used for the moment because QPainter doesn't support moveTo anymore, thus we need to remember ourselve the moveTo positions
     long rememberY;
 };
@@ -58,6 +58,14 @@ int RS_StaticGraphicView::getHeight() const{
     return height;
 }
 
+/**
+ * Sets the size of the bitmap drawn into.
+ */
+void RS_StaticGraphicView::setSize(int w, int h) {
+    width = w;
+    height = h;
+}
+
 RS_Vector RS_StaticGraphicView::getMousePosition() const
 {
     return RS_Vector(false);
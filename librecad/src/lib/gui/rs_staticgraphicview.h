@@ -41,6 +41,7 @@ public:
 
 	virtual int getWidth() const;
 	virtual int getHeight() const;
+	void setSize(int w, int h);
     virtual void redraw(RS2::RedrawMethod) {}
     virtual void adjustOffsetControls() {}
     virtual void adjustZoomControls() {}
@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#include <cmath>
+#include <utility>
+
+#include "lc_clipping.h"
+#include "rs_math.h"
+#include "rs_vector.h"
+
+bool LC_Clipping::clipLine(const RS_Vector& p1, const RS_Vector& p2,
+						   const RS_Vector& vpMin, const RS_Vector& vpMax,
+						   double& t1, double& t2)
+{
+	double const dx = p2.x - p1.x;
+	double const dy = p2.y - p1.y;
+	// left, right, bottom, top
+	double const p[4] = {-dx, dx, -dy, dy};
+	double const q[4] = {p1.x - vpMin.x, vpMax.x - p1.x,
+						 p1.y - vpMin.y, vpMax.y - p1.y};
+	for (int i = 0; i < 4; ++i) {
+		if (p[i] == 0.) {
+			// parallel to this border
+			if (q[i] < 0.) return false;
+			continue;
+		}
+		double const r = q[i] / p[i];
+		if (p[i] < 0.) {
+			if (r > t1) t1 = r;
+		} else {
+			if (r < t2) t2 = r;
+		}
+		if (t1 > t2) return false;
+	}
+	return true;
+}
+
+int LC_Clipping::clipArc(const RS_Vector& center, double radius,
+						 double baseAngle, double angleLength,
+						 const RS_Vector& vpMin, const RS_Vector& vpMax,
+						 double pieces[2 * maxArcPieces])
+{
+	if (radius <= 0. || angleLength <= 0.) return 0;
+	// circle borders outside of the window
+	if (center.x + radius < vpMin.x || center.x - radius > vpMax.x
+			|| center.y + radius < vpMin.y || center.y - radius > vpMax.y)
+		return 0;
+	// circle borders inside of the window
+	if (center.x - radius >= vpMin.x && center.x + radius <= vpMax.x
+			&& center.y - radius >= vpMin.y && center.y + radius <= vpMax.y) {
+		pieces[0] = 0.;
+		pieces[1] = angleLength;
+		return 1;
+	}
+
+	// arc ends and crossings with the window borders
+	double breaks[10];
+	int n = 0;
+	breaks[n++] = 0.;
+	breaks[n++] = angleLength;
+	auto addCrossing = [&](double dx, double dy) {
+		double const a = RS_Math::correctAngle(atan2(dy, dx) - baseAngle);
+		if (a > 0. && a < angleLength) breaks[n++] = a;
+	};
+	double const r2 = radius * radius;
+	for (double x: {vpMin.x, vpMax.x}) {
+		double const dx = x - center.x;
+		if (fabs(dx) >= radius) continue;
+		double const dy = sqrt(r2 - dx * dx);
+		addCrossing(dx, dy);
+		addCrossing(dx, -dy);
+	}
+	for (double y: {vpMin.y, vpMax.y}) {
+		double const dy = y - center.y;
+		if (fabs(dy) >= radius) continue;
+		double const dx = sqrt(r2 - dy * dy);
+		addCrossing(dx, dy);
+		addCrossing(-dx, dy);
+	}
+	for (int i = 1; i < n; ++i)
+		for (int j = i; j > 0 && breaks[j] < breaks[j - 1]; --j)
+			std::swap(breaks[j], breaks[j - 1]);
+
+	// keep intervals with visible middle points, merging neighbours
+	int count = 0;
+	for (int i = 1; i < n; ++i) {
+		if (breaks[i] <= breaks[i - 1]) continue;
+		double const a = baseAngle + 0.5 * (breaks[i - 1] + breaks[i]);
+		RS_Vector const vp(center.x + radius * cos(a),
+						   center.y + radius * sin(a));
+		if (!vp.isInWindowOrdered(vpMin, vpMax)) continue;
+		if (count > 0 && pieces[2 * count - 1] == breaks[i - 1]) {
+			pieces[2 * count - 1] = breaks[i];
+		} else if (count < maxArcPieces) {
+			pieces[2 * count] = breaks[i - 1];
+			pieces[2 * count + 1] = breaks[i];
+			++count;
+		}
+	}
+
+	// pieces with a near zero sweep would be drawn as full circles
+	int kept = 0;
+	for (int i = 0; i < count; ++i) {
+		if (pieces[2 * i + 1] - pieces[2 * i] <= RS_TOLERANCE_ANGLE) continue;
+		pieces[2 * kept] = pieces[2 * i];
+		pieces[2 * kept + 1] = pieces[2 * i + 1];
+		++kept;
+	}
+	return kept;
+}
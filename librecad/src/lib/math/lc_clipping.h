@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_CLIPPING_H
+#define LC_CLIPPING_H
+
+class RS_Vector;
+
+/**
+ * Clipping of lines and circular arcs to an axis aligned window, for the
+ * draw methods of entities and painters. Results are returned as
+ * parameters of the input, no temporary entities or containers are created.
+ */
+class LC_Clipping {
+private:
+	LC_Clipping() = delete;
+public:
+	/** maximum number of visible pieces of an arc clipped to a window */
+	static const int maxArcPieces = 5;
+
+	/**
+	 * Liang-Barsky clipping of the line p1 + t (p2 - p1) to the window
+	 * vpMin, vpMax (ordered corners).
+	 *
+	 * @param t1, t2 on input the parameter range to clip, 0 and 1 for the
+	 * segment p1, p2; on output the visible parameter range
+	 * @return false, if no part of the range is inside the window
+	 */
+	static bool clipLine(const RS_Vector& p1, const RS_Vector& p2,
+						 const RS_Vector& vpMin, const RS_Vector& vpMax,
+						 double& t1, double& t2);
+
+	/**
+	 * Clips the counterclockwise arc starting at baseAngle and spanning
+	 * angleLength to the window vpMin, vpMax (ordered corners).
+	 *
+	 * @param pieces receives start and end angles of the visible pieces,
+	 * relative to baseAngle and in ascending order; clipped pieces with
+	 * a sweep of at most RS_TOLERANCE_ANGLE are dropped
+	 * @return number of visible pieces
+	 */
+	static int clipArc(const RS_Vector& center, double radius,
+					   double baseAngle, double angleLength,
+					   const RS_Vector& vpMin, const RS_Vector& vpMax,
+					   double pieces[2 * maxArcPieces]);
+};
+
+#endif
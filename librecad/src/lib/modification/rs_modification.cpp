@@ -42,6 +42,7 @@
 #include "rs_text.h"
 #include "rs_layer.h"
 #include "lc_splinepoints.h"
+#include "lc_undodelta.h"
 #include "rs_math.h"
 
 #include "rs_dialogfactory.h"
@@ -164,57 +165,35 @@ bool RS_Modification::changeAttributes(RS_AttributesData& data) {
         return false;
     }
 
-	std::vector<RS_Entity*> addList;
+	std::vector<RS_Entity*> const selected = selectedEntities();
+	// the entities are changed in place, undo restores the recorded attributes
+	LC_UndoAttributes* delta = new LC_UndoAttributes(selected);
 
-    if (document) {
-        document->startUndoCycle();
-    }
+	for(auto e: selected){
+		e->setSelected(false);
 
-	for(auto e: *container){
-        //for (unsigned i=0; i<container->count(); ++i) {
-        //RS_Entity* e = container->entityAt(i);
-        if (e && e->isSelected()) {
-            RS_Entity* ec = e->clone();
-            ec->setSelected(false);
-
-            RS_Pen pen = ec->getPen(false);
-
-            if (data.changeLayer==true) {
-                ec->setLayer(data.layer);
-            }
+		RS_Pen pen = e->getPen(false);
 
-            if (data.changeColor==true) {
-                pen.setColor(data.pen.getColor());
-            }
-            if (data.changeLineType==true) {
-                pen.setLineType(data.pen.getLineType());
-            }
-            if (data.changeWidth==true) {
-                pen.setWidth(data.pen.getWidth());
-            }
+		if (data.changeLayer==true) {
+			e->setLayer(data.layer);
+		}
 
-            ec->setPen(pen);
+		if (data.changeColor==true) {
+			pen.setColor(data.pen.getColor());
+		}
+		if (data.changeLineType==true) {
+			pen.setLineType(data.pen.getLineType());
+		}
+		if (data.changeWidth==true) {
+			pen.setWidth(data.pen.getWidth());
+		}
 
-            //if (data.useCurrentLayer) {
-            //    ec->setLayerToActive();
-            //}
-            //if (data.useCurrentAttributes) {
-            //    ec->setPenToActive();
-            //}
-            //if (ec->rtti()==RS2::EntityInsert) {
-            //    ((RS_Insert*)ec)->update();
-            //}
-            ec->update();
-			addList.push_back(ec);
-        }
-    }
+		e->setPen(pen);
+		e->update();
+		container->entityModified(e);
+	}
 
-    deselectOriginals(true);
-    addNewEntities(addList);
-
-    if (document) {
-        document->endUndoCycle();
-    }
+	addDelta(delta);
 
     if (graphicView) {
         graphicView->redraw(RS2::RedrawDrawing);
@@ -450,7 +429,7 @@ void RS_Modification::paste(const RS_PasteData& data, RS_Graphic* source) {
 				name=blks->newName(name);
 			}
 			blocksDict[b->getName()] = name;
-			b->setName(name);
+			blks->rename(b, name);
 		}
 
         //add new blocks with new names
@@ -1442,6 +1421,19 @@ bool RS_Modification::move(RS_MoveData& data) {
         return false;
     }
 
+    if (data.number==0 && !data.useCurrentLayer && !data.useCurrentAttributes) {
+        // move in place, only the offset is kept for undo
+        // since 2.0.4.0: keep selection
+        LC_UndoMove* delta = new LC_UndoMove(selectedEntities(), data.offset);
+        delta->apply(false);
+        addDelta(delta);
+
+        if (graphicView) {
+            graphicView->redraw(RS2::RedrawDrawing);
+        }
+        return true;
+    }
+
 	std::vector<RS_Entity*> addList;
 
     if (document && handleUndo) {
@@ -1942,6 +1934,37 @@ void RS_Modification::deselectOriginals(bool remove
 
 
 
+/**
+ * @return selected entities of the container
+ */
+std::vector<RS_Entity*> RS_Modification::selectedEntities() const {
+	std::vector<RS_Entity*> ret;
+	for(auto e: *container){
+		if (e && e->isSelected()) {
+			ret.push_back(e);
+		}
+	}
+	return ret;
+}
+
+
+
+/**
+ * Adds the delta of an in place modification as one undo cycle, or
+ * deletes it if undo is not handled.
+ */
+void RS_Modification::addDelta(LC_UndoDelta* delta) {
+	if (document && handleUndo) {
+		document->startUndoCycle();
+		document->addUndoable(delta);
+		document->endUndoCycle();
+	} else {
+		delete delta;
+	}
+}
+
+
+
 /**
  * Adds the given entities to the container and draws the entities if
  * there's a graphic view available.
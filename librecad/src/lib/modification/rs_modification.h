@@ -38,6 +38,7 @@ class RS_Polyline;
 class RS_Document;
 class RS_Graphic;
 class RS_GraphicView;
+class LC_UndoDelta;
 
 /**
  * Holds the data needed for move modifications.
@@ -288,6 +289,8 @@ public:
 private:
     void deselectOriginals(bool remove);
 	void addNewEntities(std::vector<RS_Entity*>& addList);
+	std::vector<RS_Entity*> selectedEntities() const;
+	void addDelta(LC_UndoDelta* delta);
 	bool explodeTextIntoLetters(RS_MText* text, std::vector<RS_Entity*>& addList);
 	bool explodeTextIntoLetters(RS_Text* text, std::vector<RS_Entity*>& addList);
 
@@ -32,6 +32,7 @@
 #include "rs_entity.h"
 #include "rs_graphic.h"
 #include "rs_layer.h"
+#include "lc_endpointindex.h"
 
 
 
@@ -223,7 +224,6 @@ void RS_Selection::selectContour(RS_Entity* e) {
     RS_AtomicEntity* ae = (RS_AtomicEntity*)e;
     RS_Vector p1 = ae->getStartpoint();
     RS_Vector p2 = ae->getEndpoint();
-    bool found = false;
 
     // (de)select 1st entity:
     if (graphicView) {
@@ -234,57 +234,44 @@ void RS_Selection::selectContour(RS_Entity* e) {
         graphicView->drawEntity(e);
     }
 
-    do {
-        found = false;
-
-		for(auto en: *container){
-        //for (unsigned i=0; i<container->count(); ++i) {
-            //RS_Entity* en = container->entityAt(i);
-
-            if (en && en->isVisible() && 
-				en->isAtomic() && en->isSelected()!=select && 
+    // end points of the entities which can be added to the contour
+    LC_EndpointIndex endpoints(1.0e-4);
+	for(auto en: *container){
+        if (en && en!=e && en->isVisible() &&
+				en->isAtomic() && en->isSelected()!=select &&
 				(en->getLayer()==NULL || en->getLayer()->isLocked()==false)) {
+            endpoints.insert(en);
+        }
+    }
 
-                ae = (RS_AtomicEntity*)en;
-                bool doit = false;
-
-                // startpoint connects to 1st point
-                if (ae->getStartpoint().distanceTo(p1)<1.0e-4) {
-                    doit = true;
-                    p1 = ae->getEndpoint();
-                }
-
-                // endpoint connects to 1st point
-                else if (ae->getEndpoint().distanceTo(p1)<1.0e-4) {
-                    doit = true;
-                    p1 = ae->getStartpoint();
-                }
-
-                // startpoint connects to 2nd point
-                else if (ae->getStartpoint().distanceTo(p2)<1.0e-4) {
-                    doit = true;
-                    p2 = ae->getEndpoint();
-                }
+    // extend the contour at both ends:
+    for (;;) {
+        RS_Vector* p = &p1;
+        RS_Entity* en = endpoints.nearest(p1);
+        if (!en) {
+            p = &p2;
+            en = endpoints.nearest(p2);
+        }
+        if (!en) {
+            break;
+        }
+        endpoints.remove(en);
 
-                // endpoint connects to 1st point
-                else if (ae->getEndpoint().distanceTo(p2)<1.0e-4) {
-                    doit = true;
-                    p2 = ae->getStartpoint();
-                }
+        ae = (RS_AtomicEntity*)en;
+        if (ae->getStartpoint().distanceTo(*p)<1.0e-4) {
+            *p = ae->getEndpoint();
+        } else {
+            *p = ae->getStartpoint();
+        }
 
-                if (doit) {
-                    if (graphicView) {
-                        graphicView->deleteEntity(ae);
-                    }
-                    ae->setSelected(select);
-                    if (graphicView) {
-                        graphicView->drawEntity(ae);
-                    }
-                    found = true;
-                }
-            }
+        if (graphicView) {
+            graphicView->deleteEntity(ae);
+        }
+        ae->setSelected(select);
+        if (graphicView) {
+            graphicView->drawEntity(ae);
         }
-    } while(found);
+    }
 }
 
 
@@ -316,7 +303,18 @@ void RS_Selection::selectLayer(RS_Entity* e) {
  */
 void RS_Selection::selectLayer(const QString& layerName, bool select) {
 
-	for(auto en: *container){
+	// entities on the layer, or without a layer of their own:
+	RS_Layer* layer = graphic ? graphic->findLayer(layerName) : NULL;
+	std::vector<RS_Entity*> candidates;
+	if (layer) {
+		candidates = container->getLayerEntities(layer);
+		std::vector<RS_Entity*> const inherited = container->getLayerEntities(NULL);
+		candidates.insert(candidates.end(), inherited.begin(), inherited.end());
+	} else {
+		candidates.assign(container->begin(), container->end());
+	}
+
+	for(auto en: candidates){
 
         if (en && en->isVisible() && 
 				en->isSelected()!=select && 
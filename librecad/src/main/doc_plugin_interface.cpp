@@ -764,10 +764,13 @@ doc(d)
 ,docGr(doc->getGraphic())
 ,gView(gv)
 ,main(parent)
-,haveUndo(false){
+,haveUndo(false)
+,inBatch(false){
 }
 
 Doc_plugin_interface::~Doc_plugin_interface(){
+    if (inBatch)
+        commitBatch();
     if (haveUndo) {
         doc->endUndoCycle();
     }
@@ -796,33 +799,63 @@ void Doc_plugin_interface::updateView(){
     gView->redraw();
 }
 
+void Doc_plugin_interface::addToDocument(RS_Entity* entity){
+    doc->addEntity(entity);
+    if (!haveUndo) {
+        doc->startUndoCycle();
+        haveUndo = true;
+    }
+    doc->addUndoable(entity);
+}
+
+/*borders are calculated once in commitBatch(), the spatial index is
+  dropped to be bulk loaded on the next query instead of growing per entity*/
+void Doc_plugin_interface::beginBatch(){
+    if (!doc || inBatch)
+        return;
+    inBatch = true;
+    if (!haveUndo) {
+        doc->startUndoCycle();
+        haveUndo = true;
+    }
+    doc->setAutoUpdateBorders(false);
+    doc->invalidateSpatialIndex();
+}
+
+void Doc_plugin_interface::commitBatch(){
+    if (!inBatch)
+        return;
+    inBatch = false;
+    doc->setAutoUpdateBorders(true);
+    doc->calculateBorders();
+    gView->redraw();
+}
+
 void Doc_plugin_interface::addPoint(QPointF *start){
 
     RS_Vector v1(start->x(), start->y());
     if (doc) {
         RS_Point* entity = new RS_Point(doc, RS_PointData(v1));
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addPoint: currentContainer is NULL");
 }
 
+void Doc_plugin_interface::addPoints(std::vector<QPointF> const& points){
+    if (doc) {
+        for (QPointF const& p: points)
+            addToDocument(new RS_Point(doc, RS_PointData(RS_Vector(p.x(), p.y()))));
+    } else
+        RS_DEBUG->print("Doc_plugin_interface::addPoints: currentContainer is NULL");
+}
+
 void Doc_plugin_interface::addLine(QPointF *start, QPointF *end){
 
     RS_Vector v1(start->x(), start->y());
     RS_Vector v2(end->x(), end->y());
     if (doc) {
         RS_Line* entity = new RS_Line(doc, RS_LineData(v1, v2));
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addLine: currentContainer is NULL");
 }
@@ -841,12 +874,7 @@ void Doc_plugin_interface::addMText(QString txt, QString sty, QPointF *start,
                   txt, sty, angle, RS2::Update);
         RS_MText* entity = new RS_MText(doc, d);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addMtext: currentContainer is NULL");
 }
@@ -864,12 +892,7 @@ void Doc_plugin_interface::addText(QString txt, QString sty, QPointF *start,
                   RS_TextData::None, txt, sty, angle, RS2::Update);
         RS_Text* entity = new RS_Text(doc, d);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addText: currentContainer is NULL");
 }
@@ -880,12 +903,7 @@ void Doc_plugin_interface::addCircle(QPointF *start, qreal radius){
         RS_CircleData d(v, radius);
         RS_Circle* entity = new RS_Circle(doc, d);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addCircle: currentContainer is NULL");
 }
@@ -898,12 +916,7 @@ void Doc_plugin_interface::addArc(QPointF *start, qreal radius, qreal a1, qreal
 				 RS_Math::deg2rad(a2),
                  false);
         RS_Arc* entity = new RS_Arc(doc, d);
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addArc: currentContainer is NULL");
 }
@@ -917,12 +930,7 @@ void Doc_plugin_interface::addEllipse(QPointF *start, QPointF *end, qreal ratio,
                       a1, a2, false);
         RS_Ellipse* entity = new RS_Ellipse(doc, ed);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addEllipse: currentContainer is NULL");
 }
@@ -930,28 +938,20 @@ void Doc_plugin_interface::addEllipse(QPointF *start, QPointF *end, qreal ratio,
 void Doc_plugin_interface::addLines(std::vector<QPointF> const& points, bool closed)
 {
     if (doc) {
+        if (points.empty())
+            return;
         RS_LineData data;
-
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-
         data.endpoint=RS_Vector(points.front().x(), points.front().y());
 
         for(size_t i=1; i<points.size(); ++i){
             data.startpoint=data.endpoint;
             data.endpoint=RS_Vector(points[i].x(), points[i].y());
-            RS_Line* line=new RS_Line(doc, data);
-            doc->addEntity(line);
-            doc->addUndoable(line);
+            addToDocument(new RS_Line(doc, data));
         }
         if(closed){
             data.startpoint=data.endpoint;
             data.endpoint=RS_Vector(points.front().x(), points.front().y());
-            RS_Line* line=new RS_Line(doc, data);
-            doc->addEntity(line);
-            doc->addUndoable(line);
+            addToDocument(new RS_Line(doc, data));
         }
     } else
         RS_DEBUG->print("%s: currentContainer is NULL", __func__);
@@ -965,16 +965,15 @@ void Doc_plugin_interface::addPolyline(std::vector<Plug_VertexData> const& point
             data.setFlag(RS2::FlagClosed);
         RS_Polyline* entity = new RS_Polyline(doc, data);
 
+        std::vector<std::pair<RS_Vector, double> > vertices;
+        vertices.reserve(points.size());
         for(auto const& pt: points){
-            entity->addVertex(RS_Vector(pt.point.x(), pt.point.y()), pt.bulge);
+            vertices.emplace_back(RS_Vector(pt.point.x(), pt.point.y()), pt.bulge);
         }
+        //keeps the vertices packed
+        entity->appendVertexs(vertices);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("%s: currentContainer is NULL", __func__);
 }
@@ -989,12 +988,7 @@ void Doc_plugin_interface::addSplinePoints(std::vector<QPointF> const& points, b
 
         LC_SplinePoints* entity = new LC_SplinePoints(doc, data);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("%s: currentContainer is NULL", __func__);
 }
@@ -1018,12 +1012,7 @@ void Doc_plugin_interface::addImage(int handle, QPointF *start, QPointF *uvr, QP
                          con,
                          fade));
 
-        doc->addEntity(image);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(image);
+        addToDocument(image);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addImage: currentContainer is NULL");
 }
@@ -1036,12 +1025,7 @@ void Doc_plugin_interface::addInsert(QString name, QPointF ins, QPointF scale, q
         RS_InsertData id(name, ip, sp, rot, 1, 1, RS_Vector(0.0, 0.0));
         RS_Insert* entity = new RS_Insert(doc, id);
 
-        doc->addEntity(entity);
-        if (!haveUndo) {
-            doc->startUndoCycle();
-            haveUndo = true;
-        }
-        doc->addUndoable(entity);
+        addToDocument(entity);
     } else
         RS_DEBUG->print("Doc_plugin_interface::addInsert: currentContainer is NULL");
 }
@@ -1096,12 +1080,7 @@ void Doc_plugin_interface::addEntity(Plug_Entity *handle){
     if (doc) {
         RS_Entity *ent = (reinterpret_cast<Plugin_Entity*>(handle))->getEnt();
         if (ent != NULL) {
-            doc->addEntity(ent);
-            if (!haveUndo) {
-                doc->startUndoCycle();
-                haveUndo = true;
-            }
-            doc->addUndoable(ent);
+            addToDocument(ent);
         }
     } else
         RS_DEBUG->print("Doc_plugin_interface::addEntity: currentContainer is NULL");
@@ -1129,7 +1108,8 @@ void Doc_plugin_interface::removeEntity(Plug_Entity *ent){
         e->changeUndoState();
         doc->addUndoable(e);
 
-        gView->redraw(RS2::RedrawDrawing);
+        if (!inBatch)
+            gView->redraw(RS2::RedrawDrawing);
     }
 }
 
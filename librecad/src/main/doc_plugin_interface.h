@@ -77,7 +77,10 @@ public:
     Doc_plugin_interface(RS_Document *d, RS_GraphicView* gv, QWidget* parent);
     ~Doc_plugin_interface();
     void updateView();
+    void beginBatch();
+    void commitBatch();
     void addPoint(QPointF *start);
+    void addPoints(std::vector<QPointF> const& points);
     void addLine(QPointF *start, QPointF *end);
     void addMText(QString txt, QString sty, QPointF *start,
             double height, double angle, DPI::HAlign ha,  DPI::VAlign va);
@@ -128,11 +131,15 @@ public:
     /*metod to handle undo in Plugin_Entity*/
     bool addToUndo(RS_Entity* current, RS_Entity* modified);
 private:
+    /*adds a new entity to the document and to the undo cycle*/
+    void addToDocument(RS_Entity* entity);
+
     RS_Document *doc;
     RS_Graphic *docGr;
     RS_GraphicView *gView;
     QWidget* main;
     bool haveUndo;
+    bool inBatch;
 };
 
 /*void addArc(QPointF *start);			->Without start
@@ -0,0 +1,532 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageWriter>
+#include <QPrinter>
+#include <QProcess>
+#include <QRegExp>
+#include <QTextStream>
+#include <QThread>
+
+#include "lc_batchconverter.h"
+#include "lc_makercamsvg.h"
+#include "lc_xmlwriterqxmlstreamwriter.h"
+#include "rs_dialogfactory.h"
+#include "rs_fileio.h"
+#include "rs_graphic.h"
+#include "rs_painterqt.h"
+#include "rs_settings.h"
+#include "rs_staticgraphicview.h"
+#include "rs_units.h"
+
+namespace {
+/** interval in ms to wait for each running worker */
+const int pollInterval = 10;
+
+/**
+ * @return DXF version written for the output format or FormatUnknown
+ */
+RS2::FormatType dxfType(const QString& format)
+{
+    static const std::map<QString, RS2::FormatType> types{
+        {"dxf", RS2::FormatDXFRW},
+        {"dxf2004", RS2::FormatDXFRW2004},
+        {"dxf2000", RS2::FormatDXFRW2000},
+        {"dxf14", RS2::FormatDXFRW14},
+        {"dxf12", RS2::FormatDXFRW12}
+    };
+    auto it = types.find(format);
+    return it != types.end() ? it->second : RS2::FormatUnknown;
+}
+
+bool isImageFormat(const QString& format)
+{
+    return QImageWriter::supportedImageFormats().contains(format.toLatin1());
+}
+
+QString jsonString(const QString& s)
+{
+    QString ret("\"");
+    for (QChar const c: s) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+            ret += c;
+        } else if (c.unicode() < 0x20) {
+            ret += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        } else {
+            ret += c;
+        }
+    }
+    return ret + '"';
+}
+
+/** @return time in ms or null if the step was not reached */
+QString jsonTime(qint64 t)
+{
+    return t >= 0 ? QString::number(t) : QString("null");
+}
+
+/**
+ * Keeps the command messages of the filters, the only error
+ * description available after a failed import.
+ */
+class MessageCollector: public RS_DialogFactoryAdapter {
+public:
+    virtual void commandMessage(const QString& message) {
+        messages << message;
+    }
+
+    QStringList messages;
+};
+}
+
+struct LC_BatchConverter::Job {
+    QString input;
+    QString output;
+    QProcess process;
+    QElapsedTimer timer;
+    //! error found by the dispatcher, e.g. a timeout
+    QString error;
+};
+
+LC_BatchConverter::LC_BatchConverter(int argc, char** argv,
+                                     const QList<int>& argClean):
+    size(640, 480)
+  , jobs(QThread::idealThreadCount())
+  , timeout(0)
+  , worker(false)
+{
+    bool allowOptions = true;
+    for (int i=1; i<argc; ++i) {
+        if (argClean.contains(i)) continue;
+        QString const arg = QFile::decodeName(argv[i]);
+        if (allowOptions && arg == "-") {
+            // file names from stdin, for lists beyond the command line limit
+            QTextStream in(stdin);
+            for (QString line = in.readLine(); !line.isNull(); line = in.readLine()) {
+                if (!line.trimmed().isEmpty()) {
+                    files << QFileInfo(line.trimmed()).absoluteFilePath();
+                }
+            }
+            continue;
+        }
+        if (!allowOptions || !arg.startsWith("-")) {
+            files << QFileInfo(arg).absoluteFilePath();
+            continue;
+        }
+        if (arg == "--") {
+            allowOptions = false;
+            continue;
+        }
+        if (arg == "--worker") {
+            worker = true;
+            continue;
+        }
+        // all other options take a value:
+        if (i+1 >= argc) {
+            errors << QString("missing value of %1").arg(arg);
+            break;
+        }
+        QString const value = QFile::decodeName(argv[++i]);
+        bool ok = true;
+        if (arg == "--convert") {
+            format = value.toLower();
+        } else if (arg == "--output-dir") {
+            outputDir = QFileInfo(value).absoluteFilePath();
+        } else if (arg == "--report") {
+            reportName = value;
+        } else if (arg == "--jobs") {
+            jobs = value.toInt(&ok);
+        } else if (arg == "--timeout") {
+            timeout = value.toInt(&ok);
+        } else if (arg == "--size") {
+            QRegExp const rx("(\\d+)x(\\d+)");
+            ok = rx.exactMatch(value);
+            size = QSize(rx.cap(1).toInt(), rx.cap(2).toInt());
+        } else {
+            errors << QString("unknown option %1").arg(arg);
+        }
+        if (!ok) {
+            errors << QString("invalid value of %1: %2").arg(arg).arg(value);
+        }
+    }
+    jobs = std::max(jobs, 1);
+
+    if (dxfType(format) == RS2::FormatUnknown && format != "svg"
+            && format != "pdf" && !isImageFormat(format)) {
+        errors << QString("unsupported output format: %1").arg(format);
+    }
+    if (size.isEmpty()) {
+        errors << QString("invalid image size");
+    }
+}
+
+bool LC_BatchConverter::isRequested(int argc, char** argv)
+{
+    for (int i=1; i<argc; ++i) {
+        if (QString(argv[i]) == "--") return false;
+        if (QString(argv[i]) == "--convert") return true;
+    }
+    return false;
+}
+
+void LC_BatchConverter::printUsage()
+{
+    qDebug()<<"librecad --convert <format> [options] <files>";
+    qDebug()<<"\tconvert drawings without the GUI, file names are read from stdin for -";
+    qDebug()<<"\t<format> is one of";
+    qDebug()<<"\tdxf, dxf2004, dxf2000, dxf14, dxf12, svg, pdf, png, jpg, bmp";
+    qDebug()<<"--output-dir <dir>\tdirectory of the output, default next to the input";
+    qDebug()<<"--jobs <n>\tnumber of files converted at once, default one per core";
+    qDebug()<<"--report <file>\twrite the JSON lines report to file, default stdout";
+    qDebug()<<"--size <w>x<h>\tsize of images in pixels, default 640x480";
+    qDebug()<<"--timeout <s>\tabort a file after s seconds, default never";
+}
+
+int LC_BatchConverter::exec()
+{
+    if (!worker && files.isEmpty()) {
+        errors << QString("no input files");
+    }
+    if (!errors.isEmpty()) {
+        QTextStream err(stderr);
+        for (const QString& e: errors) {
+            err << "librecad: " << e << '\n';
+        }
+        return 2;
+    }
+    return worker ? work() : dispatch();
+}
+
+/**
+ * Runs the workers and writes one report line per file as soon as its
+ * worker is finished.
+ */
+int LC_BatchConverter::dispatch()
+{
+    QFile reportFile;
+    bool opened = false;
+    if (reportName.isEmpty()) {
+        opened = reportFile.open(stdout, QIODevice::WriteOnly);
+    } else {
+        reportFile.setFileName(reportName);
+        opened = reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!opened) {
+        QTextStream(stderr) << "librecad: cannot write report "
+                            << reportName << '\n';
+        return 2;
+    }
+    if (!outputDir.isEmpty()) {
+        QDir().mkpath(outputDir);
+    }
+    QTextStream report(&reportFile);
+    report.setCodec("UTF-8");
+
+    QElapsedTimer timer;
+    timer.start();
+    int failed = 0;
+    int next = 0;
+    std::vector<std::unique_ptr<Job>> running;
+    while (next < files.size() || !running.empty()) {
+        while ((int) running.size() < jobs && next < files.size()) {
+            std::unique_ptr<Job> job(new Job);
+            job->input = files.at(next++);
+            job->output = outputName(job->input);
+            startJob(job.get());
+            running.push_back(std::move(job));
+        }
+        for (auto it = running.begin(); it != running.end();) {
+            Job* job = it->get();
+            bool done = job->process.state() == QProcess::NotRunning
+                    || job->process.waitForFinished(pollInterval);
+            if (!done && timeout > 0 && job->timer.elapsed() > timeout * 1000) {
+                job->process.kill();
+                job->process.waitForFinished();
+                job->error = QString("timed out after %1 s").arg(timeout);
+                done = true;
+            }
+            if (done) {
+                if (!finishJob(job, report)) ++failed;
+                it = running.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    QTextStream(stderr) << "librecad: converted " << files.size() - failed
+                        << " of " << files.size() << " files in "
+                        << timer.elapsed() << " ms\n";
+    return failed ? 1 : 0;
+}
+
+void LC_BatchConverter::startJob(Job* job)
+{
+    job->timer.start();
+    if (job->output == job->input) {
+        job->error = QString("output would overwrite the input");
+        return;
+    }
+    QStringList args;
+    args << "--convert" << format
+         << "--size" << QString("%1x%2").arg(size.width()).arg(size.height())
+         << "--worker" << "--" << job->input << job->output;
+#if QT_VERSION >= 0x050200
+    job->process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+#endif
+    job->process.start(QCoreApplication::applicationFilePath(), args);
+}
+
+/**
+ * Writes the report line of a finished worker.
+ *
+ * @return true if the file was converted
+ */
+bool LC_BatchConverter::finishJob(Job* job, QTextStream& report)
+{
+    QString status("error");
+    QString error = job->error;
+    qint64 loadTime = -1;
+    qint64 exportTime = -1;
+    if (error.isEmpty()) {
+        if (job->process.error() == QProcess::FailedToStart) {
+            error = QString("worker failed to start");
+        } else if (job->process.exitStatus() == QProcess::CrashExit) {
+            error = QString("worker crashed");
+        } else {
+            // the last line of the worker holds status, load time,
+            // export time and error separated by tabs
+            QStringList const lines = QString::fromUtf8(
+                        job->process.readAllStandardOutput()).split('\n', QString::SkipEmptyParts);
+            QStringList const fields = lines.isEmpty() ? QStringList()
+                                                       : lines.last().split('\t');
+            if (fields.size() == 4) {
+                status = fields.at(0);
+                loadTime = fields.at(1).toLongLong();
+                exportTime = fields.at(2).toLongLong();
+                error = fields.at(3);
+            } else {
+                error = QString("worker exited with code %1")
+                        .arg(job->process.exitCode());
+            }
+        }
+    }
+
+    report << "{\"input\":" << jsonString(job->input)
+           << ",\"output\":" << jsonString(job->output)
+           << ",\"status\":" << jsonString(status)
+           << ",\"error\":" << jsonString(error)
+           << ",\"load_ms\":" << jsonTime(loadTime)
+           << ",\"export_ms\":" << jsonTime(exportTime)
+           << ",\"total_ms\":" << job->timer.elapsed()
+           << "}\n";
+    report.flush();
+    return status == "ok";
+}
+
+/**
+ * @return output file of input, in the output directory if one was given
+ */
+QString LC_BatchConverter::outputName(const QString& input) const
+{
+    QFileInfo const info(input);
+    QString const suffix = dxfType(format) != RS2::FormatUnknown ? QString("dxf") : format;
+    QDir const dir(outputDir.isEmpty() ? info.absolutePath() : outputDir);
+    return dir.absoluteFilePath(info.completeBaseName() + '.' + suffix);
+}
+
+/**
+ * Converts the single file of a worker process and prints its result line.
+ */
+int LC_BatchConverter::work()
+{
+    if (files.size() != 2) {
+        QTextStream(stderr) << "librecad: --worker needs an input and an output file\n";
+        return 2;
+    }
+    qint64 loadTime = -1;
+    qint64 exportTime = -1;
+    QString error;
+    bool const ok = convert(files.at(0), files.at(1), loadTime, exportTime, error);
+
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    out << (ok ? "ok" : "error") << '\t' << loadTime << '\t' << exportTime
+        << '\t' << error.simplified() << '\n';
+    return ok ? 0 : 1;
+}
+
+bool LC_BatchConverter::convert(const QString& input, const QString& output,
+                                qint64& loadTime, qint64& exportTime,
+                                QString& error) const
+{
+    // filters report errors as command messages only
+    MessageCollector messages;
+    RS_DialogFactory::instance()->setFactoryObject(&messages);
+
+    QElapsedTimer timer;
+    timer.start();
+    RS_Graphic graphic;
+    graphic.newDoc();
+    // the filter is called directly, RS_FileIO asks before importing DWG
+    RS2::FormatType const type = RS_FileIO::detectFormat(input);
+    std::unique_ptr<RS_FilterInterface> filter;
+    if (type != RS2::FormatUnknown) {
+        filter = RS_FileIO::instance()->getImportFilter(input, type);
+    }
+    bool ok = false;
+    if (!filter) {
+        error = QString("unsupported input format");
+    } else if (!filter->fileImport(graphic, input, type)) {
+        error = messages.messages.isEmpty() ? QString("import failed")
+                                            : messages.messages.last();
+    } else {
+        graphic.calculateBorders();
+        loadTime = timer.restart();
+        ok = exportGraphic(graphic, output, error);
+        exportTime = timer.elapsed();
+        if (!ok && error.isEmpty()) {
+            error = QString("export failed");
+        }
+    }
+
+    RS_DialogFactory::instance()->setFactoryObject(nullptr);
+    return ok;
+}
+
+bool LC_BatchConverter::exportGraphic(RS_Graphic& graphic, const QString& output,
+                                      QString& error) const
+{
+    RS2::FormatType const type = dxfType(format);
+    if (type != RS2::FormatUnknown) {
+        return RS_FileIO::instance()->fileExport(graphic, output, type);
+    }
+    if (format == "pdf") {
+        return exportPdf(graphic, output, error);
+    }
+    if (format != "svg") {
+        return exportImage(graphic, output, error);
+    }
+
+    RS_SETTINGS->beginGroup("/ExportMakerCam");
+    LC_MakerCamSVG generator(new LC_XMLWriterQXmlStreamWriter(),
+                             (bool)RS_SETTINGS->readNumEntry("/ExportInvisibleLayers"),
+                             (bool)RS_SETTINGS->readNumEntry("/ExportConstructionLayers"),
+                             (bool)RS_SETTINGS->readNumEntry("/WriteBlocksInline"),
+                             (bool)RS_SETTINGS->readNumEntry("/ConvertEllipsesToBeziers"));
+    RS_SETTINGS->endGroup();
+    if (!generator.generate(&graphic)) {
+        return false;
+    }
+    std::string const svg = generator.resultAsString();
+    QFile file(output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(svg.data(), svg.size()) != (qint64) svg.size()) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Prints the drawing to PDF on its paper format, as the print dialog does.
+ */
+bool LC_BatchConverter::exportPdf(RS_Graphic& graphic, const QString& output,
+                                  QString& error) const
+{
+    QPrinter printer(QPrinter::HighResolution);
+    bool landscape = false;
+    QPrinter::PageSize paperSize = RS2::rsToQtPaperFormat(graphic.getPaperFormat(&landscape));
+    if (paperSize == QPrinter::Custom) {
+        RS_Vector s = graphic.getPaperSize();
+        if (landscape) s = s.flipXY();
+        printer.setPaperSize(QSizeF(s.x, s.y), QPrinter::Millimeter);
+    } else {
+        printer.setPaperSize(paperSize);
+    }
+    printer.setOrientation(landscape ? QPrinter::Landscape : QPrinter::Portrait);
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    printer.setOutputFileName(output);
+    printer.setResolution(1200);
+    printer.setFullPage(true);
+
+    RS_PainterQt painter(&printer);
+    if (!painter.isActive()) {
+        error = QString("cannot write %1").arg(output);
+        return false;
+    }
+    RS_StaticGraphicView gv(printer.width(), printer.height(), &painter);
+    gv.setPrinting(true);
+    gv.setBorders(0, 0, 0, 0);
+
+    double const fx = (double)printer.width() / printer.widthMM()
+            * RS_Units::getFactorToMM(graphic.getUnit());
+    double const fy = (double)printer.height() / printer.heightMM()
+            * RS_Units::getFactorToMM(graphic.getUnit());
+    double const f = (fx + fy) / 2.0;
+    gv.setOffset((int)(graphic.getPaperInsertionBase().x * f),
+                 (int)(graphic.getPaperInsertionBase().y * f));
+    gv.setFactor(f * graphic.getPaperScale());
+    gv.setContainer(&graphic);
+    gv.drawEntity(&painter, &graphic);
+    return painter.end();
+}
+
+/**
+ * Draws the whole drawing zoomed to the image size on white background.
+ */
+bool LC_BatchConverter::exportImage(RS_Graphic& graphic, const QString& output,
+                                    QString& error) const
+{
+    QImage image(size, QImage::Format_ARGB32);
+    RS_PainterQt painter(&image);
+    painter.setBackground(RS_Color(255, 255, 255));
+    painter.eraseRect(0, 0, size.width(), size.height());
+
+    RS_StaticGraphicView gv(size.width(), size.height(), &painter);
+    gv.setBackground(RS_Color(255, 255, 255));
+    gv.setContainer(&graphic);
+    gv.zoomAuto(false);
+    for (RS_Entity* e = graphic.firstEntity(RS2::ResolveAll);
+         e; e = graphic.nextEntity(RS2::ResolveAll)) {
+        gv.drawEntity(&painter, e);
+    }
+    painter.end();
+
+    QImageWriter writer(output, format.toLatin1());
+    if (!writer.write(image)) {
+        error = writer.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2015 LibreCAD.org
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**********************************************************************/
+
+
+#ifndef LC_BATCHCONVERTER_H
+#define LC_BATCHCONVERTER_H
+
+#include <QList>
+#include <QSize>
+#include <QStringList>
+
+class QTextStream;
+class RS_Graphic;
+
+/**
+ * Converts drawings without the application window:
+ *
+ *   librecad --convert <format> [options] <files>
+ *
+ * Every file is converted by a worker process running the same executable
+ * with --worker, up to --jobs at once. A drawing crashing the importer
+ * only fails its own record, and no engine singleton is shared between
+ * threads.
+ *
+ * For every file one JSON object is written on a line of the report
+ * (stdout or --report) with the input, output, status, error and the
+ * load, export and total times in milliseconds.
+ */
+class LC_BatchConverter {
+public:
+    LC_BatchConverter(int argc, char** argv, const QList<int>& argClean);
+
+    /** @return true if the command line asks for batch conversion */
+    static bool isRequested(int argc, char** argv);
+    /** prints the options of the batch mode */
+    static void printUsage();
+
+    /** @return exit code, 0 if all files were converted */
+    int exec();
+
+private:
+    struct Job;
+
+    int dispatch();
+    int work();
+
+    void startJob(Job* job);
+    bool finishJob(Job* job, QTextStream& report);
+
+    QString outputName(const QString& input) const;
+    bool convert(const QString& input, const QString& output,
+                 qint64& loadTime, qint64& exportTime, QString& error) const;
+    bool exportGraphic(RS_Graphic& graphic, const QString& output,
+                       QString& error) const;
+    bool exportPdf(RS_Graphic& graphic, const QString& output,
+                   QString& error) const;
+    bool exportImage(RS_Graphic& graphic, const QString& output,
+                     QString& error) const;
+
+    QString format;
+    QString outputDir;
+    QString reportName;
+    QSize size;
+    int jobs;
+    int timeout;
+    bool worker;
+    QStringList files;
+    QStringList errors;
+};
+
+#endif
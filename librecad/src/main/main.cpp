@@ -44,6 +44,8 @@ QSplashScreen *splash=nullptr;
 #include "rs_system.h"
 #include "rs_fileio.h"
 #include "qg_dlginitial.h"
+#include "lc_batchconverter.h"
+#include "lc_trace.h"
 
 #include "qc_applicationwindow.h"
 
@@ -81,6 +83,13 @@ int main(int argc, char** argv) {
 #endif
 
 
+#if QT_VERSION >= 0x050000
+    // batch conversion must not need a display:
+    if (LC_BatchConverter::isRequested(argc, argv) && qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+#endif
+
     QApplication app(argc, argv);
 #if defined(Q_OS_MAC) && QT_VERSION > 0x050000
 //need stylesheet for Qt5 on mac
@@ -133,6 +142,10 @@ int main(int argc, char** argv) {
                 qDebug()<<"";
                 qDebug()<<" --help\tdisplay this message";
                 qDebug()<<"-d, --debug <level>";
+                qDebug()<<"--trace[=<file>]\tprint timings at exit, write a Chrome trace file";
+                qDebug()<<"";
+                LC_BatchConverter::printUsage();
+                qDebug()<<"";
                 RS_DEBUG->print( RS_Debug::D_NOTHING, "possible debug levels:");
                 RS_DEBUG->print( RS_Debug::D_NOTHING, "    %d Nothing", RS_Debug::D_NOTHING);
                 RS_DEBUG->print( RS_Debug::D_NOTHING, "    %d Critical", RS_Debug::D_CRITICAL);
@@ -227,6 +240,12 @@ int main(int argc, char** argv) {
 //                    RS_DEBUG->setLevel(RS_Debug::D_DEBUGGING);
 //                }
             }
+            if (allowOptions && argstr.startsWith("--trace")) {
+                argClean<<i;
+                // --trace prints a summary of the load, update, render and
+                // snap phases at exit, --trace=<file> also writes a Chrome trace
+                LC_Trace::enable(QFile::encodeName(argstr.section('=', 1)).constData());
+            }
         }
         RS_DEBUG->print("param 0: %s", argv[0]);
 
@@ -235,6 +254,15 @@ int main(int argc, char** argv) {
     RS_SETTINGS->init(XSTR(QC_COMPANYKEY), XSTR(QC_APPKEY));
     RS_SYSTEM->init(XSTR(QC_APPNAME), XSTR(QC_VERSION), XSTR(QC_APPDIR), prgDir);
 
+        // convert files without creating the application window:
+        if (LC_BatchConverter::isRequested(argc, argv)) {
+            RS_FONTLIST->init();
+            RS_PATTERNLIST->init();
+            setlocale(LC_NUMERIC, "C");
+            LC_BatchConverter converter(argc, argv, argClean);
+            return converter.exec();
+        }
+
         // parse command line arguments that might not need a launched program:
         QStringList fileList = handleArgs(argc, argv, argClean);
 
@@ -31,6 +31,8 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QTimer>
+#include <QThreadPool>
+#include <QRunnable>
 #include <QSplitter>
 #include <QMdiArea>
 #include <QPluginLoader>
@@ -63,6 +65,7 @@
 
 #include "rs_actionprintpreview.h"
 #include "rs_settings.h"
+#include "rs_graphic.h"
 #include "rs_staticgraphicview.h"
 #include "rs_system.h"
 #include "rs_actionlibraryinsert.h"
@@ -196,6 +199,9 @@ QC_ApplicationWindow::QC_ApplicationWindow()
     RS_SETTINGS->beginGroup("/Defaults");
     autosaveTimer->start(RS_SETTINGS->readNumEntry("/AutoSaveTime", 5)*60*1000);
     RS_SETTINGS->endGroup();
+    autosavePool = new QThreadPool(this);
+    autosavePool->setMaxThreadCount(1);
+    autosaveRunning = false;
 
     // Disable menu and toolbar items
     emit windowsChanged(false);
@@ -335,6 +341,7 @@ w->getGraphicView()->redraw();
  */
 QC_ApplicationWindow::~QC_ApplicationWindow() {
     RS_DEBUG->print("QC_ApplicationWindow::~QC_ApplicationWindow");
+    autosavePool->waitForDone();
 #ifdef RS_SCRIPTING
 
     RS_DEBUG->print("QC_ApplicationWindow::~QC_ApplicationWindow: "
@@ -1780,6 +1787,8 @@ void QC_ApplicationWindow::slotFileSave() {
     RS_DEBUG->print("QC_ApplicationWindow::slotFileSave()");
 
     statusBar()->showMessage(tr("Saving drawing..."));
+    // a pending auto-save must not recreate the auto-save file afterwards
+    autosavePool->waitForDone();
 
     QC_MDIWindow* w = getMDIWindow();
     QString name;
@@ -1823,6 +1832,7 @@ void QC_ApplicationWindow::slotFileSaveAs() {
     RS_DEBUG->print("QC_ApplicationWindow::slotFileSaveAs()");
 
     statusBar()->showMessage(tr("Saving drawing under new filename..."));
+    autosavePool->waitForDone();
 
     QC_MDIWindow* w = getMDIWindow();
     QString name;
@@ -1860,32 +1870,81 @@ void QC_ApplicationWindow::slotFileSaveAs() {
 
 
 
+namespace {
 /**
- * Autosave.
+ * Writes the snapshot of a drawing for auto-save and reports the
+ * result to the application window.
+ */
+class AutoSaveWriter: public QRunnable {
+public:
+    AutoSaveWriter(RS_Graphic* snapshot, QObject* receiver)
+        : snapshot(snapshot), fileName(snapshot->getFilename()), receiver(receiver) {}
+
+    void run() {
+        bool ok = RS_Graphic::saveSnapshot(snapshot);
+        QMetaObject::invokeMethod(receiver, "slotFileAutoSaveFinished",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(bool, ok), Q_ARG(QString, fileName));
+    }
+
+private:
+    RS_Graphic* snapshot;
+    QString fileName;
+    QObject* receiver;
+};
+}
+
+/**
+ * Autosave. The drawing is copied and the copy is written on a
+ * background thread, so editing can go on meanwhile.
  */
 void QC_ApplicationWindow::slotFileAutoSave() {
     RS_DEBUG->print("QC_ApplicationWindow::slotFileAutoSave()");
 
-    statusBar()->showMessage(tr("Auto-saving drawing..."), 2000);
+    if (autosaveRunning) {
+        // the previous auto-save is still being written
+        return;
+    }
 
     QC_MDIWindow* w = getMDIWindow();
     if (w) {
-        bool cancelled;
-        if (w->slotFileSave(cancelled, true)) {
-            // auto-save cannot be cancelled by user, so the
-            // "cancelled" parameter is a dummy
-            statusBar()->showMessage(tr("Auto-saved drawing"), 2000);
-        } else {
-            // error
-            autosaveTimer->stop();
-            QMessageBox::information(this, QMessageBox::tr("Warning"),
-                                     tr("Cannot auto-save the file\n%1\nPlease "
-                                        "check the permissions.\n"
-                                        "Auto-save disabled.")
-                                     .arg(w->getDocument()->getAutoSaveFilename()),
-                                     QMessageBox::Ok);
-            statusBar()->showMessage(tr("Auto-saving failed"), 2000);
+        RS_Document* document = w->getDocument();
+        if (!document || !document->isModified()) {
+            RS_DEBUG->print("QC_ApplicationWindow::slotFileAutoSave: not modified");
+            return;
         }
+        RS_Graphic* graphic = document->getGraphic();
+        if (!graphic) {
+            return;
+        }
+
+        statusBar()->showMessage(tr("Auto-saving drawing..."), 2000);
+        autosaveRunning = true;
+        autosavePool->start(new AutoSaveWriter(graphic->createSnapshot(), this));
+    }
+}
+
+
+
+/**
+ * Called when an auto-save was written.
+ */
+void QC_ApplicationWindow::slotFileAutoSaveFinished(bool ok, const QString& fileName) {
+    RS_DEBUG->print("QC_ApplicationWindow::slotFileAutoSaveFinished()");
+
+    autosaveRunning = false;
+    if (ok) {
+        statusBar()->showMessage(tr("Auto-saved drawing"), 2000);
+    } else {
+        // error
+        autosaveTimer->stop();
+        QMessageBox::information(this, QMessageBox::tr("Warning"),
+                                 tr("Cannot auto-save the file\n%1\nPlease "
+                                    "check the permissions.\n"
+                                    "Auto-save disabled.")
+                                 .arg(fileName),
+                                 QMessageBox::Ok);
+        statusBar()->showMessage(tr("Auto-saving failed"), 2000);
     }
 }
 
@@ -43,6 +43,7 @@ class QAssistantClient;
 #include "lc_customtoolbar.h"
 
 class QMdiArea;
+class QThreadPool;
 class QMdiSubWindow;
 class QC_MDIWindow;
 class QG_LibraryWidget;
@@ -140,6 +141,8 @@ public slots:
     void slotFileSaveAs();
     /** auto-save document */
     void slotFileAutoSave();
+    /** reports the result of an auto-save written in the background */
+    void slotFileAutoSaveFinished(bool ok, const QString& fileName);
     /** exports the document as bitmap */
     void slotFileExport();
     bool slotFileExport(const QString& name, const QString& format,
@@ -322,6 +325,9 @@ private:
     /** Pointer to the application window (this). */
     static QC_ApplicationWindow* appWindow;
     QTimer *autosaveTimer;
+    /** writes auto-save snapshots, one at a time */
+    QThreadPool *autosavePool;
+    bool autosaveRunning;
 
     /** MdiArea for MDI */
     QMdiArea* mdiAreaCAD;
@@ -489,6 +489,26 @@ public:
     * \return a string with the converted number.
     */
     virtual QString realToStr(const qreal num, const int units = 0, const int prec = 0) = 0;
+
+    // appended to keep the slots of the methods above for built plugins:
+
+    //! Start a batch of document changes.
+    /*! Entities added until commitBatch() share one undo cycle; borders and
+    *  spatial index of the document are updated once on commit instead of
+    *  after every entity. Use it around imports of many entities.
+    */
+    virtual void beginBatch() = 0;
+
+    //! End the batch started with beginBatch().
+    /*! Update the document borders and redraw the graphic view once.
+    */
+    virtual void commitBatch() = 0;
+
+    //! Add point entities to current document.
+    /*! Add one point entity per coordinate with current attributes.
+    *  \param points point coordinates.
+    */
+    virtual void addPoints(std::vector<QPointF> const& points) = 0;
 };
 
 
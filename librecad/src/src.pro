@@ -13,6 +13,9 @@ DEFINES += HAS_BOOST=1
 #uncomment to enable a Debugging menu entry for basic unit testing
 #DEFINES += LC_DEBUGGING
 
+#comment out to compile the --trace timers and counters out
+DEFINES += LC_TRACE
+
 DEFINES += DWGSUPPORT
 DEFINES -= JWW_WRITE_SUPPORT
 
@@ -128,6 +131,7 @@ HEADERS += \
     lib/actions/rs_snapper.h \
     lib/creation/rs_creation.h \
     lib/debug/rs_debug.h \
+    lib/debug/lc_trace.h \
     lib/engine/rs.h \
     lib/engine/rs_arc.h \
     lib/engine/rs_atomicentity.h \
@@ -148,6 +152,10 @@ HEADERS += \
     lib/engine/rs_ellipse.h \
     lib/engine/rs_entity.h \
     lib/engine/rs_entitycontainer.h \
+    lib/engine/lc_spatialindex.h \
+    lib/engine/lc_undodelta.h \
+    lib/engine/lc_endpointindex.h \
+    lib/engine/lc_layerindex.h \
     lib/engine/rs_flags.h \
     lib/engine/rs_font.h \
     lib/engine/rs_fontchar.h \
@@ -211,6 +219,7 @@ HEADERS += \
     lib/modification/rs_selection.h \
     lib/math/rs_math.h \
     lib/math/lc_quadratic.h \
+    lib/math/lc_clipping.h \
     lib/scripting/rs_python.h \
     lib/scripting/rs_simplepython.h \
     lib/scripting/rs_python_wrappers.h \
@@ -236,6 +245,7 @@ SOURCES += \
     lib/actions/rs_snapper.cpp \
     lib/creation/rs_creation.cpp \
     lib/debug/rs_debug.cpp \
+    lib/debug/lc_trace.cpp \
     lib/engine/rs_arc.cpp \
     lib/engine/rs_block.cpp \
     lib/engine/rs_blocklist.cpp \
@@ -252,6 +262,10 @@ SOURCES += \
     lib/engine/rs_ellipse.cpp \
     lib/engine/rs_entity.cpp \
     lib/engine/rs_entitycontainer.cpp \
+    lib/engine/lc_spatialindex.cpp \
+    lib/engine/lc_undodelta.cpp \
+    lib/engine/lc_endpointindex.cpp \
+    lib/engine/lc_layerindex.cpp \
     lib/engine/rs_font.cpp \
     lib/engine/rs_fontlist.cpp \
     lib/engine/rs_graphic.cpp \
@@ -301,6 +315,7 @@ SOURCES += \
     lib/information/rs_infoarea.cpp \
     lib/math/rs_math.cpp \
     lib/math/lc_quadratic.cpp \
+    lib/math/lc_clipping.cpp \
     lib/modification/rs_modification.cpp \
     lib/modification/rs_selection.cpp \
     lib/scripting/rs_python.cpp \
@@ -876,6 +891,7 @@ HEADERS += \
     main/qc_mdiwindow.h \
     main/helpbrowser.h \
     main/doc_plugin_interface.h \
+    main/lc_batchconverter.h \
     plugins/document_interface.h \
     plugins/qc_plugininterface.h \
     plugins/intern/qc_actiongetpoint.h \
@@ -890,6 +906,7 @@ SOURCES += \
     main/qc_mdiwindow.cpp \
     main/helpbrowser.cpp \
     main/doc_plugin_interface.cpp \
+    main/lc_batchconverter.cpp \
     plugins/intern/qc_actiongetpoint.cpp \
     plugins/intern/qc_actiongetselect.cpp \
     plugins/intern/qc_actiongetent.cpp \
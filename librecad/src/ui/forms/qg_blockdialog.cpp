@@ -40,6 +40,8 @@ QG_BlockDialog::QG_BlockDialog(QWidget* parent, bool modal, Qt::WindowFlags fl)
 {
     setModal(modal);
     setupUi(this);
+    blockList = nullptr;
+    editBlock = false;
 }
 
 /*
@@ -63,6 +65,10 @@ void QG_BlockDialog::setBlockList(RS_BlockList* l) {
     }
 }
 
+void QG_BlockDialog::setEditBlock(bool eb) {
+    editBlock = eb;
+}
+
 RS_BlockData QG_BlockDialog::getBlockData() {
     return RS_BlockData(leName->text(), RS_Vector(0.0,0.0), false);
 }
@@ -70,8 +76,10 @@ RS_BlockData QG_BlockDialog::getBlockData() {
 void QG_BlockDialog::validate() {
     QString name = leName->text();
 
-    if (!name.isEmpty()) {
-		if (blockList && blockList->find(name)==nullptr) {
+    if (!name.isEmpty() && blockList) {
+        RS_Block* b = blockList->find(name);
+        // renaming a block by changing the case only is allowed:
+        if (b==nullptr || (editBlock && b==blockList->getActive())) {
             accept();
         } else {
             QMessageBox::warning( this, tr("Renaming Block"),
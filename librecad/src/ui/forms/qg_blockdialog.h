@@ -43,11 +43,14 @@ public:
 
 public slots:
     virtual void setBlockList( RS_BlockList * l );
+    virtual void setEditBlock( bool eb );
     virtual void validate();
     virtual void cancel();
 
 protected:
     RS_BlockList* blockList;
+    //! true: the active block is renamed, false: a new block is named
+    bool editBlock;
 
 protected slots:
     virtual void languageChange();
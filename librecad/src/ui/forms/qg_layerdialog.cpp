@@ -80,7 +80,8 @@ void QG_LayerDialog::validate() {
 	if (layerList &&
                 (editLayer == false || layerName != leName->text())) {
                 RS_Layer* l = layerList->find(leName->text());
-		if (l) {
+		// renaming a layer by changing the case only is allowed:
+		if (l && (editLayer == false || l != layerList->find(layerName))) {
 			QMessageBox::information(parentWidget(),
 									 QMessageBox::tr("Layer Properties"),
 									 QMessageBox::tr("Layer with a name \"%1\" "
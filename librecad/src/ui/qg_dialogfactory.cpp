@@ -400,6 +400,7 @@ RS_BlockData QG_DialogFactory::requestBlockAttributesDialog(RS_BlockList* blockL
 
     QG_BlockDialog dlg(parent, "Rename Block");
     dlg.setBlockList(blockList);
+    dlg.setEditBlock(true);
     if (dlg.exec()) {
         //dlg.updateBlock();
         //block->setData();
@@ -26,9 +26,12 @@
 
 #include "qg_graphicview.h"
 
+#include <algorithm>
+#include <atomic>
 #include <QGridLayout>
 #include <QLabel>
 #include <QDebug>
+#include <QApplication>
 #if QT_VERSION >= 0x050200
 #include <QNativeGestureEvent>
 #endif
@@ -48,6 +51,10 @@
 
 #include "qg_scrollbar.h"
 #include "rs_modification.h"
+#include "rs_graphic.h"
+#include "rs_units.h"
+#include "rs_staticgraphicview.h"
+#include "lc_trace.h"
 
 #define QG_SCROLLMARGIN 400
 
@@ -57,6 +64,21 @@
 #define CURSOR_SIZE 15
 #endif
 
+/**
+ * Tiles drawn on the render threads, in bands of tile rows.
+ */
+struct QG_GraphicView::TileJob {
+    int col1;
+    //! first tile row of each band, and the row after the last band
+    std::vector<int> bandRows;
+    RS_Vector factor;
+    std::vector<QImage> images;
+    std::vector<char> done;
+    std::atomic_int completed{0};
+    //! set when the tiles are outdated, the bands stop and are dropped
+    std::atomic_bool cancelled{false};
+};
+
 /**
  * Constructor.
  */
@@ -73,6 +95,8 @@ QG_GraphicView::QG_GraphicView(QWidget* parent, const char* name, Qt::WindowFlag
         ,curMagnifier(new QCursor(QPixmap(":ui/cur_glass_bmp.png"), CURSOR_SIZE, CURSOR_SIZE))
         ,curHand(new QCursor(QPixmap(":ui/cur_hand_bmp.png"), CURSOR_SIZE, CURSOR_SIZE))
         ,redrawMethod(RS2::RedrawAll)
+        ,tiles(128)
+        ,tileSettings()
         ,isSmoothScrolling(false)
 {
     setObjectName(name);
@@ -128,6 +152,12 @@ QG_GraphicView::QG_GraphicView(QWidget* parent, const char* name, Qt::WindowFlag
  * Destructor
  */
 QG_GraphicView::~QG_GraphicView() {
+    // the bands draw the container, which may be deleted by cleanUp()
+    if (tileJob) {
+        tileJob->cancelled = true;
+        renderPool.waitForDone();
+        qApp->removeEventFilter(this);
+    }
 	cleanUp();
 }
 
@@ -519,7 +549,7 @@ void QG_GraphicView::wheelEvent(QWheelEvent *e) {
 //                setCurrentAction(new RS_ActionZoomScroll(numPixels.x(), numPixels.y(),
 //                                                         *container, *this));
             }
-            redraw();
+            redraw(RS2::RedrawView);
         }
         e->accept();
         return;
@@ -589,7 +619,7 @@ void QG_GraphicView::wheelEvent(QWheelEvent *e) {
         }
     }
 
-        redraw();
+        redraw(RS2::RedrawView);
 
     e->accept();
 }
@@ -756,7 +786,7 @@ void QG_GraphicView::slotHScrolled(int value) {
     }
     //if (isUpdateEnabled()) {
 //         updateGrid();
-    redraw();
+    redraw(RS2::RedrawView);
 }
 
 
@@ -779,7 +809,7 @@ void QG_GraphicView::slotVScrolled(int value) {
     }
     //if (isUpdateEnabled()) {
   //  updateGrid();
-    redraw();
+    redraw(RS2::RedrawView);
 }
 /**
  * @brief setOffset
@@ -842,7 +872,7 @@ void QG_GraphicView::layerActivated(RS_Layer *layer) {
  * have from the last call..
  */
 void QG_GraphicView::paintEvent(QPaintEvent *) {
-    RS_DEBUG->print("QG_GraphicView::paintEvent begin");
+    LC_TRACE_SCOPE("render", "QG_GraphicView::paintEvent");
 
         RS_SETTINGS->beginGroup("/Appearance");
     bool draftMode = (bool)RS_SETTINGS->readNumEntry("/DraftMode", 0);
@@ -866,20 +896,21 @@ void QG_GraphicView::paintEvent(QPaintEvent *) {
         }
 
 
-        if (redrawMethod & RS2::RedrawDrawing) {
-                // DRaw layer 2
-                PixmapLayer2->fill(Qt::transparent);
-				RS_PainterQt painter2(PixmapLayer2.get());
-				if (antialiasing)
-				{
-					painter2.setRenderHint(QPainter::Antialiasing);
-				}
-                painter2.setDrawingMode(drawingMode);
+        if (redrawMethod & (RS2::RedrawDrawing | RS2::RedrawDrawingCached)) {
+                // Draw layer 2 from the tiles
                 setDraftMode(draftMode);
-        painter2.setDrawSelectedOnly(false);
-        drawLayer2((RS_Painter*)&painter2);
-        painter2.setDrawSelectedOnly(true);
-        drawLayer2((RS_Painter*)&painter2);
+                TileSettings const settings = {container, draftMode, antialiasing,
+                                               drawingMode, background.rgba(),
+                                               isPrintPreview()};
+                if ((redrawMethod & RS2::RedrawDrawing) || settings != tileSettings) {
+                    if (tileJob)
+                        tileJob->cancelled = true;
+                    tiles.clear();
+                    tileSettings = settings;
+                }
+                PixmapLayer2->fill(Qt::transparent);
+                RS_PainterQt painter2(PixmapLayer2.get());
+                drawLayer2Tiled(painter2);
         //removed to solve bug #3470573
 //        setDraftMode(false);
                 painter2.end();
@@ -902,7 +933,280 @@ void QG_GraphicView::paintEvent(QPaintEvent *) {
         wPainter.end();
 
         redrawMethod=RS2::RedrawNone;
-    RS_DEBUG->print("QG_GraphicView::paintEvent end");
+}
+
+namespace {
+//! floor(a/b) for b>0
+int floorDiv(int a, int b) {
+    return a>=0 ? a/b : -((b-1-a)/b);
+}
+
+/**
+ * Draws the drawing layer of a view into an image on a render thread.
+ * Entity draw() methods must not modify the entities for this.
+ * done is set if the band was drawn completely, i.e. not cancelled.
+ * The last of the bands calls the mergeTiles() slot of receiver.
+ */
+class TileBandRenderer: public QRunnable {
+public:
+    TileBandRenderer(RS_GraphicView* view, QImage* image, bool antialiasing,
+                     char* done, std::atomic_int* completed, int bands,
+                     QObject* receiver)
+        : view(view), image(image), antialiasing(antialiasing)
+        , done(done), completed(completed), bands(bands)
+        , receiver(receiver) {}
+
+    void run() {
+        LC_TRACE_SCOPE("render", "TileBandRenderer::run");
+        RS_PainterQt painter(image);
+        if (antialiasing)
+        {
+            painter.setRenderHint(QPainter::Antialiasing);
+        }
+        painter.setDrawingMode(view->getDrawingMode());
+        painter.setDrawSelectedOnly(false);
+        view->drawLayer2((RS_Painter*)&painter);
+        painter.setDrawSelectedOnly(true);
+        view->drawLayer2((RS_Painter*)&painter);
+        painter.end();
+        *done = !view->isDrawingCancelled();
+        if (++*completed == bands)
+            QMetaObject::invokeMethod(receiver, "mergeTiles", Qt::QueuedConnection);
+    }
+
+private:
+    RS_GraphicView* view;
+    QImage* image;
+    bool antialiasing;
+    char* done;
+    std::atomic_int* completed;
+    int bands;
+    QObject* receiver;
+};
+}
+
+/**
+ * Composes the drawing layer from the tiles covering the view. Missing
+ * tiles are drawn on the render threads and shown by the paint event
+ * after they are done.
+ */
+void QG_GraphicView::drawLayer2Tiled(RS_PainterQt& painter) {
+    int const w = getWidth();
+    int const h = getHeight();
+    // screen position of the corner of tile (0, 0):
+    int const x0 = getOffsetX();
+    int const y0 = h - getOffsetY();
+    int const col1 = floorDiv(-x0, tileSize);
+    int const col2 = floorDiv(w - 1 - x0, tileSize);
+    int const row1 = floorDiv(-y0, tileSize);
+    int const row2 = floorDiv(h - 1 - y0, tileSize);
+
+    RS_Vector const f = getFactor();
+    int const visible = (col2 - col1 + 1) * (row2 - row1 + 1);
+    if (tiles.maxCost() < 2 * visible)
+        tiles.setMaxCost(2 * visible);
+
+    // bounding range of the missing tiles, drawn in one pass:
+    int mCol1 = col2 + 1, mCol2 = col1 - 1, mRow1 = row2 + 1, mRow2 = row1 - 1;
+    for (int r = row1; r <= row2; ++r) {
+        for (int c = col1; c <= col2; ++c) {
+            if (!tiles.contains({f.x, f.y, c, r})) {
+                mCol1 = std::min(mCol1, c);
+                mCol2 = std::max(mCol2, c);
+                mRow1 = std::min(mRow1, r);
+                mRow2 = std::max(mRow2, r);
+            }
+        }
+    }
+    if (mCol1 <= mCol2 && !tileJob)
+        drawTiles(mCol1, mRow1, mCol2, mRow2);
+
+    for (int r = row1; r <= row2; ++r) {
+        for (int c = col1; c <= col2; ++c) {
+            QPixmap const* tile = tiles.object({f.x, f.y, c, r});
+            if (tile)
+                painter.drawPixmap(x0 + c * tileSize, y0 + r * tileSize, *tile);
+        }
+    }
+}
+
+/**
+ * Starts drawing the given range of tiles, in bands of tile rows on the
+ * render threads. The tiles are added to the tile cache by mergeTiles().
+ */
+void QG_GraphicView::drawTiles(int col1, int row1, int col2, int row2) {
+    LC_TRACE_SCOPE("render", "QG_GraphicView::drawTiles");
+    LC_TRACE_COUNT("render", "tiles drawn", (row2 - row1 + 1) * (col2 - col1 + 1));
+    int const rows = row2 - row1 + 1;
+    int const bands = std::max(1, std::min(rows, renderPool.maxThreadCount()));
+    int const w = (col2 - col1 + 1) * tileSize;
+    while (renderViews.size() < static_cast<size_t>(bands))
+        renderViews.emplace_back(new RS_StaticGraphicView(w, tileSize, nullptr));
+
+    tileJob.reset(new TileJob);
+    TileJob& job = *tileJob;
+    job.col1 = col1;
+    job.factor = getFactor();
+    job.bandRows.resize(bands + 1);
+    for (int i = 0; i <= bands; ++i)
+        job.bandRows[i] = row1 + rows * i / bands;
+    job.images.resize(bands);
+    job.done.assign(bands, 0);
+
+    for (int i = 0; i < bands; ++i) {
+        int const h = (job.bandRows[i + 1] - job.bandRows[i]) * tileSize;
+        RS_StaticGraphicView* view = renderViews[i].get();
+        view->copyDrawingState(*this);
+        view->setSize(w, h);
+        // map the corner of the first tile of the band to (0, 0):
+        view->setOffset(-col1 * tileSize, h + job.bandRows[i] * tileSize);
+        job.images[i] = QImage(w, h, QImage::Format_ARGB32_Premultiplied);
+        job.images[i].fill(0);
+        view->setCancelFlag(&job.cancelled);
+        renderPool.start(new TileBandRenderer(view, &job.images[i], antialiasing,
+                                              &job.done[i], &job.completed,
+                                              bands, this));
+    }
+    // the event loop goes on while the bands are drawn, but the entity tree
+    // must not change meanwhile:
+    qApp->installEventFilter(this);
+}
+
+/**
+ * Adds the tiles of the bands to the tile cache once all bands are done
+ * and shows them. Tiles outdated meanwhile are dropped.
+ */
+void QG_GraphicView::mergeTiles() {
+    if (!tileJob || tileJob->completed < static_cast<int>(tileJob->done.size()))
+        return;
+    // the last band may still be returning from run():
+    renderPool.waitForDone();
+    std::unique_ptr<TileJob> job = std::move(tileJob);
+    qApp->removeEventFilter(this);
+    for (auto& view: renderViews)
+        view->setCancelFlag(nullptr);
+
+    int const bands = job->done.size();
+    for (int i = 0; i < bands && !job->cancelled; ++i) {
+        for (int r = job->bandRows[i]; r < job->bandRows[i + 1]; ++r) {
+            int const c2 = job->col1 + job->images[i].width() / tileSize;
+            for (int c = job->col1; c < c2; ++c) {
+                TileKey const key{job->factor.x, job->factor.y, c, r};
+                if (!tiles.contains(key))
+                    tiles.insert(key, new QPixmap(QPixmap::fromImage(
+                                     job->images[i].copy((c - job->col1) * tileSize,
+                                                         (r - job->bandRows[i]) * tileSize,
+                                                         tileSize, tileSize))));
+            }
+        }
+    }
+    if (job->cancelled)
+        LC_TRACE_COUNT("render", "bands cancelled", bands);
+    // shows the tiles and draws those still missing:
+    redraw(RS2::RedrawDrawingCached);
+}
+
+/**
+ * Waits for the bands still drawn and adds their tiles.
+ */
+void QG_GraphicView::finishTiles() {
+    if (!tileJob)
+        return;
+    LC_TRACE_SCOPE("render", "QG_GraphicView::finishTiles");
+    renderPool.waitForDone();
+    mergeTiles();
+}
+
+/**
+ * Installed on the application while tiles are drawn. Input which may
+ * modify the entity tree, by an action, a dialog or snapping to the
+ * mouse position, waits for the bands first.
+ */
+bool QG_GraphicView::eventFilter(QObject* obj, QEvent* e) {
+    switch (e->type()) {
+    case QEvent::MouseMove:
+    case QEvent::TabletMove:
+        // only the graphic views snap to the mouse position:
+        if (qobject_cast<QG_GraphicView*>(obj))
+            finishTiles();
+        break;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::TabletPress:
+    case QEvent::TabletRelease:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::ShortcutOverride:
+    case QEvent::Drop:
+    case QEvent::Close:
+        finishTiles();
+        break;
+    default:
+        break;
+    }
+    return QWidget::eventFilter(obj, e);
+}
+
+/**
+ * Drops the cached tiles of all zoom levels which intersect the window
+ * vMin, vMax extended by margin pixels.
+ */
+void QG_GraphicView::invalidateTiles(const RS_Vector& vMin, const RS_Vector& vMax, double margin) {
+    for (TileKey const& key: tiles.keys()) {
+        double const dx = margin / key.factorX;
+        double const dy = margin / key.factorY;
+        // world coordinates of the tile:
+        double const x1 = key.col * tileSize / key.factorX;
+        double const x2 = (key.col + 1) * tileSize / key.factorX;
+        double const y1 = -(key.row + 1) * tileSize / key.factorY;
+        double const y2 = -key.row * tileSize / key.factorY;
+        if (x2 >= vMin.x - dx && x1 <= vMax.x + dx
+                && y2 >= vMin.y - dy && y1 <= vMax.y + dy)
+            tiles.remove(key);
+    }
+}
+
+/**
+ * Drops the tiles covered by the entity, including its reference points
+ * and its line width. Entities modified in place may have been drawn
+ * elsewhere, the tiles covered by their previous borders are dropped too.
+ */
+void QG_GraphicView::invalidateEntity(RS_Entity const* e) {
+    RS_Vector vOldMin, vOldMax;
+    RS_Document* doc = container ? container->getDocument() : nullptr;
+    bool const modified = doc && doc->takeModifiedRegion(vOldMin, vOldMax);
+    // tiles still drawn show the entity before the change:
+    finishTiles();
+    if (tiles.isEmpty())
+        return;
+    RS_Vector vMin = e->getMin();
+    RS_Vector vMax = e->getMax();
+    if (!vMin.valid || !vMax.valid || e->rtti()==RS2::EntityConstructionLine
+            || (modified && !vOldMin.valid)) {
+        tiles.clear();
+        return;
+    }
+    for (RS_Vector const& vp: e->getRefPoints()) {
+        if (vp.valid) {
+            vMin = RS_Vector::minimum(vMin, vp);
+            vMax = RS_Vector::maximum(vMax, vp);
+        }
+    }
+
+    // selection handles and points are drawn in pixels around the entity
+    double margin = 8.;
+    int const width = e->getPen(true).getWidth();
+    if (width > 0) {
+        RS_Graphic* graphic = container ? container->getGraphic() : nullptr;
+        double const uf = graphic ? RS_Units::convert(1.0, RS2::Millimeter, graphic->getUnit()) : 1.;
+        margin += toGuiDX(width / 100.0 * uf);
+    }
+    invalidateTiles(vMin, vMax, margin);
+    if (modified) {
+        invalidateTiles(vOldMin, vOldMax, margin);
+    }
 }
 
 void QG_GraphicView::set_antialiasing(bool state)
@@ -28,6 +28,8 @@
 #define QG_GRAPHICVIEW_H
 
 #include <QWidget>
+#include <QCache>
+#include <QThreadPool>
 
 #include "rs_graphicview.h"
 #include "rs_layerlistlistener.h"
@@ -36,6 +38,8 @@
 class QGridLayout;
 class QLabel;
 class QG_ScrollBar;
+class RS_PainterQt;
+class RS_StaticGraphicView;
 
 /**
  * This is the Qt implementation of a widget which can view a 
@@ -64,6 +68,7 @@ public:
         virtual void updateGridStatusWidget(const QString& text);
 
 	virtual	void getPixmapForView(std::unique_ptr<QPixmap>& pm);
+	virtual void invalidateEntity(RS_Entity const* e);
 		
     // Methods from RS_LayerListListener Interface:
     virtual void layerEdited(RS_Layer*) {
@@ -109,11 +114,17 @@ protected:
     virtual bool event(QEvent * e);
 
     void paintEvent(QPaintEvent *);
+    void drawLayer2Tiled(RS_PainterQt& painter);
+    void drawTiles(int col1, int row1, int col2, int row2);
+    void finishTiles();
+    virtual bool eventFilter(QObject* obj, QEvent* e);
+    void invalidateTiles(const RS_Vector& vMin, const RS_Vector& vMax, double margin);
     virtual void resizeEvent(QResizeEvent* e);
 
 private slots:
     void slotHScrolled(int value);
     void slotVScrolled(int value);
+    void mergeTiles();
 
 protected:
     //! Horizontal scrollbar.
@@ -141,6 +152,54 @@ protected:
 	std::unique_ptr<QPixmap> PixmapLayer3;  // USed for crosshair and actionitems
 	
 	RS2::RedrawMethod redrawMethod;
+
+	/**
+	 * The drawing layer is cached in square tiles aligned to the world
+	 * coordinates (x*factor.x, -y*factor.y). Tiles of a zoom level stay
+	 * valid when panning, only the tiles entering the view are drawn.
+	 */
+	struct TileKey {
+		double factorX;
+		double factorY;
+		int col;
+		int row;
+		bool operator == (const TileKey& other) const {
+			return col==other.col && row==other.row
+					&& factorX==other.factorX && factorY==other.factorY;
+		}
+		friend uint qHash(const TileKey& key) {
+			return qHash(key.col) ^ (qHash(key.row) << 16);
+		}
+	};
+	//! Settings which affect the drawing, tiles drawn with others are dropped.
+	struct TileSettings {
+		RS_EntityContainer* container;
+		bool draftMode;
+		bool antialiasing;
+		RS2::DrawingMode drawingMode;
+		QRgb background;
+		bool printPreview;
+		bool operator != (const TileSettings& other) const {
+			return container!=other.container || draftMode!=other.draftMode
+					|| antialiasing!=other.antialiasing
+					|| drawingMode!=other.drawingMode
+					|| background!=other.background
+					|| printPreview!=other.printPreview;
+		}
+	};
+	static const int tileSize = 256;
+	QCache<TileKey, QPixmap> tiles;
+	TileSettings tileSettings;
+	/**
+	 * Missing tiles are drawn in bands of tile rows on renderPool, each
+	 * band through its own view. Paint events don't wait for the bands,
+	 * their tiles are shown once all are done. The entity tree is read
+	 * only meanwhile, input waits for the bands, see eventFilter().
+	 */
+	struct TileJob;
+	QThreadPool renderPool;
+	std::vector<std::unique_ptr<RS_StaticGraphicView>> renderViews;
+	std::unique_ptr<TileJob> tileJob;
 		
     //! Keep tracks of if we are currently doing a high-resolution scrolling
     bool isSmoothScrolling;
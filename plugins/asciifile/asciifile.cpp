@@ -379,6 +379,7 @@ void dibPunto::procesFile(Document_Interface *doc)
         procesfileNormal(&infile, sep, skip);
     infile.close ();
     QString currlay = currDoc->getCurrentLayer();
+    currDoc->beginBatch();
 
     if (pt2d->checkOn() == true)
         draw2D();
@@ -395,6 +396,7 @@ void dibPunto::procesFile(Document_Interface *doc)
     /* draw lines in current layer */
     if ( connectPoints->isChecked() )
         drawLine();
+    currDoc->commitBatch();
 
     currDoc = NULL;
 
@@ -402,55 +404,33 @@ void dibPunto::procesFile(Document_Interface *doc)
 
 void dibPunto::drawLine()
 {
-    QPointF prevP, nextP;
-    int i;
-
-    for (i = 0; i < dataList.size(); ++i) {
-        pointData *pd = dataList.at(i);
-        if (!pd->x.isEmpty() && !pd->y.isEmpty()){
-            prevP.setX(pd->x.toDouble());
-            prevP.setY(pd->y.toDouble());
-            break;
-        }
-    }
-    for (; i < dataList.size(); ++i) {
-        pointData *pd = dataList.at(i);
-        if (!pd->x.isEmpty() && !pd->y.isEmpty()){
-            nextP.setX(pd->x.toDouble());
-            nextP.setY(pd->y.toDouble());
-            currDoc->addLine(&prevP, &nextP);
-            prevP = nextP;
-        }
-    }
+    std::vector<QPointF> points = dataPoints();
+    if (points.size() > 1)
+        currDoc->addLines(points);
 }
 
 void dibPunto::draw2D()
 {
-    QPointF pt;
     currDoc->setLayer(pt2d->getLayer());
-    for (int i = 0; i < dataList.size(); ++i) {
-        pointData *pd = dataList.at(i);
-        if (!pd->x.isEmpty() && !pd->y.isEmpty()){
-            pt.setX(pd->x.toDouble());
-            pt.setY(pd->y.toDouble());
-            currDoc->addPoint(&pt);
-        }
-    }
+    currDoc->addPoints(dataPoints());
 }
 void dibPunto::draw3D()
 {
-    QPointF pt;
     currDoc->setLayer(pt3d->getLayer());
+/*RLZ:3d support, z of the points is ignored*/
+    currDoc->addPoints(dataPoints());
+}
+
+std::vector<QPointF> dibPunto::dataPoints() const
+{
+    std::vector<QPointF> points;
+    points.reserve(dataList.size());
     for (int i = 0; i < dataList.size(); ++i) {
         pointData *pd = dataList.at(i);
-        if (!pd->x.isEmpty() && !pd->y.isEmpty()){
-            pt.setX(pd->x.toDouble());
-            pt.setY(pd->y.toDouble());
-/*RLZ:3d support            if (pd->z.isEmpty()) pt.setZ(0.0);
-            else  pt.setZ(pd->z.toDouble());*/
-            currDoc->addPoint(&pt);
-        }
+        if (!pd->x.isEmpty() && !pd->y.isEmpty())
+            points.push_back(QPointF(pd->x.toDouble(), pd->y.toDouble()));
     }
+    return points;
 }
 
 void dibPunto::calcPos(DPI::VAlign *v, DPI::HAlign *h, double sep,
@@ -68,6 +68,7 @@ private:
     void procesfileODB(QFile* file, QString sep);
     void procesfileNormal(QFile* file, QString sep, QString::SplitBehavior skip = QString::KeepEmptyParts);
     void drawLine();
+    std::vector<QPointF> dataPoints() const;
     void draw2D();
     void draw3D();
     void drawNumber();
@@ -326,6 +326,7 @@ void dibSHP::procesFile(Document_Interface *doc)
     }
 
     currlayer =currDoc->getCurrentLayer();
+    currDoc->beginBatch();
     for( int i = 0; i < num_ent; i++ ) {
         sobject= NULL;
         sobject = SHPReadObject( sh, i );
@@ -360,6 +361,8 @@ void dibSHP::procesFile(Document_Interface *doc)
         }
     }
 
+    currDoc->commitBatch();
+
     SHPClose( sh );
     DBFClose( dh );
     currDoc->setLayer(currlayer);
@@ -5,12 +5,93 @@
 
 
 
+#include <cmath>
+#include <climits>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
 #include "document_interface.h"
 #include "plot.h"
 #include "plotdialog.h"
 #include <muParser.h>
 #include <QDebug>
 
+namespace {
+//chunks smaller than this are not worth a thread
+const int minChunkSize = 16384;
+
+void defineParser(mu::Parser& p, double* variable)
+{
+    p.DefineConst("pi",M_PI);
+    p.DefineConst("e",M_E);
+    p.DefineVar("x", variable);
+    p.DefineVar("t", variable);
+}
+
+/*evaluates one chunk in muParser bulk mode, the variable of the
+  expression is the chunk of the array of variable values*/
+class BulkEvaluator: public QRunnable {
+public:
+    BulkEvaluator(std::string const& expr, double* variables, double* results, int size)
+        : expr(expr), variables(variables), results(results), size(size) {}
+
+    void run() {
+        try{
+            mu::Parser p;
+            defineParser(p, variables);
+            p.SetExpr(expr);
+            p.Eval(results, size);
+        }
+        catch (mu::Parser::exception_type &e)
+        {
+            error = e.GetMsg();
+        }
+    }
+
+    std::string error;
+
+private:
+    std::string expr;
+    double* variables;
+    double* results;
+    int size;
+};
+
+/*evaluates expr for every value of variables, split in chunks over
+  the ideal number of threads*/
+void evaluate(std::string const& expr, std::vector<double>& variables,
+              std::vector<double>& results)
+{
+    int const size = variables.size();
+    results.resize(size);
+    int const chunks = std::max(1, std::min(QThread::idealThreadCount(),
+                                            size / minChunkSize));
+    int const chunkSize = (size + chunks - 1) / chunks;
+    std::vector<BulkEvaluator*> evaluators;
+    QThreadPool pool;
+    for (int i = 0; i < size; i += chunkSize) {
+        BulkEvaluator* evaluator = new BulkEvaluator(expr, &variables[i], &results[i],
+                                                     std::min(chunkSize, size - i));
+        evaluator->setAutoDelete(false);
+        evaluators.push_back(evaluator);
+        if (chunks > 1)
+            pool.start(evaluator);
+        else
+            evaluator->run();
+    }
+    pool.waitForDone();
+
+    std::string error;
+    for (BulkEvaluator* evaluator: evaluators) {
+        if (error.empty())
+            error = evaluator->error;
+        delete evaluator;
+    }
+    if (!error.empty())
+        throw mu::Parser::exception_type(error);
+}
+}
+
 plot::plot(QObject *parent) :
     QObject(parent)
 {
@@ -40,9 +121,9 @@ void plot::execComm(Document_Interface *doc, QWidget *parent, QString cmd)
     QString endValue;
     double stepSize;
 
-    QList<double> xValues;
-    QList<double> yValues1;
-    QList<double> yValues2;
+    std::vector<double> xValues;
+    std::vector<double> yValues1;
+    std::vector<double> yValues2;
     plotDialog::EntityType lineType=plotDialog::Polyline;
 
     plotDialog plotDlg(parent);
@@ -57,45 +138,54 @@ void plot::execComm(Document_Interface *doc, QWidget *parent, QString cmd)
 
         try{
             mu::Parser p;
-            p.DefineConst("pi",M_PI);
-            p.DefineConst("e",M_E);
-            p.DefineVar("x", &equationVariable);
-            p.DefineVar("t", &equationVariable);
+            defineParser(p, &equationVariable);
             p.SetExpr(startValue.toStdString());
             startVal = p.Eval();
 
             p.SetExpr(endValue.toStdString());
             endVal = p.Eval();
 
-            p.SetExpr(equation1.toStdString());
+            //end value is not used!
+            double const count = (stepSize > 0.0 && endVal > startVal)?
+                        std::ceil((endVal - startVal)/stepSize):0.0;
+            if (count > INT_MAX)
+                throw mu::Parser::exception_type("too many steps");
+            xValues.resize(static_cast<size_t>(count));
+            for(size_t i = 0; i < xValues.size(); ++i)
+                xValues[i] = startVal + i*stepSize;
 
-            for(equationVariable = startVal; equationVariable < endVal; equationVariable += stepSize)//end value is not used!
-            {//calculate the values of the first equation
-                xValues.append(equationVariable);
-                yValues1.append(p.Eval());
+            //report syntax errors before the bulk evaluation
+            p.SetExpr(equation1.toStdString());
+            p.Eval();
+            if(!equation2.isEmpty())
+            {
+                p.SetExpr(equation2.toStdString());
+                p.Eval();
             }
 
+            //calculate the values of the first equation
+            evaluate(equation1.toStdString(), xValues, yValues1);
+
             if(!equation2.isEmpty())
             {//calculate the values of the second equation
-                p.SetExpr(equation2.toStdString());
-                for(int i = 0; i < xValues.size(); ++i)
-                {
-                    equationVariable = xValues.at(i);
-                    yValues2.append(p.Eval());
-                }
+                evaluate(equation2.toStdString(), xValues, yValues2);
             }
         }
         catch (mu::Parser::exception_type &e)
         {
             std::cout << e.GetMsg() << std::endl;
+            return;
         }
 
-        QList<double> const& xpoints=(equation2.isEmpty())?xValues:yValues1;
-        QList<double> const& ypoints=(equation2.isEmpty())?yValues1:yValues2;
+        std::vector<double> const& xpoints=(equation2.isEmpty())?xValues:yValues1;
+        std::vector<double> const& ypoints=(equation2.isEmpty())?yValues1:yValues2;
+        if (xpoints.size() < 2)
+            return;
 
         if (lineType == plotDialog::LineSegments || lineType == plotDialog::SplinePoints){
             std::vector<QPointF> points;
-            for(int i=0; i< xpoints.size(); ++i){
+            points.reserve(xpoints.size());
+            for(size_t i=0; i< xpoints.size(); ++i){
                 points.emplace_back(QPointF(xpoints[i], ypoints[i]));
             }
             if (lineType == plotDialog::SplinePoints){
@@ -106,7 +196,8 @@ void plot::execComm(Document_Interface *doc, QWidget *parent, QString cmd)
                 doc->addLines(points, false);
         } else { //default plotDialog::Polyline
             std::vector<Plug_VertexData> points;
-            for(int i=0; i< xpoints.size(); ++i){
+            points.reserve(xpoints.size());
+            for(size_t i=0; i< xpoints.size(); ++i){
                 points.emplace_back(Plug_VertexData(QPointF(xpoints[i], ypoints[i]), 0.0));
             }
             doc->addPolyline(points, false);